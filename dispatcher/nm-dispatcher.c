@@ -55,6 +55,11 @@ typedef struct {
 	Request *current_request;
 	GQueue *requests_waiting;
 	int num_requests_pending;
+
+	/* "no-wait" scripts that are ready to run, and the number of
+	 * running ones. */
+	GQueue *nowait_scripts_waiting;
+	guint num_nowait_scripts_running;
 } Handler;
 
 typedef struct {
@@ -93,6 +98,7 @@ static void
 handler_init (Handler *h)
 {
 	h->requests_waiting = g_queue_new ();
+	h->nowait_scripts_waiting = g_queue_new ();
 	h->dbus_dispatcher = nmdbus_dispatcher_skeleton_new ();
 	g_signal_connect (h->dbus_dispatcher, "handle-action",
 	                  G_CALLBACK (handle_action), h);
@@ -104,6 +110,7 @@ handler_class_init (HandlerClass *h_class)
 }
 
 static gboolean dispatch_one_script (Request *request);
+static void nowait_scripts_run (Handler *h);
 
 typedef struct {
 	Request *request;
@@ -132,7 +139,7 @@ struct Request {
 	GPtrArray *scripts;  /* list of ScriptInfo */
 	guint idx;
 	int num_scripts_done;
-	int num_scripts_nowait;
+	int num_scripts_nowait; /* the pending "no-wait" scripts, including the queued ones. */
 };
 
 /*****************************************************************************/
@@ -345,31 +352,26 @@ complete_script (ScriptInfo *script)
 		/* this was a "no-wait" script. We either completed the request,
 		 * or there is nothing to do. Especially, there is no need to
 		 * queue the next_request() -- because no-wait scripts don't block
-		 * requests. However, if this was the last "no-wait" script and
-		 * there are "wait" scripts ready to run, launch them.
-		 */
-		if (   handler->current_request == request
-		    && handler->current_request->num_scripts_nowait == 0) {
-
-			if (dispatch_one_script (handler->current_request))
-				return;
-
-			complete_request (handler->current_request);
-		} else
-			return;
-	} else {
-		/* if the script is a "wait" script, we already tried above to
-		 * dispatch the next script. As we didn't do that, it means we
-		 * just completed the last script of @request and we can continue
-		 * with the next request...
-		 *
-		 * Also, it cannot be that there is another request currently being
-		 * processed because only requests with "wait" scripts can become
-		 * @current_request. As there can only be one "wait" script running
-		 * at any time, it means complete_request() above completed @request. */
-		nm_assert (!handler->current_request);
+		 * requests. */
+		return;
 	}
 
+	/* if the script is a "wait" script, we already tried above to
+	 * dispatch the next script. As we didn't do that, it means we
+	 * just completed the last "wait" script of @request and we can
+	 * continue with the next request...
+	 *
+	 * Also, it cannot be that there is another request currently being
+	 * processed because only requests with "wait" scripts can become
+	 * @current_request. As there can only be one "wait" script running
+	 * at any time, complete_request() above either completed @request, or
+	 * @request is still current and waits only for its "no-wait" scripts.
+	 * It gets completed when the last of them returns. next_request()
+	 * below stops it from being current. */
+	nm_assert (   !handler->current_request
+	           || (   handler->current_request == request
+	               && request->num_scripts_nowait > 0));
+
 	while (next_request (handler, NULL)) {
 		request = handler->current_request;
 
@@ -390,6 +392,8 @@ static void
 script_watch_cb (GPid pid, int status, gpointer user_data)
 {
 	ScriptInfo *script = user_data;
+	Handler *handler = script->request->handler;
+	gboolean wait = script->wait;
 	guint err;
 
 	g_assert (pid == script->pid);
@@ -428,13 +432,21 @@ script_watch_cb (GPid pid, int status, gpointer user_data)
 
 	g_spawn_close_pid (script->pid);
 
+	if (!wait)
+		handler->num_nowait_scripts_running--;
+
 	complete_script (script);
+
+	if (!wait)
+		nowait_scripts_run (handler);
 }
 
 static gboolean
 script_timeout_cb (gpointer user_data)
 {
 	ScriptInfo *script = user_data;
+	Handler *handler = script->request->handler;
+	gboolean wait = script->wait;
 
 	script->timeout_id = 0;
 	nm_clear_g_source (&script->watch_id);
@@ -456,8 +468,14 @@ again:
 
 	g_spawn_close_pid (script->pid);
 
+	if (!wait)
+		handler->num_nowait_scripts_running--;
+
 	complete_script (script);
 
+	if (!wait)
+		nowait_scripts_run (handler);
+
 	return FALSE;
 }
 
@@ -546,8 +564,6 @@ script_dispatch (ScriptInfo *script)
 	if (g_spawn_async ("/", argv, request->envp, G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, &script->pid, &error)) {
 		script->watch_id = g_child_watch_add (script->pid, (GChildWatchFunc) script_watch_cb, script);
 		script->timeout_id = g_timeout_add_seconds (SCRIPT_TIMEOUT, script_timeout_cb, script);
-		if (!script->wait)
-			request->num_scripts_nowait++;
 		return TRUE;
 	} else {
 		_LOG_S_W (script, "complete: failed to execute script: %s", error->message);
@@ -562,42 +578,183 @@ script_dispatch (ScriptInfo *script)
 static gboolean
 dispatch_one_script (Request *request)
 {
-	if (request->num_scripts_nowait > 0)
-		return TRUE;
-
+	/* only "wait" scripts. The "no-wait" scripts are started by
+	 * nowait_scripts_run(), and the "wait" scripts don't wait for them:
+	 * they may sit in the throttled queue behind the scripts of other
+	 * requests. */
 	while (request->idx < request->scripts->len) {
 		ScriptInfo *script;
 
 		script = g_ptr_array_index (request->scripts, request->idx++);
+		if (!script->wait)
+			continue;
 		if (script_dispatch (script))
 			return TRUE;
 	}
 	return FALSE;
 }
 
-static GSList *
-find_scripts (const char *str_action)
+/* A flap of many devices at once can start a large number of "no-wait"
+ * scripts. Limit how many run at the same time. The queue is in order
+ * of the requests, so the scripts for one interface are still started
+ * in the order of the events. */
+#define NOWAIT_SCRIPTS_RUNNING_MAX 16
+
+static void
+nowait_script_enqueue (ScriptInfo *script)
+{
+	nm_assert (!script->wait);
+
+	script->request->num_scripts_nowait++;
+	g_queue_push_tail (script->request->handler->nowait_scripts_waiting, script);
+}
+
+static void
+nowait_scripts_run (Handler *h)
+{
+	ScriptInfo *script;
+
+	while (   h->num_nowait_scripts_running < NOWAIT_SCRIPTS_RUNNING_MAX
+	       && (script = g_queue_pop_head (h->nowait_scripts_waiting))) {
+		if (script_dispatch (script)) {
+			h->num_nowait_scripts_running++;
+			continue;
+		}
+
+		/* the script failed to start and is already accounted as done. */
+		script->request->num_scripts_nowait--;
+		complete_script (script);
+	}
+}
+
+static gboolean
+script_must_wait (const char *path)
+{
+	gs_free char *link = NULL;
+	gs_free char *dir = NULL;
+	gs_free char *real = NULL;
+	char *tmp;
+
+	link = g_file_read_link (path, NULL);
+	if (link) {
+		if (!g_path_is_absolute (link)) {
+			dir = g_path_get_dirname (path);
+			tmp = g_build_path ("/", dir, link, NULL);
+			g_free (link);
+			g_free (dir);
+			link = tmp;
+		}
+
+		dir = g_path_get_dirname (link);
+		real = realpath (dir, NULL);
+
+		if (real && !strcmp (real, NMD_SCRIPT_DIR_NO_WAIT))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+/* Scanning the script directories on every action is expensive when
+ * many actions arrive at once. Keep the result per directory and drop
+ * it when the directory changes. "no-wait" scripts are symlinks into
+ * the no-wait.d directory, so a change there drops all lists. */
+
+typedef struct {
+	char *path;
+	bool wait;
+} ScriptEntry;
+
+typedef struct {
+	const char *dirname;
+	GFileMonitor *monitor;
+	GPtrArray *scripts; /* list of ScriptEntry, sorted by path */
+	bool monitor_failed;
+} ScriptDir;
+
+static struct {
+	ScriptDir dirs[3];
+	GFileMonitor *no_wait_monitor;
+} script_cache = {
+	.dirs = {
+		{ .dirname = NMD_SCRIPT_DIR_DEFAULT, },
+		{ .dirname = NMD_SCRIPT_DIR_PRE_UP, },
+		{ .dirname = NMD_SCRIPT_DIR_PRE_DOWN, },
+	},
+};
+
+static void
+script_entry_free (gpointer ptr)
+{
+	ScriptEntry *entry = ptr;
+
+	g_free (entry->path);
+	g_slice_free (ScriptEntry, entry);
+}
+
+static int
+script_entry_cmp (gconstpointer a, gconstpointer b)
+{
+	const ScriptEntry *entry_a = *((const ScriptEntry *const*) a);
+	const ScriptEntry *entry_b = *((const ScriptEntry *const*) b);
+
+	return strcmp (entry_a->path, entry_b->path);
+}
+
+static void
+script_dir_changed_cb (GFileMonitor *monitor,
+                       GFile *file,
+                       GFile *other_file,
+                       GFileMonitorEvent event_type,
+                       gpointer user_data)
+{
+	ScriptDir *script_dir = user_data;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (script_cache.dirs); i++) {
+		if (   !script_dir
+		    || script_dir == &script_cache.dirs[i])
+			g_clear_pointer (&script_cache.dirs[i].scripts, g_ptr_array_unref);
+	}
+}
+
+static GFileMonitor *
+script_dir_monitor_new (const char *dirname, ScriptDir *script_dir)
+{
+	gs_unref_object GFile *file = NULL;
+	GFileMonitor *monitor;
+	GError *error = NULL;
+
+	file = g_file_new_for_path (dirname);
+	monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, &error);
+	if (!monitor) {
+		g_message ("find-scripts: Failed to monitor dispatcher directory '%s': %s",
+		           dirname, error->message);
+		g_error_free (error);
+		return NULL;
+	}
+	g_signal_connect (monitor, "changed",
+	                  G_CALLBACK (script_dir_changed_cb), script_dir);
+	return monitor;
+}
+
+static GPtrArray *
+script_dir_scan (const char *dirname)
 {
 	GDir *dir;
 	const char *filename;
-	GSList *sorted = NULL;
+	GPtrArray *scripts;
 	GError *error = NULL;
-	const char *dirname;
 
-	if (   strcmp (str_action, NMD_ACTION_PRE_UP) == 0
-	    || strcmp (str_action, NMD_ACTION_VPN_PRE_UP) == 0)
-		dirname = NMD_SCRIPT_DIR_PRE_UP;
-	else if (   strcmp (str_action, NMD_ACTION_PRE_DOWN) == 0
-	         || strcmp (str_action, NMD_ACTION_VPN_PRE_DOWN) == 0)
-		dirname = NMD_SCRIPT_DIR_PRE_DOWN;
-	else
-		dirname = NMD_SCRIPT_DIR_DEFAULT;
+	scripts = g_ptr_array_new_with_free_func (script_entry_free);
 
 	if (!(dir = g_dir_open (dirname, 0, &error))) {
 		g_message ("find-scripts: Failed to open dispatcher directory '%s': %s",
 		           dirname, error->message);
 		g_error_free (error);
-		return NULL;
+		return scripts;
 	}
 
 	while ((filename = g_dir_read_name (dir))) {
@@ -619,43 +776,84 @@ find_scripts (const char *str_action)
 		else if (!check_permissions (&st, &err_msg))
 			g_warning ("find-scripts: Cannot execute '%s': %s", path, err_msg);
 		else {
+			ScriptEntry *entry;
+
 			/* success */
-			sorted = g_slist_insert_sorted (sorted, path, (GCompareFunc) g_strcmp0);
-			path = NULL;
+			entry = g_slice_new (ScriptEntry);
+			entry->wait = script_must_wait (path);
+			entry->path = g_steal_pointer (&path);
+			g_ptr_array_add (scripts, entry);
 		}
 		g_free (path);
 	}
 	g_dir_close (dir);
 
-	return sorted;
+	g_ptr_array_sort (scripts, script_entry_cmp);
+	return scripts;
 }
 
-static gboolean
-script_must_wait (const char *path)
+/**
+ * find_scripts:
+ * @str_action: the dispatcher action
+ *
+ * Returns: (transfer full): the sorted list of #ScriptEntry
+ *   to run for @str_action.
+ */
+static GPtrArray *
+find_scripts (const char *str_action)
 {
-	gs_free char *link = NULL;
-	gs_free char *dir = NULL;
-	gs_free char *real = NULL;
-	char *tmp;
+	ScriptDir *script_dir;
+	GPtrArray *scripts;
 
-	link = g_file_read_link (path, NULL);
-	if (link) {
-		if (!g_path_is_absolute (link)) {
-			dir = g_path_get_dirname (path);
-			tmp = g_build_path ("/", dir, link, NULL);
-			g_free (link);
-			g_free (dir);
-			link = tmp;
-		}
+	if (   strcmp (str_action, NMD_ACTION_PRE_UP) == 0
+	    || strcmp (str_action, NMD_ACTION_VPN_PRE_UP) == 0)
+		script_dir = &script_cache.dirs[1];
+	else if (   strcmp (str_action, NMD_ACTION_PRE_DOWN) == 0
+	         || strcmp (str_action, NMD_ACTION_VPN_PRE_DOWN) == 0)
+		script_dir = &script_cache.dirs[2];
+	else
+		script_dir = &script_cache.dirs[0];
 
-		dir = g_path_get_dirname (link);
-		real = realpath (dir, NULL);
+	if (script_dir->scripts)
+		return g_ptr_array_ref (script_dir->scripts);
 
-		if (real && !strcmp (real, NMD_SCRIPT_DIR_NO_WAIT))
-			return FALSE;
+	if (   !script_dir->monitor
+	    && !script_dir->monitor_failed) {
+		script_dir->monitor = script_dir_monitor_new (script_dir->dirname, script_dir);
+		script_dir->monitor_failed = !script_dir->monitor;
 	}
+	if (!script_cache.no_wait_monitor)
+		script_cache.no_wait_monitor = script_dir_monitor_new (NMD_SCRIPT_DIR_NO_WAIT, NULL);
 
-	return TRUE;
+	scripts = script_dir_scan (script_dir->dirname);
+
+	/* without a monitor, we wouldn't notice changes. Scan the
+	 * directory every time. */
+	if (   script_dir->monitor
+	    && script_cache.no_wait_monitor)
+		script_dir->scripts = g_ptr_array_ref (scripts);
+
+	return scripts;
+}
+
+static void
+script_cache_clear (void)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (script_cache.dirs); i++) {
+		ScriptDir *script_dir = &script_cache.dirs[i];
+
+		g_clear_pointer (&script_dir->scripts, g_ptr_array_unref);
+		if (script_dir->monitor) {
+			g_signal_handlers_disconnect_by_func (script_dir->monitor, script_dir_changed_cb, script_dir);
+			g_clear_object (&script_dir->monitor);
+		}
+	}
+	if (script_cache.no_wait_monitor) {
+		g_signal_handlers_disconnect_by_func (script_cache.no_wait_monitor, script_dir_changed_cb, NULL);
+		g_clear_object (&script_cache.no_wait_monitor);
+	}
 }
 
 static gboolean
@@ -679,14 +877,13 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
                gpointer user_data)
 {
 	Handler *h = user_data;
-	GSList *sorted_scripts = NULL;
-	GSList *iter;
+	gs_unref_ptrarray GPtrArray *scripts = NULL;
 	Request *request;
 	char **p;
 	guint i, num_nowait = 0;
 	const char *error_message = NULL;
 
-	sorted_scripts = find_scripts (str_action);
+	scripts = find_scripts (str_action);
 
 	request = g_slice_new0 (Request);
 	request->request_id = ++request_id_counter;
@@ -712,17 +909,17 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	                                                    &request->iface,
 	                                                    &error_message);
 
-	request->scripts = g_ptr_array_new_full (5, script_info_free);
-	for (iter = sorted_scripts; iter; iter = g_slist_next (iter)) {
+	request->scripts = g_ptr_array_new_full (scripts->len, script_info_free);
+	for (i = 0; i < scripts->len; i++) {
+		const ScriptEntry *entry = scripts->pdata[i];
 		ScriptInfo *s;
 
 		s = g_slice_new0 (ScriptInfo);
 		s->request = request;
-		s->script = iter->data;
-		s->wait = script_must_wait (s->script);
+		s->script = g_strdup (entry->path);
+		s->wait = entry->wait;
 		g_ptr_array_add (request->scripts, s);
 	}
-	g_slist_free (sorted_scripts);
 
 	_LOG_R_I (request, "new request (%u scripts)", request->scripts->len);
 	if (   _LOG_R_D_enabled (request)
@@ -754,7 +951,7 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 		ScriptInfo *s = g_ptr_array_index (request->scripts, i);
 
 		if (!s->wait) {
-			script_dispatch (s);
+			nowait_script_enqueue (s);
 			num_nowait++;
 		}
 	}
@@ -792,6 +989,11 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 		complete_request (request);
 	}
 
+	/* Start the "no-wait" scripts last, as a script that fails to start
+	 * may complete @request right away. */
+	if (num_nowait > 0)
+		nowait_scripts_run (h);
+
 	return TRUE;
 }
 
@@ -961,8 +1163,11 @@ main (int argc, char **argv)
 	g_main_loop_run (loop);
 
 	g_queue_free (handler->requests_waiting);
+	g_queue_free (handler->nowait_scripts_waiting);
 	g_object_unref (handler);
 
+	script_cache_clear ();
+
 	if (!debug)
 		logging_shutdown ();
 
@@ -50,6 +50,19 @@ nm_hash_complete (NMHashState *state)
 	return (((guint) (h >> 32)) ^ ((guint) h)) ?: 1396707757u;
 }
 
+static inline guint64
+nm_hash_complete_u64 (NMHashState *state)
+{
+	guint64 h;
+
+	nm_assert (state);
+
+	/* like nm_hash_complete(), but returns the full 64 bit hash. Also
+	 * this never returns zero, so callers can use zero as "unset". */
+	h = c_siphash_finalize (&state->_state);
+	return h ?: 1396707757u;
+}
+
 static inline void
 nm_hash_update (NMHashState *state, const void *ptr, gsize n)
 {
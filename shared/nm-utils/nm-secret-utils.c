@@ -23,6 +23,9 @@
 
 #include "nm-secret-utils.h"
 
+#include <unistd.h>
+#include <sys/mman.h>
+
 /*****************************************************************************/
 
 void
@@ -95,6 +98,76 @@ nm_secret_copy_to_gbytes (gconstpointer mem, gsize mem_len)
 	return nm_secret_buf_to_gbytes_take (b, mem_len);
 }
 
+/* mlock() works on whole pages and the locks don't nest: munlock() unlocks
+ * the page for everybody on it. So, each locked secret gets pages of its
+ * own, instead of a malloc'ed buffer that shares its pages with other
+ * allocations. */
+typedef struct {
+	gsize size;
+	guint8 bin[];
+} SecretLockedBuf;
+
+static void
+_secret_locked_buf_free (gpointer user_data)
+{
+	SecretLockedBuf *b = user_data;
+	gsize size = b->size;
+
+	nm_explicit_bzero (b, size);
+	munmap (b, size);
+}
+
+/**
+ * nm_secret_copy_to_gbytes_locked:
+ * @mem: the data to copy
+ * @mem_len: the length of @mem
+ *
+ * Like nm_secret_copy_to_gbytes(), but the memory of the returned
+ * #GBytes is also locked with mlock(), so that it doesn't get swapped
+ * out. This is for secrets that are kept around for a longer time.
+ * The data lives on page-aligned pages of its own, so that locking and
+ * unlocking doesn't affect other memory. Locking the memory is
+ * best-effort. If it fails (e.g. because of RLIMIT_MEMLOCK), the bytes
+ * are still returned.
+ *
+ * Returns: (transfer full): the #GBytes with a copy of @mem.
+ */
+GBytes *
+nm_secret_copy_to_gbytes_locked (gconstpointer mem, gsize mem_len)
+{
+	SecretLockedBuf *b;
+	gsize page_size;
+	gsize size;
+
+	if (mem_len == 0)
+		return g_bytes_new_static ("", 0);
+
+	nm_assert (mem);
+
+	page_size = sysconf (_SC_PAGESIZE);
+	nm_assert (nm_utils_is_power_of_two (page_size));
+
+	size = sizeof (SecretLockedBuf) + mem_len + 1;
+	size = (size + page_size - 1) & ~(page_size - 1);
+
+	b = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (b == MAP_FAILED)
+		return nm_secret_copy_to_gbytes (mem, mem_len);
+
+	(void) mlock (b, size);
+#ifdef MADV_DONTDUMP
+	(void) madvise (b, size, MADV_DONTDUMP);
+#endif
+
+	b->size = size;
+	memcpy (b->bin, mem, mem_len);
+	b->bin[mem_len] = 0;
+	return g_bytes_new_with_free_func (b->bin,
+	                                   mem_len,
+	                                   _secret_locked_buf_free,
+	                                   b);
+}
+
 /*****************************************************************************/
 
 NMSecretBuf *
@@ -57,6 +57,8 @@ NM_AUTO_DEFINE_FCN (char *, _nm_auto_free_secret, nm_free_secret)
 
 GBytes *nm_secret_copy_to_gbytes (gconstpointer mem, gsize mem_len);
 
+GBytes *nm_secret_copy_to_gbytes_locked (gconstpointer mem, gsize mem_len);
+
 /*****************************************************************************/
 
 /* NMSecretPtr is a pair of malloc'ed data pointer and the length of the
@@ -109,6 +109,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include "nm-utils.h"
 
@@ -654,6 +655,69 @@ nmtst_test_quick (void)
 	return __nmtst_internal.test_quick;
 }
 
+/*****************************************************************************/
+
+/* Support for micro benchmarks.
+ *
+ * nmtst_benchmark_end() prints the result as a TAP comment line of the form
+ *
+ *   # nmtst-benchmark: {"name": "...", "iterations": 1000, "ns-total": 123456, "ns-per-op": 123.5}
+ *
+ * That doesn't interfere with the test protocol, and can easily be extracted
+ * by scripts to track performance regressions. */
+
+typedef struct {
+	const char *name;
+	gint64 start_ns;
+} NMTstBenchmark;
+
+static inline gint64
+_nmtst_benchmark_now_ns (void)
+{
+	struct timespec tp;
+
+	if (clock_gettime (CLOCK_MONOTONIC, &tp) != 0)
+		g_assert_not_reached ();
+	return (((gint64) tp.tv_sec) * 1000000000) + tp.tv_nsec;
+}
+
+/* nmtst_benchmark_scale() returns the number of iterations for a benchmark.
+ * In quick mode, the benchmarks only do a fraction of the work so that they
+ * still get exercised, but their result is not meaningful. */
+static inline guint
+nmtst_benchmark_scale (guint n)
+{
+	return nmtst_test_quick () ? MAX (n / 100, 1u) : n;
+}
+
+static inline void
+nmtst_benchmark_start (NMTstBenchmark *b, const char *name)
+{
+	g_assert (b);
+	g_assert (name);
+
+	b->name = name;
+	b->start_ns = _nmtst_benchmark_now_ns ();
+}
+
+static inline void
+nmtst_benchmark_end (NMTstBenchmark *b, guint64 iterations)
+{
+	gint64 elapsed_ns;
+
+	g_assert (b);
+	g_assert (b->name);
+
+	elapsed_ns = _nmtst_benchmark_now_ns () - b->start_ns;
+
+	g_print ("# nmtst-benchmark: {\"name\": \"%s\", \"iterations\": %"G_GUINT64_FORMAT", \"ns-total\": %"G_GINT64_FORMAT", \"ns-per-op\": %.1f}\n",
+	         b->name,
+	         iterations,
+	         elapsed_ns,
+	         iterations > 0 ? ((double) elapsed_ns) / ((double) iterations) : 0.0);
+	b->name = NULL;
+}
+
 #if GLIB_CHECK_VERSION(2,34,0)
 #undef g_test_expect_message
 #define g_test_expect_message(...) \
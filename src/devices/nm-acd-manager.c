@@ -19,6 +19,7 @@
 #include "nm-acd-manager.h"
 
 #include <netinet/in.h>
+#include <sys/epoll.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
@@ -39,10 +40,9 @@ typedef enum {
 typedef struct {
 	in_addr_t address;
 	gboolean duplicate;
+	gboolean probe_done;
 	NMAcdManager *manager;
 	NAcd *acd;
-	GIOChannel *channel;
-	guint event_id;
 } AddressInfo;
 
 enum {
@@ -58,6 +58,16 @@ typedef struct {
 	State          state;
 	GHashTable    *addresses;
 	guint          completed;
+
+	/* Every n-acd context has its own fd. Instead of one GSource per
+	 * address we collect them in an epoll instance and only watch that. */
+	int            epoll_fd;
+	GIOChannel    *channel;
+	guint          event_id;
+
+	gint64         probe_start_ns;
+	guint          n_used;
+	guint          n_conflicts;
 } NMAcdManagerPrivate;
 
 struct _NMAcdManager {
@@ -171,10 +181,43 @@ nm_acd_manager_add_address (NMAcdManager *self, in_addr_t address)
 	return TRUE;
 }
 
+static void
+acd_probe_done (NMAcdManager *self, AddressInfo *info)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+
+	if (   priv->state != STATE_PROBING
+	    || info->probe_done)
+		return;
+
+	info->probe_done = TRUE;
+	priv->completed++;
+}
+
 static gboolean
-acd_event (GIOChannel *source, GIOCondition condition, gpointer data)
+acd_probe_check_terminated (NMAcdManager *self)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+
+	if (   priv->state != STATE_PROBING
+	    || priv->completed < g_hash_table_size (priv->addresses))
+		return FALSE;
+
+	priv->state = STATE_PROBE_DONE;
+	_LOGD ("probe of %u addresses finished after %"G_GINT64_FORMAT" msec (%u in use)",
+	       g_hash_table_size (priv->addresses),
+	       (nm_utils_get_monotonic_timestamp_ns () - priv->probe_start_ns) / NM_UTILS_NS_PER_MSEC,
+	       priv->n_used);
+	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+	return TRUE;
+}
+
+/* returns %TRUE if the PROBE_TERMINATED signal was emitted. In that case
+ * the caller must not touch @self anymore, as the signal handler commonly
+ * resets or destroys the manager. */
+static gboolean
+acd_event_handle (AddressInfo *info)
 {
-	AddressInfo *info = data;
 	NMAcdManager *self = info->manager;
 	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 	NAcdEvent *event;
@@ -184,7 +227,7 @@ acd_event (GIOChannel *source, GIOCondition condition, gpointer data)
 
 	if (   n_acd_dispatch (info->acd)
 	    || n_acd_pop_event (info->acd, &event))
-		return G_SOURCE_CONTINUE;
+		return FALSE;
 
 	switch (event->event) {
 	case N_ACD_EVENT_READY:
@@ -204,6 +247,7 @@ acd_event (GIOChannel *source, GIOCondition condition, gpointer data)
 		break;
 	case N_ACD_EVENT_USED:
 		info->duplicate = TRUE;
+		priv->n_used++;
 		break;
 	case N_ACD_EVENT_DEFENDED:
 		_LOGD ("defended address %s from host %s",
@@ -212,6 +256,7 @@ acd_event (GIOChannel *source, GIOCondition condition, gpointer data)
 		                                           event->defended.n_sender)));
 		break;
 	case N_ACD_EVENT_CONFLICT:
+		priv->n_conflicts++;
 		_LOGW ("conflict for address %s detected with host %s on interface '%s'",
 		       nm_utils_inet4_ntop (info->address, address_str),
 		       (hwaddr_str = nm_utils_hwaddr_ntoa (event->defended.sender,
@@ -222,18 +267,67 @@ acd_event (GIOChannel *source, GIOCondition condition, gpointer data)
 		_LOGD ("event '%s' for address %s",
 		       acd_event_to_string (event->event),
 		       nm_utils_inet4_ntop (info->address, address_str));
-		return G_SOURCE_CONTINUE;
+		return FALSE;
 	}
 
-	if (   priv->state == STATE_PROBING
-	    && ++priv->completed == g_hash_table_size (priv->addresses)) {
-		priv->state = STATE_PROBE_DONE;
-		g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+	acd_probe_done (self, info);
+	return acd_probe_check_terminated (self);
+}
+
+static gboolean
+acd_event (GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	NMAcdManager *self = data;
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+	struct epoll_event events[32];
+	int i, n;
+
+	n = epoll_wait (priv->epoll_fd, events, G_N_ELEMENTS (events), 0);
+	for (i = 0; i < n; i++) {
+		if (acd_event_handle (events[i].data.ptr)) {
+			/* @self might be gone. If there are more events pending,
+			 * the fds were closed and the source removed anyway. */
+			break;
+		}
 	}
 
 	return G_SOURCE_CONTINUE;
 }
 
+static gboolean
+acd_watch_ensure (NMAcdManager *self)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+
+	if (priv->epoll_fd >= 0)
+		return TRUE;
+
+	priv->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+	if (priv->epoll_fd < 0) {
+		_LOGW ("could not create epoll instance on interface '%s': %s",
+		       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
+		       g_strerror (errno));
+		return FALSE;
+	}
+
+	priv->channel = g_io_channel_unix_new (priv->epoll_fd);
+	priv->event_id = g_io_add_watch (priv->channel, G_IO_IN, acd_event, self);
+	return TRUE;
+}
+
+static void
+acd_watch_clear (NMAcdManager *self)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->event_id);
+	g_clear_pointer (&priv->channel, g_io_channel_unref);
+	if (priv->epoll_fd >= 0) {
+		nm_close (priv->epoll_fd);
+		priv->epoll_fd = -1;
+	}
+}
+
 static gboolean
 acd_probe_start (NMAcdManager *self,
                  AddressInfo *info,
@@ -241,8 +335,12 @@ acd_probe_start (NMAcdManager *self,
 {
 	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 	NAcdConfig *config;
+	struct epoll_event ev = { .events = EPOLLIN, };
 	int r, fd;
 
+	if (!acd_watch_ensure (self))
+		return FALSE;
+
 	r = n_acd_new (&info->acd);
 	if (r) {
 		_LOGW ("could not create ACD for %s on interface '%s': %s",
@@ -253,8 +351,15 @@ acd_probe_start (NMAcdManager *self,
 	}
 
 	n_acd_get_fd (info->acd, &fd);
-	info->channel = g_io_channel_unix_new (fd);
-	info->event_id = g_io_add_watch (info->channel, G_IO_IN, acd_event, info);
+	ev.data.ptr = info;
+	if (epoll_ctl (priv->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		_LOGW ("could not watch ACD for %s on interface '%s': %s",
+		       nm_utils_inet4_ntop (info->address, NULL),
+		       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
+		       g_strerror (errno));
+		g_clear_pointer (&info->acd, n_acd_free);
+		return FALSE;
+	}
 
 	config = &(NAcdConfig) {
 		.ifindex = priv->ifindex,
@@ -271,6 +376,7 @@ acd_probe_start (NMAcdManager *self,
 		       nm_utils_inet4_ntop (info->address, NULL),
 		       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
 		       acd_error_to_string (r));
+		g_clear_pointer (&info->acd, n_acd_free);
 		return FALSE;
 	}
 
@@ -290,7 +396,8 @@ acd_probe_start (NMAcdManager *self,
  * @error: location to store error, or %NULL
  *
  * Start probing IP addresses for duplicates; when the probe terminates a
- * PROBE_TERMINATED signal is emitted.
+ * PROBE_TERMINATED signal is emitted. All addresses are probed in parallel,
+ * so the probe takes about @timeout regardless of the number of addresses.
  *
  * Returns: %TRUE if at least one probe could be started, %FALSE otherwise
  */
@@ -307,10 +414,21 @@ nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
 	g_return_val_if_fail (priv->state == STATE_INIT, FALSE);
 
 	priv->completed = 0;
+	priv->n_used = 0;
+	priv->probe_start_ns = nm_utils_get_monotonic_timestamp_ns ();
 
 	g_hash_table_iter_init (&iter, priv->addresses);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info))
-		success |= acd_probe_start (self, info, timeout);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		info->probe_done = FALSE;
+		if (acd_probe_start (self, info, timeout))
+			success = TRUE;
+		else {
+			/* there will be no event for this address. Count it as
+			 * completed, otherwise the probe never terminates. */
+			info->probe_done = TRUE;
+			priv->completed++;
+		}
+	}
 
 	if (success)
 		priv->state = STATE_PROBING;
@@ -332,9 +450,16 @@ nm_acd_manager_reset (NMAcdManager *self)
 	g_return_if_fail (NM_IS_ACD_MANAGER (self));
 	priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 
+	if (priv->n_conflicts) {
+		_LOGD ("%u address conflicts detected while announcing",
+		       priv->n_conflicts);
+	}
+
 	g_hash_table_remove_all (priv->addresses);
+	acd_watch_clear (self);
 
 	priv->state = STATE_INIT;
+	priv->n_conflicts = 0;
 }
 
 /**
@@ -410,7 +535,9 @@ nm_acd_manager_announce_addresses (NMAcdManager *self)
 		priv->state = STATE_ANNOUNCING;
 		g_hash_table_iter_init (&iter, priv->addresses);
 		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-			if (info->duplicate)
+			/* skip addresses whose probe could not be started. */
+			if (   info->duplicate
+			    || !info->acd)
 				continue;
 			r = n_acd_announce (info->acd, N_ACD_DEFEND_ONCE);
 			if (r) {
@@ -430,9 +557,8 @@ destroy_address_info (gpointer data)
 {
 	AddressInfo *info = (AddressInfo *) data;
 
-	g_clear_pointer (&info->channel, g_io_channel_unref);
+	/* closing the n-acd fd also drops it from the manager's epoll set. */
 	g_clear_pointer (&info->acd, n_acd_free);
-	nm_clear_g_source (&info->event_id);
 
 	g_slice_free (AddressInfo, info);
 }
@@ -447,6 +573,7 @@ nm_acd_manager_init (NMAcdManager *self)
 	priv->addresses = g_hash_table_new_full (nm_direct_hash, NULL,
 	                                         NULL, destroy_address_info);
 	priv->state = STATE_INIT;
+	priv->epoll_fd = -1;
 }
 
 NMAcdManager *
@@ -473,6 +600,7 @@ dispose (GObject *object)
 	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 
 	g_clear_pointer (&priv->addresses, g_hash_table_destroy);
+	acd_watch_clear (self);
 
 	G_OBJECT_CLASS (nm_acd_manager_parent_class)->dispose (object);
 }
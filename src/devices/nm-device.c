@@ -437,6 +437,11 @@ typedef struct _NMDevicePrivate {
 		NMIPConfig *ext_ip_config_x[2];
 	};
 
+	/* A copy of the config that was last committed to platform
+	 * successfully, and the route table it was synced with. */
+	NMIPConfig *committed_ip_config_x[2];
+	guint32 committed_route_table_x[2];
+
 	/* VPNs which use this device */
 	union {
 		struct {
@@ -607,6 +612,8 @@ static gboolean ip_config_merge_and_apply (NMDevice *self,
                                            int addr_family,
                                            gboolean commit);
 
+static void _ip_config_committed_clear (NMDevice *self);
+
 static gboolean nm_device_master_add_slave (NMDevice *self, NMDevice *slave, gboolean configure);
 static void nm_device_slave_notify_enslave (NMDevice *self, gboolean success);
 static void nm_device_slave_notify_release (NMDevice *self, NMDeviceStateReason reason);
@@ -3282,6 +3289,10 @@ carrier_changed (NMDevice *self, gboolean carrier)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 
+	/* the kernel may drop routes when the carrier goes away. Don't
+	 * skip the next commit. */
+	_ip_config_committed_clear (self);
+
 	if (priv->state <= NM_DEVICE_STATE_UNMANAGED)
 		return;
 
@@ -3594,6 +3605,11 @@ device_link_changed (NMDevice *self)
 
 	pllink_keep_alive = nmp_object_ref (NMP_OBJECT_UP_CAST (pllink));
 
+	/* link changes, like a lowered MTU that resets the IPv6 configuration
+	 * of the interface, can affect addresses and routes. Do a full commit
+	 * the next time. */
+	_ip_config_committed_clear (self);
+
 	nm_device_update_from_platform_link (self, pllink);
 
 	had_hw_addr = (priv->hw_addr != NULL);
@@ -11818,6 +11834,68 @@ nm_device_get_ip4_config (NMDevice *self)
 	return NM_DEVICE_GET_PRIVATE (self)->ip_config_4;
 }
 
+typedef enum {
+	IP_CONFIG_COMMIT_TYPE_NONE,
+	IP_CONFIG_COMMIT_TYPE_ADDRESSES,
+	IP_CONFIG_COMMIT_TYPE_FULL,
+} IPConfigCommitType;
+
+static void
+_ip_config_committed_clear (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	g_clear_object (&priv->committed_ip_config_x[0]);
+	g_clear_object (&priv->committed_ip_config_x[1]);
+}
+
+static void
+_ip_config_committed_set (NMDevice *self,
+                          int addr_family,
+                          NMIPConfig *config)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	const gboolean IS_IPv4 = (addr_family == AF_INET);
+
+	if (priv->committed_ip_config_x[IS_IPv4])
+		nm_ip_config_replace (priv->committed_ip_config_x[IS_IPv4], config, NULL);
+	else {
+		priv->committed_ip_config_x[IS_IPv4] = IS_IPv4
+		                                       ? (NMIPConfig *) nm_ip4_config_clone (NM_IP4_CONFIG (config))
+		                                       : (NMIPConfig *) nm_ip6_config_clone (NM_IP6_CONFIG (config));
+	}
+	priv->committed_route_table_x[IS_IPv4] = nm_device_get_route_table (self, addr_family, FALSE);
+}
+
+/* Returns what of @config must be synced to platform. Only if the addresses
+ * and routes are the same as last committed, and the platform cache shows
+ * that nothing was changed behind our back, the sync can be skipped. If only
+ * the lifetimes of addresses changed (for example, after a DHCP renewal),
+ * it suffices to refresh the addresses. */
+static IPConfigCommitType
+_ip_config_commit_type (NMDevice *self,
+                        int addr_family,
+                        NMIPConfig *config,
+                        NMIPRouteTableSyncMode route_table_sync)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	const gboolean IS_IPv4 = (addr_family == AF_INET);
+	NMIPConfig *committed = priv->committed_ip_config_x[IS_IPv4];
+	gboolean lifetimes_differ;
+
+	if (!committed)
+		return IP_CONFIG_COMMIT_TYPE_FULL;
+
+	if (   priv->committed_route_table_x[IS_IPv4] != nm_device_get_route_table (self, addr_family, FALSE)
+	    || !nm_ip_config_equal_for_commit (committed, config, &lifetimes_differ)
+	    || !nm_ip_config_platform_is_synced (config, nm_device_get_platform (self), route_table_sync))
+		return IP_CONFIG_COMMIT_TYPE_FULL;
+
+	return   lifetimes_differ
+	       ? IP_CONFIG_COMMIT_TYPE_ADDRESSES
+	       : IP_CONFIG_COMMIT_TYPE_NONE;
+}
+
 static gboolean
 nm_device_set_ip_config (NMDevice *self,
                          int addr_family,
@@ -11852,35 +11930,63 @@ nm_device_set_ip_config (NMDevice *self,
 
 	/* Always commit to nm-platform to update lifetimes */
 	if (commit && new_config) {
+		NMIPRouteTableSyncMode route_table_sync;
+		IPConfigCommitType commit_type;
+		gboolean committed_keep = TRUE;
 
 		_commit_mtu (self,
 		             IS_IPv4
 		               ? NM_IP4_CONFIG (new_config)
 		               : priv->ip_config_4);
 
-		if (IS_IPv4) {
+		route_table_sync =   nm_device_get_route_table (self, addr_family, FALSE)
+		                   ? NM_IP_ROUTE_TABLE_SYNC_MODE_FULL
+		                   : NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN;
+
+		commit_type = _ip_config_commit_type (self, addr_family, new_config, route_table_sync);
+
+		if (commit_type == IP_CONFIG_COMMIT_TYPE_NONE) {
+			_LOGT (LOGD_IP_from_af (addr_family),
+			       "ip%c-config: skip commit of unchanged config",
+			       nm_utils_addr_family_to_char (addr_family));
+		} else if (commit_type == IP_CONFIG_COMMIT_TYPE_ADDRESSES) {
+			_LOGT (LOGD_IP_from_af (addr_family),
+			       "ip%c-config: only refresh address lifetimes of unchanged config",
+			       nm_utils_addr_family_to_char (addr_family));
+			nm_ip_config_commit_addresses (new_config, nm_device_get_platform (self));
+		} else if (IS_IPv4) {
 			success = nm_ip4_config_commit (NM_IP4_CONFIG (new_config),
 			                                nm_device_get_platform (self),
-			                                nm_device_get_route_table (self, addr_family, FALSE)
-			                                  ? NM_IP_ROUTE_TABLE_SYNC_MODE_FULL
-			                                  : NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN);
-			nm_platform_ip4_dev_route_blacklist_set (nm_device_get_platform (self),
-			                                         nm_ip_config_get_ifindex (new_config),
-			                                         ip4_dev_route_blacklist);
+			                                route_table_sync);
 		} else {
 			gs_unref_ptrarray GPtrArray *temporary_not_available = NULL;
 
 			success = nm_ip6_config_commit (NM_IP6_CONFIG (new_config),
 			                                nm_device_get_platform (self),
-			                                nm_device_get_route_table (self, addr_family, FALSE)
-			                                  ? NM_IP_ROUTE_TABLE_SYNC_MODE_FULL
-			                                  : NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN,
+			                                route_table_sync,
 			                                &temporary_not_available);
 
 			if (!_rt6_temporary_not_available_set (self, temporary_not_available))
 				success = FALSE;
+
+			/* routes that could not be added yet are retried. Don't
+			 * skip that. */
+			if (temporary_not_available)
+				committed_keep = FALSE;
 		}
-	}
+
+		if (IS_IPv4) {
+			nm_platform_ip4_dev_route_blacklist_set (nm_device_get_platform (self),
+			                                         nm_ip_config_get_ifindex (new_config),
+			                                         ip4_dev_route_blacklist);
+		}
+
+		if (success && committed_keep)
+			_ip_config_committed_set (self, addr_family, new_config);
+		else
+			g_clear_object (&priv->committed_ip_config_x[IS_IPv4]);
+	} else if (!new_config)
+		g_clear_object (&priv->committed_ip_config_x[IS_IPv4]);
 
 	old_config = priv->ip_config_x[IS_IPv4];
 
@@ -14165,6 +14271,7 @@ nm_device_cleanup (NMDevice *self, NMDeviceStateReason reason, CleanupType clean
 
 			nm_platform_ip_route_flush (platform, AF_UNSPEC, ifindex);
 			nm_platform_ip_address_flush (platform, AF_UNSPEC, ifindex);
+			_ip_config_committed_clear (self);
 			nm_platform_tfilter_sync (platform, ifindex, NULL);
 			nm_platform_qdisc_sync (platform, ifindex, NULL);
 		}
@@ -15951,6 +16058,8 @@ dispose (GObject *object)
 
 	_cleanup_generic_post (self, CLEANUP_TYPE_KEEP);
 
+	_ip_config_committed_clear (self);
+
 	g_hash_table_remove_all (priv->ip6_saved_properties);
 
 	nm_clear_g_source (&priv->recheck_assume_id);
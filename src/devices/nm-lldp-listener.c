@@ -82,6 +82,10 @@ typedef struct {
 	gint64        ratelimit_next;
 	guint         ratelimit_id;
 
+	/* number of received refreshes that did not change a neighbor and
+	 * thus were not announced. */
+	guint64       n_suppressed;
+
 	GVariant     *variant;
 } NMLldpListenerPrivate;
 
@@ -342,7 +346,7 @@ lldp_neighbor_equal (LldpNeighbor *a, LldpNeighbor *b)
 
 	if (   a->chassis_id_type != b->chassis_id_type
 	    || a->port_id_type != b->port_id_type
-	    || ether_addr_equal (&a->destination_address, &b->destination_address)
+	    || !ether_addr_equal (&a->destination_address, &b->destination_address)
 	    || !nm_streq0 (a->chassis_id, b->chassis_id)
 	    || !nm_streq0 (a->port_id, b->port_id))
 		return FALSE;
@@ -693,8 +697,12 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 			g_hash_table_remove (priv->lldp_neighbors, neigh_old);
 			changed = TRUE;
 			goto done;
-		} else if (lldp_neighbor_equal (neigh_old, neigh))
+		} else if (lldp_neighbor_equal (neigh_old, neigh)) {
+			/* a plain TTL refresh. Keep the old entry, together with its
+			 * cached variant, and don't notify. */
+			priv->n_suppressed++;
 			return;
+		}
 	} else if (!neighbor_valid) {
 		if (parse_error)
 			_LOGT ("process: failed to parse neighbor: %s", parse_error->message);
@@ -781,6 +789,7 @@ nm_lldp_listener_start (NMLldpListener *self, int ifindex, GError **error)
 		goto err;
 	}
 
+	priv->n_suppressed = 0;
 	_LOGD ("start");
 
 	return TRUE;
@@ -805,7 +814,8 @@ nm_lldp_listener_stop (NMLldpListener *self)
 	priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
 
 	if (priv->lldp_handle) {
-		_LOGD ("stop");
+		_LOGD ("stop (%"G_GUINT64_FORMAT" unchanged neighbor refreshes suppressed)",
+		       priv->n_suppressed);
 		sd_lldp_stop (priv->lldp_handle);
 		sd_lldp_detach_event (priv->lldp_handle);
 		sd_lldp_unref (priv->lldp_handle);
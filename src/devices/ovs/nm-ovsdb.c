@@ -75,10 +75,15 @@ typedef struct {
 	GString *output;                /* JSON stream to be sent. */
 	gint64 seq;
 	GArray *calls;                  /* Method calls waiting for a response. */
+	GHashTable *inflight_keys;      /* rows touched by transactions that were sent => use count */
+	guint n_inflight;               /* number of requests waiting for a response */
 	GHashTable *interfaces;         /* interface uuid => OpenvswitchInterface */
 	GHashTable *ports;              /* port uuid => OpenvswitchPort */
 	GHashTable *bridges;            /* bridge uuid => OpenvswitchBridge */
+	GHashTable *port_by_interface;  /* interface uuid => port uuid */
+	GHashTable *bridge_by_port;     /* port uuid => bridge uuid */
 	char *db_uuid;
+	bool monitor_cond_unsupported:1;
 } NMOvsdbPrivate;
 
 struct _NMOvsdb {
@@ -106,6 +111,7 @@ static void ovsdb_disconnect (NMOvsdb *self, gboolean is_disposing);
 static void ovsdb_read (NMOvsdb *self);
 static void ovsdb_write (NMOvsdb *self);
 static void ovsdb_next_command (NMOvsdb *self);
+static void _clear_call (gpointer data);
 
 /*****************************************************************************/
 
@@ -120,12 +126,34 @@ typedef enum {
 	OVSDB_DEL_INTERFACE,
 } OvsdbCommand;
 
+/* The maximum number of requests that are sent to ovsdb-server without
+ * waiting for the response. */
+#define OVSDB_MAX_INFLIGHT 16
+
+/* The tests build this file with a mock server socket. */
+#ifndef OVSDB_SOCKET_PATH
+#define OVSDB_SOCKET_PATH RUNSTATEDIR "/openvswitch/db.sock"
+#endif
+
 typedef struct {
 	gint64 id;
 #define COMMAND_PENDING -1                      /* id not yet assigned */
 	OvsdbCommand command;
 	OvsdbMethodCallback callback;
 	gpointer user_data;
+
+	/* the rows that the transaction of this call depends on. No other
+	 * transaction that conflicts with one of these rows is sent, until
+	 * the response arrives. See _add_key(). */
+	GPtrArray *keys;
+
+	/* the range of operations of this call in the transaction. */
+	guint op_start;
+	guint op_end;
+
+	/* if set, this call is sent in a transaction of its own. */
+	bool no_batch:1;
+
 	union {
 		char *ifname;
 		struct {
@@ -192,8 +220,17 @@ ovsdb_call_method (NMOvsdb *self, OvsdbCommand command,
 	/* Ensure we're not unsynchronized before we queue the method call. */
 	ovsdb_try_connect (self);
 
-	g_array_set_size (priv->calls, priv->calls->len + 1);
-	call = &g_array_index (priv->calls, OvsdbMethodCall, priv->calls->len - 1);
+	if (command == OVSDB_MONITOR) {
+		/* The transactions are built from the result of the monitor,
+		 * it goes before any other command. */
+		nm_assert (   !priv->calls->len
+		           || g_array_index (priv->calls, OvsdbMethodCall, 0).id == COMMAND_PENDING);
+		g_array_prepend_vals (priv->calls, &((OvsdbMethodCall) { }), 1);
+		call = &g_array_index (priv->calls, OvsdbMethodCall, 0);
+	} else {
+		g_array_set_size (priv->calls, priv->calls->len + 1);
+		call = &g_array_index (priv->calls, OvsdbMethodCall, priv->calls->len - 1);
+	}
 	call->id = COMMAND_PENDING;
 	call->command = command;
 	call->callback = callback;
@@ -295,6 +332,25 @@ _set_bridge_ports (json_t *params, const char *ifname, json_t *new_ports)
 	);
 }
 
+/**
+ * _insert_bridge_port:
+ *
+ * Return a command that adds the port @uuid_name to the ports of bridge
+ * @ifname. Unlike _set_bridge_ports(), it doesn't depend on the current
+ * list of ports, so that transactions adding ports to the same bridge
+ * don't need to wait for each other.
+ */
+static void
+_insert_bridge_port (json_t *params, const char *ifname, const char *uuid_name)
+{
+	json_array_append_new (params,
+		json_pack ("{s:s, s:s, s:[[s, s, [s, [[s, s]]]]], s:[[s, s, s]]}",
+		           "op", "mutate", "table", "Bridge",
+		           "mutations", "ports", "insert", "set", "named-uuid", uuid_name,
+		           "where", "name", "==", ifname)
+	);
+}
+
 /**
  * _expect_port_interfaces:
  *
@@ -338,7 +394,7 @@ _set_port_interfaces (json_t *params, const char *ifname, json_t *new_interfaces
  * Returns an commands that adds new interface from a given connection.
  */
 static void
-_insert_interface (json_t *params, NMConnection *interface)
+_insert_interface (json_t *params, NMConnection *interface, const char *uuid_name)
 {
 	const char *type = NULL;
 	NMSettingOvsInterface *s_ovs_iface;
@@ -366,7 +422,7 @@ _insert_interface (json_t *params, NMConnection *interface)
 		           "type", type ?: "",
 		           "options", options,
 		           "external_ids", "map", "NM.connection.uuid", nm_connection_get_uuid (interface),
-		           "uuid-name", "rowInterface"));
+		           "uuid-name", uuid_name));
 }
 
 /**
@@ -375,7 +431,7 @@ _insert_interface (json_t *params, NMConnection *interface)
  * Returns an commands that adds new port from a given connection.
  */
 static void
-_insert_port (json_t *params, NMConnection *port, json_t *new_interfaces)
+_insert_port (json_t *params, NMConnection *port, json_t *new_interfaces, const char *uuid_name)
 {
 	NMSettingOvsPort *s_ovs_port;
 	const char *vlan_mode = NULL;
@@ -421,7 +477,7 @@ _insert_port (json_t *params, NMConnection *port, json_t *new_interfaces)
 	/* Create a new one. */
 	json_array_append_new (params,
 		json_pack ("{s:s, s:s, s:o, s:s}", "op", "insert", "table", "Port",
-		           "row", row, "uuid-name", "rowPort"));
+		           "row", row, "uuid-name", uuid_name));
 }
 
 /**
@@ -430,7 +486,7 @@ _insert_port (json_t *params, NMConnection *port, json_t *new_interfaces)
  * Returns an commands that adds new bridge from a given connection.
  */
 static void
-_insert_bridge (json_t *params, NMConnection *bridge, json_t *new_ports)
+_insert_bridge (json_t *params, NMConnection *bridge, json_t *new_ports, const char *uuid_name)
 {
 	NMSettingOvsBridge *s_ovs_bridge;
 	const char *fail_mode = NULL;
@@ -468,7 +524,7 @@ _insert_bridge (json_t *params, NMConnection *bridge, json_t *new_ports)
 	/* Create a new one. */
 	json_array_append_new (params,
 		json_pack ("{s:s, s:s, s:o, s:s}", "op", "insert", "table", "Bridge",
-		           "row", row, "uuid-name", "rowBridge"));
+		           "row", row, "uuid-name", uuid_name));
 }
 
 /**
@@ -486,14 +542,88 @@ _inc_next_cfg (const char *db_uuid)
 	                  "where", "_uuid", "==", "uuid", db_uuid);
 }
 
+/* A key "<table>:<name>" is added for every row that a transaction
+ * replaces, deletes or checks with a "wait" operation. It conflicts with
+ * any other transaction touching the row. Rows that are only changed with
+ * an order independent "mutate" get a shared key "+<table>:<name>" instead,
+ * which only conflicts with the exclusive key of the row. */
+#define KEY_SHARED_PREFIX '+'
+
+static void
+_add_key (GPtrArray *keys, const char *table, const char *name)
+{
+	g_ptr_array_add (keys, g_strdup_printf ("%s:%s", table, name ?: ""));
+}
+
+static void
+_add_key_shared (GPtrArray *keys, const char *table, const char *name)
+{
+	g_ptr_array_add (keys, g_strdup_printf ("%c%s:%s", KEY_SHARED_PREFIX, table, name ?: ""));
+}
+
+static gboolean
+_keys_conflict (GHashTable *set, GPtrArray *keys)
+{
+	guint i;
+
+	for (i = 0; i < keys->len; i++) {
+		const char *key = keys->pdata[i];
+		gs_free char *shared = NULL;
+
+		if (key[0] == KEY_SHARED_PREFIX) {
+			if (g_hash_table_contains (set, &key[1]))
+				return TRUE;
+			continue;
+		}
+
+		shared = g_strdup_printf ("%c%s", KEY_SHARED_PREFIX, key);
+		if (   g_hash_table_contains (set, key)
+		    || g_hash_table_contains (set, shared))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+_keys_ref (GHashTable *set, GPtrArray *keys)
+{
+	guint i;
+
+	for (i = 0; i < keys->len; i++) {
+		guint count;
+
+		count = GPOINTER_TO_UINT (g_hash_table_lookup (set, keys->pdata[i]));
+		g_hash_table_insert (set, g_strdup (keys->pdata[i]), GUINT_TO_POINTER (count + 1));
+	}
+}
+
+static void
+_keys_unref (GHashTable *set, GPtrArray *keys)
+{
+	guint i;
+
+	for (i = 0; i < keys->len; i++) {
+		guint count;
+
+		count = GPOINTER_TO_UINT (g_hash_table_lookup (set, keys->pdata[i]));
+		nm_assert (count > 0);
+		if (count > 1)
+			g_hash_table_insert (set, g_strdup (keys->pdata[i]), GUINT_TO_POINTER (count - 1));
+		else
+			g_hash_table_remove (set, keys->pdata[i]);
+	}
+}
+
 /**
  * _add_interface:
  *
  * Adds an interface as specified by @interface connection, optionally creating
- * a parent @port and @bridge if needed.
+ * a parent @port and @bridge if needed. The rows the operations depend
+ * on are added to @keys. @batch_idx makes the names of inserted rows unique
+ * within a transaction.
  */
 static void
-_add_interface (NMOvsdb *self, json_t *params,
+_add_interface (NMOvsdb *self, json_t *params, GPtrArray *keys, guint batch_idx,
                 NMConnection *bridge, NMConnection *port, NMConnection *interface)
 {
 	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
@@ -510,6 +640,16 @@ _add_interface (NMOvsdb *self, json_t *params,
 	json_t *ports, *new_ports;
 	json_t *interfaces, *new_interfaces;
 	gboolean has_interface = FALSE;
+	char row_bridge[64];
+	char row_port[64];
+	char row_interface[64];
+
+	nm_sprintf_buf (row_bridge, "rowBridge%u", batch_idx);
+	nm_sprintf_buf (row_port, "rowPort%u", batch_idx);
+	nm_sprintf_buf (row_interface, "rowInterface%u", batch_idx);
+
+	_add_key (keys, "Port", nm_connection_get_interface_name (port));
+	_add_key (keys, "Interface", nm_connection_get_interface_name (interface));
 
 	bridges = json_array ();
 	ports = json_array ();
@@ -532,7 +672,8 @@ _add_interface (NMOvsdb *self, json_t *params,
 
 			json_array_append_new (ports, json_pack ("[s, s]", "uuid", port_uuid));
 
-			if (   g_strcmp0 (ovs_port->name, nm_connection_get_interface_name (port)) != 0
+			if (   !ovs_port
+			    || g_strcmp0 (ovs_port->name, nm_connection_get_interface_name (port)) != 0
 			    || g_strcmp0 (ovs_port->connection_uuid, nm_connection_get_uuid (port)) != 0)
 				continue;
 
@@ -542,7 +683,9 @@ _add_interface (NMOvsdb *self, json_t *params,
 
 				json_array_append_new (interfaces, json_pack ("[s, s]", "uuid", interface_uuid));
 
-				if (   g_strcmp0 (ovs_interface->name, nm_connection_get_interface_name (interface)) == 0
+				/* we don't monitor external interfaces that are not internal. */
+				if (   ovs_interface
+				    && g_strcmp0 (ovs_interface->name, nm_connection_get_interface_name (interface)) == 0
 				    && g_strcmp0 (ovs_interface->connection_uuid, nm_connection_get_uuid (interface)) == 0)
 					has_interface = TRUE;
 			}
@@ -561,19 +704,22 @@ _add_interface (NMOvsdb *self, json_t *params,
 		/* Need to create a port. */
 		if (json_array_size (ports) == 0) {
 			/* Need to create a bridge. */
+			_add_key (keys, "Open_vSwitch", NULL);
+			_add_key (keys, "Bridge", nm_connection_get_interface_name (bridge));
 			_expect_ovs_bridges (params, priv->db_uuid, bridges);
-			json_array_append_new (new_bridges, json_pack ("[s, s]", "named-uuid", "rowBridge"));
+			json_array_append_new (new_bridges, json_pack ("[s, s]", "named-uuid", row_bridge));
 			_set_ovs_bridges (params, priv->db_uuid, new_bridges);
-			_insert_bridge (params, bridge, new_ports);
+			_insert_bridge (params, bridge, new_ports, row_bridge);
 		} else {
-			/* Bridge already exists. */
+			/* Bridge already exists. Other ports can be added to it
+			 * at the same time. */
 			g_return_if_fail (ovs_bridge);
-			_expect_bridge_ports (params, ovs_bridge->name, ports);
-			_set_bridge_ports (params, nm_connection_get_interface_name (bridge), new_ports);
+			_add_key_shared (keys, "Bridge", ovs_bridge->name);
+			_insert_bridge_port (params, ovs_bridge->name, row_port);
 		}
 
-		json_array_append_new (new_ports, json_pack ("[s, s]", "named-uuid", "rowPort"));
-		_insert_port (params, port, new_interfaces);
+		json_array_append_new (new_ports, json_pack ("[s, s]", "named-uuid", row_port));
+		_insert_port (params, port, new_interfaces, row_port);
 	} else {
 		/* Port already exists */
 		g_return_if_fail (ovs_port);
@@ -582,8 +728,8 @@ _add_interface (NMOvsdb *self, json_t *params,
 	}
 
 	if (!has_interface) {
-		_insert_interface (params, interface);
-		json_array_append_new (new_interfaces, json_pack ("[s, s]", "named-uuid", "rowInterface"));
+		_insert_interface (params, interface, row_interface);
+		json_array_append_new (new_interfaces, json_pack ("[s, s]", "named-uuid", row_interface));
 	}
 
 	json_decref (interfaces);
@@ -598,176 +744,290 @@ _add_interface (NMOvsdb *self, json_t *params,
 /**
  * _delete_interface:
  *
- * Removes an interface of @ifname name, collecting empty ports and bridge
- * if last item is removed from them.
+ * Removes an interface of @ifname name, collecting empty port and bridge
+ * if last item is removed from them. The rows the operations depend on are
+ * added to @keys, including the ones that are removed.
  */
 static void
-_delete_interface (NMOvsdb *self, json_t *params, const char *ifname)
+_delete_interface (NMOvsdb *self, json_t *params, GPtrArray *keys, const char *ifname)
 {
 	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
 	GHashTableIter iter;
-	char *bridge_uuid;
-	char *port_uuid;
-	char *interface_uuid;
+	const char *uuid;
+	const char *interface_uuid = NULL;
+	const char *port_uuid;
+	const char *bridge_uuid;
 	OpenvswitchBridge *ovs_bridge;
 	OpenvswitchPort *ovs_port;
 	OpenvswitchInterface *ovs_interface;
-	int pi;
-	int ii;
-	json_t *bridges, *new_bridges;
-	json_t *ports, *new_ports;
-	json_t *interfaces, *new_interfaces;
-	gboolean bridges_changed;
-	gboolean ports_changed;
-	gboolean interfaces_changed;
+	json_t *items, *new_items;
+	guint i;
 
-	bridges = json_array ();
-	new_bridges = json_array ();
-	bridges_changed = FALSE;
+	_add_key (keys, "Interface", ifname);
+
+	g_hash_table_iter_init (&iter, priv->interfaces);
+	while (g_hash_table_iter_next (&iter, (gpointer) &uuid, (gpointer) &ovs_interface)) {
+		if (nm_streq (ovs_interface->name, ifname)) {
+			interface_uuid = uuid;
+			break;
+		}
+	}
+	if (!interface_uuid)
+		return;
+
+	port_uuid = g_hash_table_lookup (priv->port_by_interface, interface_uuid);
+	ovs_port = port_uuid ? g_hash_table_lookup (priv->ports, port_uuid) : NULL;
+	bridge_uuid = port_uuid ? g_hash_table_lookup (priv->bridge_by_port, port_uuid) : NULL;
+	ovs_bridge = bridge_uuid ? g_hash_table_lookup (priv->bridges, bridge_uuid) : NULL;
+	if (!ovs_port || !ovs_bridge) {
+		/* not attached to a bridge, nothing to do. */
+		return;
+	}
+
+	/* the port either loses the interface or goes away. */
+	_add_key (keys, "Port", ovs_port->name);
+
+	if (ovs_port->interfaces->len > 1) {
+		items = json_array ();
+		new_items = json_array ();
+		for (i = 0; i < ovs_port->interfaces->len; i++) {
+			uuid = ovs_port->interfaces->pdata[i];
+			json_array_append_new (items, json_pack ("[s,s]", "uuid", uuid));
+			if (!nm_streq (uuid, interface_uuid))
+				json_array_append_new (new_items, json_pack ("[s,s]", "uuid", uuid));
+		}
+		_expect_port_interfaces (params, ovs_port->name, items);
+		_set_port_interfaces (params, ovs_port->name, new_items);
+		json_decref (items);
+		json_decref (new_items);
+		return;
+	}
 
+	/* The port goes away with its last interface. The bridge either
+	 * loses the port or goes away too. */
+	_add_key (keys, "Bridge", ovs_bridge->name);
+
+	if (ovs_bridge->ports->len > 1) {
+		items = json_array ();
+		new_items = json_array ();
+		for (i = 0; i < ovs_bridge->ports->len; i++) {
+			uuid = ovs_bridge->ports->pdata[i];
+			json_array_append_new (items, json_pack ("[s,s]", "uuid", uuid));
+			if (!nm_streq (uuid, port_uuid))
+				json_array_append_new (new_items, json_pack ("[s,s]", "uuid", uuid));
+		}
+		_expect_bridge_ports (params, ovs_bridge->name, items);
+		_set_bridge_ports (params, ovs_bridge->name, new_items);
+		json_decref (items);
+		json_decref (new_items);
+		return;
+	}
+
+	/* And the bridge goes away with its last port. */
+	items = json_array ();
+	new_items = json_array ();
 	g_hash_table_iter_init (&iter, priv->bridges);
-	while (g_hash_table_iter_next (&iter, (gpointer) &bridge_uuid, (gpointer) &ovs_bridge)) {
-		json_array_append_new (bridges, json_pack ("[s,s]", "uuid", bridge_uuid));
+	while (g_hash_table_iter_next (&iter, (gpointer) &uuid, NULL)) {
+		json_array_append_new (items, json_pack ("[s,s]", "uuid", uuid));
+		if (!nm_streq (uuid, bridge_uuid))
+			json_array_append_new (new_items, json_pack ("[s,s]", "uuid", uuid));
+	}
+	_add_key (keys, "Open_vSwitch", NULL);
+	_expect_ovs_bridges (params, priv->db_uuid, items);
+	_set_ovs_bridges (params, priv->db_uuid, new_items);
+	json_decref (items);
+	json_decref (new_items);
+}
 
-		ports = json_array ();
-		new_ports = json_array ();
-		ports_changed = FALSE;
+static void
+_send_msg (NMOvsdb *self, OvsdbMethodCall *call, json_t *msg)
+{
+	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
+	char *cmd;
 
-		for (pi = 0; pi < ovs_bridge->ports->len; pi++) {
-			port_uuid = g_ptr_array_index (ovs_bridge->ports, pi);
-			ovs_port = g_hash_table_lookup (priv->ports, port_uuid);
+	_call_trace ("send", call, msg);
+	cmd = json_dumps (msg, 0);
 
-			json_array_append_new (ports, json_pack ("[s,s]", "uuid", port_uuid));
+	g_string_append (priv->output, cmd);
+	json_decref (msg);
+	free (cmd);
 
-			interfaces = json_array ();
-			new_interfaces = json_array ();
-			interfaces_changed = FALSE;
+	priv->n_inflight++;
+	ovsdb_write (self);
+}
 
-			for (ii = 0; ii < ovs_port->interfaces->len; ii++) {
-				interface_uuid = g_ptr_array_index (ovs_port->interfaces, ii);
-				ovs_interface = g_hash_table_lookup (priv->interfaces, interface_uuid);
+/**
+ * ovsdb_next_transaction:
+ *
+ * Serializes the next pending calls into one transaction and sends it.
+ * Consecutive add and remove calls are merged into the same transaction, as
+ * long as they don't touch the same rows. A transaction is also not sent
+ * while it touches rows of another transaction that still waits for
+ * its response, since the operations depend on the up to date state of
+ * the rows (add and remove need to include an up to date bridge list in
+ * their transactions to rule out races). Ports are added to an existing
+ * bridge with a mutation that doesn't depend on its state, so that these
+ * only wait for transactions that replace or remove the bridge.
+ *
+ * Returns: %TRUE if a transaction was sent.
+ */
+static gboolean
+ovsdb_next_transaction (NMOvsdb *self)
+{
+	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
+	OvsdbMethodCall *call;
+	OvsdbMethodCall *first = NULL;
+	gs_unref_hashtable GHashTable *batch_keys = NULL;
+	json_t *params = NULL;
+	gint64 id = 0;
+	guint n = 0;
+	guint i;
 
-				json_array_append_new (interfaces, json_pack ("[s,s]", "uuid", interface_uuid));
+	for (i = 0; i < priv->calls->len; i++) {
+		gs_unref_ptrarray GPtrArray *keys = NULL;
+		json_t *ops;
 
-				if (strcmp (ovs_interface->name, ifname) == 0) {
-					/* skip the interface */
-					interfaces_changed = TRUE;
-					continue;
-				}
+		call = &g_array_index (priv->calls, OvsdbMethodCall, i);
+		if (call->id != COMMAND_PENDING)
+			continue;
 
-				json_array_append_new (new_interfaces, json_pack ("[s,s]", "uuid", interface_uuid));
-			}
+		nm_assert (call->command != OVSDB_MONITOR);
 
-			if (json_array_size (new_interfaces) == 0) {
-				ports_changed = TRUE;
-			} else {
-				if (interfaces_changed) {
-					_expect_port_interfaces (params, ovs_port->name, interfaces);
-					_set_port_interfaces (params, ovs_port->name, new_interfaces);
-				}
-				json_array_append_new (new_ports, json_pack ("[s,s]", "uuid", port_uuid));
-			}
+		if (   first
+		    && (first->no_batch || call->no_batch))
+			break;
+
+		ops = json_array ();
+		keys = g_ptr_array_new_with_free_func (g_free);
 
-			json_decref (interfaces);
-			json_decref (new_interfaces);
+		switch (call->command) {
+		case OVSDB_ADD_INTERFACE:
+			_add_interface (self, ops, keys, n, call->bridge, call->port, call->interface);
+			break;
+		case OVSDB_DEL_INTERFACE:
+			_delete_interface (self, ops, keys, call->ifname);
+			break;
+		default:
+			nm_assert_not_reached ();
+			break;
 		}
 
-		if (json_array_size (new_ports) == 0) {
-			bridges_changed = TRUE;
-		} else {
-			if (ports_changed) {
-				_expect_bridge_ports (params, ovs_bridge->name, ports);
-				_set_bridge_ports (params, ovs_bridge->name, new_ports);
-			}
-			json_array_append_new (new_bridges, json_pack ("[s,s]", "uuid", bridge_uuid));
+		if (   _keys_conflict (priv->inflight_keys, keys)
+		    || (batch_keys && _keys_conflict (batch_keys, keys))) {
+			/* don't reorder calls. The rest waits. */
+			json_decref (ops);
+			break;
 		}
 
-		json_decref (ports);
-		json_decref (new_ports);
+		if (!first) {
+			first = call;
+			id = priv->seq++;
+			batch_keys = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, NULL);
+			params = json_array ();
+			json_array_append_new (params, json_string ("Open_vSwitch"));
+			json_array_append_new (params, _inc_next_cfg (priv->db_uuid));
+		}
+
+		call->id = id;
+		call->op_start = json_array_size (params);
+		json_array_extend (params, ops);
+		json_decref (ops);
+		call->op_end = json_array_size (params);
+
+		_keys_ref (batch_keys, keys);
+		call->keys = g_steal_pointer (&keys);
+		n++;
 	}
 
-	if (bridges_changed) {
-		_expect_ovs_bridges (params, priv->db_uuid, bridges);
-		_set_ovs_bridges (params, priv->db_uuid, new_bridges);
+	if (!first)
+		return FALSE;
+
+	/* the keys are released from @inflight_keys when the response arrives. */
+	for (i = 0; i < priv->calls->len; i++) {
+		call = &g_array_index (priv->calls, OvsdbMethodCall, i);
+		if (call->id == id)
+			_keys_ref (priv->inflight_keys, call->keys);
 	}
+
+	if (n > 1)
+		_LOGT ("merged %u calls into transaction %" G_GINT64_FORMAT, n, id);
+
+	_send_msg (self,
+	           first,
+	           json_pack ("{s:I, s:s, s:o}",
+	                      "id", (json_int_t) id,
+	                      "method", "transact", "params", params));
+	return TRUE;
 }
 
 /**
  * ovsdb_next_command:
  *
- * Translates a higher level operation (add/remove bridge/port) to a RFC 7047
- * command serialized into JSON ands sends it over to the database.
-
- * Only called when no command is waiting for a response, since the serialized
- * command might depend on result of a previous one (add and remove need to
- * include an up to date bridge list in their transactions to rule out races).
+ * Translates higher level operations (add/remove bridge/port) to RFC 7047
+ * commands serialized into JSON and sends them over to the database.
+ *
+ * The monitor command must complete before any transaction is sent, since
+ * the transactions are built from the state it returns. Then, up to
+ * %OVSDB_MAX_INFLIGHT requests are sent without waiting for their responses.
  */
 static void
 ovsdb_next_command (NMOvsdb *self)
 {
 	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
 	OvsdbMethodCall *call = NULL;
-	char *cmd;
-	json_t *msg = NULL;
-	json_t *params;
+	json_t *msg;
 
 	if (!priv->conn)
 		return;
 	if (!priv->calls->len)
 		return;
+
 	call = &g_array_index (priv->calls, OvsdbMethodCall, 0);
-	if (call->id != COMMAND_PENDING)
+	if (call->command == OVSDB_MONITOR) {
+		if (call->id != COMMAND_PENDING)
+			return;
+		call->id = priv->seq++;
+		if (priv->monitor_cond_unsupported) {
+			msg = json_pack ("{s:I, s:s, s:[s, n, {"
+			                 "  s:[{s:[s, s, s]}],"
+			                 "  s:[{s:[s, s, s]}],"
+			                 "  s:[{s:[s, s, s]}],"
+			                 "  s:[{s:[]}]"
+			                 "}]}",
+			                 "id", (json_int_t) call->id,
+			                 "method", "monitor", "params", "Open_vSwitch",
+			                 "Bridge", "columns", "name", "ports", "external_ids",
+			                 "Port", "columns", "name", "interfaces", "external_ids",
+			                 "Interface", "columns", "name", "type", "external_ids",
+			                 "Open_vSwitch", "columns");
+		} else {
+			/* We only care about the interfaces that are either internal
+			 * (NMDevices are created for them) or owned by us, which have
+			 * the "NM.connection.uuid" external id. The conditions can't
+			 * match on the presence of a map key, so we match on non-empty
+			 * "external_ids". The conditions of a table are OR-ed. */
+			msg = json_pack ("{s:I, s:s, s:[s, n, {"
+			                 "  s:[{s:[s, s, s]}],"
+			                 "  s:[{s:[s, s, s]}],"
+			                 "  s:[{s:[s, s, s], s:[[s, s, s], [s, s, [s, []]]]}],"
+			                 "  s:[{s:[]}]"
+			                 "}]}",
+			                 "id", (json_int_t) call->id,
+			                 "method", "monitor_cond", "params", "Open_vSwitch",
+			                 "Bridge", "columns", "name", "ports", "external_ids",
+			                 "Port", "columns", "name", "interfaces", "external_ids",
+			                 "Interface", "columns", "name", "type", "external_ids",
+			                 "where", "type", "==", "internal",
+			                 "external_ids", "!=", "map",
+			                 "Open_vSwitch", "columns");
+		}
+		_send_msg (self, call, msg);
 		return;
-	call->id = priv->seq++;
-
-	switch (call->command) {
-	case OVSDB_MONITOR:
-		msg = json_pack ("{s:i, s:s, s:[s, n, {"
-		                 "  s:[{s:[s, s, s]}],"
-		                 "  s:[{s:[s, s, s]}],"
-		                 "  s:[{s:[s, s, s]}],"
-		                 "  s:[{s:[]}]"
-		                 "}]}",
-		                 "id", call->id,
-		                 "method", "monitor", "params", "Open_vSwitch",
-		                 "Bridge", "columns", "name", "ports", "external_ids",
-		                 "Port", "columns", "name", "interfaces", "external_ids",
-		                 "Interface", "columns", "name", "type", "external_ids",
-		                 "Open_vSwitch", "columns");
-		break;
-	case OVSDB_ADD_INTERFACE:
-		params = json_array ();
-		json_array_append_new (params, json_string ("Open_vSwitch"));
-		json_array_append_new (params, _inc_next_cfg (priv->db_uuid));
-
-		_add_interface (self, params, call->bridge, call->port, call->interface);
-
-		msg = json_pack ("{s:i, s:s, s:o}",
-		                 "id", call->id,
-		                 "method", "transact", "params", params);
-		break;
-	case OVSDB_DEL_INTERFACE:
-		params = json_array ();
-		json_array_append_new (params, json_string ("Open_vSwitch"));
-		json_array_append_new (params, _inc_next_cfg (priv->db_uuid));
-
-		_delete_interface (self, params, call->ifname);
-
-		msg = json_pack ("{s:i, s:s, s:o}",
-		                 "id", call->id,
-		                 "method", "transact", "params", params);
-		break;
 	}
 
-	g_return_if_fail (msg);
-	_call_trace ("send", call, msg);
-	cmd = json_dumps (msg, 0);
-
-	g_string_append (priv->output, cmd);
-	json_decref (msg);
-	free (cmd);
-
-	ovsdb_write (self);
+	while (   priv->n_inflight < OVSDB_MAX_INFLIGHT
+	       && ovsdb_next_transaction (self))
+		;
 }
 
 /**
@@ -828,32 +1088,395 @@ _connection_uuid_from_external_ids (json_t *external_ids)
 	return NULL;
 }
 
+/**
+ * _index_clear:
+ *
+ * Drops the entries of @children from @index (child uuid => parent uuid),
+ * unless they were meanwhile claimed by another parent.
+ */
+static void
+_index_clear (GHashTable *index, GPtrArray *children, const char *parent_uuid)
+{
+	guint i;
+
+	for (i = 0; i < children->len; i++) {
+		if (nm_streq0 (g_hash_table_lookup (index, children->pdata[i]), parent_uuid))
+			g_hash_table_remove (index, children->pdata[i]);
+	}
+}
+
+/**
+ * _uuids_apply:
+ *
+ * Updates the @children UUID array of a row from the column value @items.
+ * With @is_diff, @items is the difference from a "modify" <row-update2>: the
+ * UUIDs in it are toggled. Otherwise @items replaces the array. The
+ * @index (child uuid => parent uuid) is kept in sync.
+ */
+static void
+_uuids_apply (GPtrArray *children, const json_t *items, gboolean is_diff,
+              GHashTable *index, const char *parent_uuid)
+{
+	gs_unref_ptrarray GPtrArray *uuids = NULL;
+	const char *uuid;
+	guint i, j;
+
+	uuids = g_ptr_array_new_with_free_func (g_free);
+	_uuids_to_array (uuids, items);
+
+	if (!is_diff) {
+		_index_clear (index, children, parent_uuid);
+		g_ptr_array_set_size (children, 0);
+	}
+
+	for (i = 0; i < uuids->len; i++) {
+		uuid = uuids->pdata[i];
+
+		if (is_diff) {
+			for (j = 0; j < children->len; j++) {
+				if (nm_streq (children->pdata[j], uuid))
+					break;
+			}
+			if (j < children->len) {
+				if (nm_streq0 (g_hash_table_lookup (index, uuid), parent_uuid))
+					g_hash_table_remove (index, uuid);
+				g_ptr_array_remove_index (children, j);
+				continue;
+			}
+		}
+
+		g_ptr_array_add (children, g_strdup (uuid));
+		g_hash_table_insert (index, g_strdup (uuid), g_strdup (parent_uuid));
+	}
+}
+
+/**
+ * _connection_uuid_apply:
+ *
+ * Updates the connection UUID of a row from its "external_ids" column. With
+ * @is_diff, @external_ids contains only the changed pairs, where a pair that
+ * is equal to the current one means that the key was removed.
+ */
+static void
+_connection_uuid_apply (char **connection_uuid, json_t *external_ids, gboolean is_diff)
+{
+	char *uuid;
+
+	uuid = _connection_uuid_from_external_ids (external_ids);
+	if (is_diff) {
+		if (!uuid)
+			return;
+		if (nm_streq0 (*connection_uuid, uuid)) {
+			g_free (uuid);
+			uuid = NULL;
+		}
+	}
+	g_free (*connection_uuid);
+	*connection_uuid = uuid;
+}
+
+typedef enum {
+	OVSDB_ROW_DELETE,
+	OVSDB_ROW_INSERT,               /* full row, new or replacing the old one */
+	OVSDB_ROW_MODIFY,               /* only the changed columns, as differences */
+} OvsdbRowOp;
+
+/**
+ * _row_update_decode:
+ *
+ * Decodes a <row-update> of the "update" notification, or a <row-update2>
+ * of the "update2" notification if @update2 is set.
+ */
+static gboolean
+_row_update_decode (json_t *value, gboolean update2, OvsdbRowOp *out_op, json_t **out_row)
+{
+	json_t *row;
+
+	*out_row = NULL;
+	if (!update2) {
+		/* The "new" row always contains all the monitored columns. */
+		row = json_object_get (value, "new");
+		if (row) {
+			*out_op = OVSDB_ROW_INSERT;
+			*out_row = row;
+		} else
+			*out_op = OVSDB_ROW_DELETE;
+		return TRUE;
+	}
+
+	if (   (row = json_object_get (value, "initial"))
+	    || (row = json_object_get (value, "insert"))) {
+		*out_op = OVSDB_ROW_INSERT;
+		*out_row = row;
+	} else if ((row = json_object_get (value, "modify"))) {
+		*out_op = OVSDB_ROW_MODIFY;
+		*out_row = row;
+	} else if (json_object_get (value, "delete"))
+		*out_op = OVSDB_ROW_DELETE;
+	else
+		return FALSE;
+	return TRUE;
+}
+
+static void
+_interface_update (NMOvsdb *self, const char *uuid, OvsdbRowOp op, json_t *row)
+{
+	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
+	OpenvswitchInterface *ovs_interface;
+	gboolean is_diff = (op == OVSDB_ROW_MODIFY);
+	gboolean is_new = FALSE;
+	const char *name = NULL;
+	const char *type = NULL;
+	json_t *external_ids = NULL;
+
+	ovs_interface = g_hash_table_lookup (priv->interfaces, uuid);
+
+	if (op != OVSDB_ROW_DELETE) {
+		json_unpack (row, "{s?:s, s?:s, s?:o}",
+		             "name", &name,
+		             "type", &type,
+		             "external_ids", &external_ids);
+		if (!is_diff) {
+			/* columns with default values may be omitted. */
+			name = name ?: "";
+			type = type ?: "";
+		}
+	}
+
+	if (   ovs_interface
+	    && (   op == OVSDB_ROW_DELETE
+	        || (name && !nm_streq (ovs_interface->name, name)))) {
+		_LOGT ("removed an '%s' interface: %s%s%s",
+		       ovs_interface->type, ovs_interface->name,
+		       ovs_interface->connection_uuid ? ", " : "",
+		       ovs_interface->connection_uuid ?: "");
+		if (g_strcmp0 (ovs_interface->type, "internal") == 0) {
+			/* Currently the factory only creates NMDevices for
+			 * internal interfaces. Ignore the rest. */
+			g_signal_emit (self, signals[DEVICE_REMOVED], 0,
+			               ovs_interface->name, NM_DEVICE_TYPE_OVS_INTERFACE);
+		}
+		if (op == OVSDB_ROW_DELETE) {
+			g_hash_table_remove (priv->interfaces, uuid);
+			return;
+		}
+		is_new = TRUE;
+	}
+
+	if (op == OVSDB_ROW_DELETE)
+		return;
+
+	if (!ovs_interface) {
+		ovs_interface = g_slice_new0 (OpenvswitchInterface);
+		ovs_interface->name = g_strdup ("");
+		ovs_interface->type = g_strdup ("");
+		g_hash_table_insert (priv->interfaces, g_strdup (uuid), ovs_interface);
+		is_new = TRUE;
+	}
+
+	if (name) {
+		g_free (ovs_interface->name);
+		ovs_interface->name = g_strdup (name);
+	}
+	if (type) {
+		g_free (ovs_interface->type);
+		ovs_interface->type = g_strdup (type);
+	}
+	if (external_ids || !is_diff)
+		_connection_uuid_apply (&ovs_interface->connection_uuid, external_ids, is_diff);
+
+	if (!is_new) {
+		_LOGT ("changed an '%s' interface: %s%s%s", ovs_interface->type, ovs_interface->name,
+		       ovs_interface->connection_uuid ? ", " : "",
+		       ovs_interface->connection_uuid ?: "");
+		g_signal_emit (self, signals[DEVICE_CHANGED], 0,
+		               "ovs-interface", ovs_interface->name);
+	} else {
+		_LOGT ("added an '%s' interface: %s%s%s",
+		       ovs_interface->type, ovs_interface->name,
+		       ovs_interface->connection_uuid ? ", " : "",
+		       ovs_interface->connection_uuid ?: "");
+		if (g_strcmp0 (ovs_interface->type, "internal") == 0) {
+			/* Currently the factory only creates NMDevices for
+			 * internal interfaces. Ignore the rest. */
+			g_signal_emit (self, signals[DEVICE_ADDED], 0,
+			               ovs_interface->name, NM_DEVICE_TYPE_OVS_INTERFACE);
+		}
+	}
+}
+
+static void
+_port_update (NMOvsdb *self, const char *uuid, OvsdbRowOp op, json_t *row)
+{
+	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
+	OpenvswitchPort *ovs_port;
+	gboolean is_diff = (op == OVSDB_ROW_MODIFY);
+	gboolean is_new = FALSE;
+	const char *name = NULL;
+	json_t *external_ids = NULL;
+	json_t *items = NULL;
+
+	ovs_port = g_hash_table_lookup (priv->ports, uuid);
+
+	if (op != OVSDB_ROW_DELETE) {
+		json_unpack (row, "{s?:s, s?:o, s?:o}",
+		             "name", &name,
+		             "external_ids", &external_ids,
+		             "interfaces", &items);
+		if (!is_diff)
+			name = name ?: "";
+	}
+
+	if (   ovs_port
+	    && (   op == OVSDB_ROW_DELETE
+	        || (name && !nm_streq (ovs_port->name, name)))) {
+		_LOGT ("removed a port: %s%s%s", ovs_port->name,
+		       ovs_port->connection_uuid ? ", " : "",
+		       ovs_port->connection_uuid ?: "");
+		g_signal_emit (self, signals[DEVICE_REMOVED], 0,
+		               ovs_port->name, NM_DEVICE_TYPE_OVS_PORT);
+		if (op == OVSDB_ROW_DELETE) {
+			_index_clear (priv->port_by_interface, ovs_port->interfaces, uuid);
+			g_hash_table_remove (priv->ports, uuid);
+			return;
+		}
+		is_new = TRUE;
+	}
+
+	if (op == OVSDB_ROW_DELETE)
+		return;
+
+	if (!ovs_port) {
+		ovs_port = g_slice_new0 (OpenvswitchPort);
+		ovs_port->name = g_strdup ("");
+		ovs_port->interfaces = g_ptr_array_new_with_free_func (g_free);
+		g_hash_table_insert (priv->ports, g_strdup (uuid), ovs_port);
+		is_new = TRUE;
+	}
+
+	if (name) {
+		g_free (ovs_port->name);
+		ovs_port->name = g_strdup (name);
+	}
+	if (external_ids || !is_diff)
+		_connection_uuid_apply (&ovs_port->connection_uuid, external_ids, is_diff);
+	if (items || !is_diff)
+		_uuids_apply (ovs_port->interfaces, items, is_diff, priv->port_by_interface, uuid);
+
+	if (!is_new) {
+		_LOGT ("changed a port: %s%s%s", ovs_port->name,
+		       ovs_port->connection_uuid ? ", " : "",
+		       ovs_port->connection_uuid ?: "");
+		g_signal_emit (self, signals[DEVICE_CHANGED], 0,
+		               NM_SETTING_OVS_PORT_SETTING_NAME, ovs_port->name);
+	} else {
+		_LOGT ("added a port: %s%s%s", ovs_port->name,
+		       ovs_port->connection_uuid ? ", " : "",
+		       ovs_port->connection_uuid ?: "");
+		g_signal_emit (self, signals[DEVICE_ADDED], 0,
+		               ovs_port->name, NM_DEVICE_TYPE_OVS_PORT);
+	}
+}
+
+static void
+_bridge_update (NMOvsdb *self, const char *uuid, OvsdbRowOp op, json_t *row)
+{
+	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
+	OpenvswitchBridge *ovs_bridge;
+	gboolean is_diff = (op == OVSDB_ROW_MODIFY);
+	gboolean is_new = FALSE;
+	const char *name = NULL;
+	json_t *external_ids = NULL;
+	json_t *items = NULL;
+
+	ovs_bridge = g_hash_table_lookup (priv->bridges, uuid);
+
+	if (op != OVSDB_ROW_DELETE) {
+		json_unpack (row, "{s?:s, s?:o, s?:o}",
+		             "name", &name,
+		             "external_ids", &external_ids,
+		             "ports", &items);
+		if (!is_diff)
+			name = name ?: "";
+	}
+
+	if (   ovs_bridge
+	    && (   op == OVSDB_ROW_DELETE
+	        || (name && !nm_streq (ovs_bridge->name, name)))) {
+		_LOGT ("removed a bridge: %s%s%s", ovs_bridge->name,
+		       ovs_bridge->connection_uuid ? ", " : "",
+		       ovs_bridge->connection_uuid ?: "");
+		g_signal_emit (self, signals[DEVICE_REMOVED], 0,
+		               ovs_bridge->name, NM_DEVICE_TYPE_OVS_BRIDGE);
+		if (op == OVSDB_ROW_DELETE) {
+			_index_clear (priv->bridge_by_port, ovs_bridge->ports, uuid);
+			g_hash_table_remove (priv->bridges, uuid);
+			return;
+		}
+		is_new = TRUE;
+	}
+
+	if (op == OVSDB_ROW_DELETE)
+		return;
+
+	if (!ovs_bridge) {
+		ovs_bridge = g_slice_new0 (OpenvswitchBridge);
+		ovs_bridge->name = g_strdup ("");
+		ovs_bridge->ports = g_ptr_array_new_with_free_func (g_free);
+		g_hash_table_insert (priv->bridges, g_strdup (uuid), ovs_bridge);
+		is_new = TRUE;
+	}
+
+	if (name) {
+		g_free (ovs_bridge->name);
+		ovs_bridge->name = g_strdup (name);
+	}
+	if (external_ids || !is_diff)
+		_connection_uuid_apply (&ovs_bridge->connection_uuid, external_ids, is_diff);
+	if (items || !is_diff)
+		_uuids_apply (ovs_bridge->ports, items, is_diff, priv->bridge_by_port, uuid);
+
+	if (!is_new) {
+		_LOGT ("changed a bridge: %s%s%s", ovs_bridge->name,
+		       ovs_bridge->connection_uuid ? ", " : "",
+		       ovs_bridge->connection_uuid ?: "");
+		g_signal_emit (self, signals[DEVICE_CHANGED], 0,
+		               NM_SETTING_OVS_BRIDGE_SETTING_NAME, ovs_bridge->name);
+	} else {
+		_LOGT ("added a bridge: %s%s%s", ovs_bridge->name,
+		       ovs_bridge->connection_uuid ? ", " : "",
+		       ovs_bridge->connection_uuid ?: "");
+		g_signal_emit (self, signals[DEVICE_ADDED], 0,
+		               ovs_bridge->name, NM_DEVICE_TYPE_OVS_BRIDGE);
+	}
+}
+
 /**
  * ovsdb_got_update:
  *
- * Called when we've got an "update" method call (we asked for it with the monitor
- * command). We use it to maintain a consistent view of bridge list regardless of
- * whether the changes are done by us or externally.
+ * Called when we've got an "update" or "update2" method call (we asked for it
+ * with the monitor or monitor_cond command). We use it to maintain a consistent
+ * view of bridge list regardless of whether the changes are done by us or
+ * externally.
+ *
+ * The rows are updated in place: with "update2", a modified row only carries
+ * the columns that changed, and the sets of ports and interfaces only
+ * the UUIDs that were added or removed.
  */
 static void
-ovsdb_got_update (NMOvsdb *self, json_t *msg)
+ovsdb_got_update (NMOvsdb *self, json_t *msg, gboolean update2)
 {
 	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
 	json_t *ovs = NULL;
 	json_t *bridge = NULL;
 	json_t *port = NULL;
 	json_t *interface = NULL;
-	json_t *items;
-	json_t *external_ids;
 	json_error_t json_error = { 0, };
 	void *iter;
-	const char *name;
 	const char *key;
-	const char *type;
 	json_t *value;
-	OpenvswitchBridge *ovs_bridge;
-	OpenvswitchPort *ovs_port;
-	OpenvswitchInterface *ovs_interface;
+	json_t *row;
+	OvsdbRowOp op;
 
 	if (json_unpack_ex (msg, &json_error, 0, "{s?:o, s?:o, s?:o, s?:o}",
 	                    "Open_vSwitch", &ovs,
@@ -867,168 +1490,27 @@ ovsdb_got_update (NMOvsdb *self, json_t *msg)
 
 	if (ovs) {
 		iter = json_object_iter (ovs);
+		g_free (priv->db_uuid);
 		priv->db_uuid = iter ? g_strdup (json_object_iter_key (iter)) : NULL;
 	}
 
 	/* Interfaces */
 	json_object_foreach (interface, key, value) {
-		gboolean old = FALSE;
-		gboolean new = FALSE;
-
-		if (json_unpack (value, "{s:{}}", "old") == 0)
-			old = TRUE;
-
-		if (json_unpack (value, "{s:{s:s, s:s, s:o}}", "new",
-		                 "name", &name,
-		                 "type", &type,
-		                 "external_ids", &external_ids) == 0)
-			new = TRUE;
-
-		if (old) {
-			ovs_interface = g_hash_table_lookup (priv->interfaces, key);
-			if (!new || g_strcmp0 (ovs_interface->name, name) != 0) {
-				old = FALSE;
-				_LOGT ("removed an '%s' interface: %s%s%s",
-				       ovs_interface->type, ovs_interface->name,
-				       ovs_interface->connection_uuid ? ", " : "",
-				       ovs_interface->connection_uuid ?: "");
-				if (g_strcmp0 (ovs_interface->type, "internal") == 0) {
-					/* Currently the factory only creates NMDevices for
-					 * internal interfaces. Ignore the rest. */
-					g_signal_emit (self, signals[DEVICE_REMOVED], 0,
-					               ovs_interface->name, NM_DEVICE_TYPE_OVS_INTERFACE);
-				}
-			}
-			g_hash_table_remove (priv->interfaces, key);
-		}
-
-		if (new) {
-			ovs_interface = g_slice_new (OpenvswitchInterface);
-			ovs_interface->name = g_strdup (name);
-			ovs_interface->type = g_strdup (type);
-			ovs_interface->connection_uuid = _connection_uuid_from_external_ids (external_ids);
-			if (old) {
-				_LOGT ("changed an '%s' interface: %s%s%s", type, ovs_interface->name,
-				       ovs_interface->connection_uuid ? ", " : "",
-				       ovs_interface->connection_uuid ?: "");
-				g_signal_emit (self, signals[DEVICE_CHANGED], 0,
-				               "ovs-interface", ovs_interface->name);
-			} else {
-				_LOGT ("added an '%s' interface: %s%s%s",
-				       ovs_interface->type, ovs_interface->name,
-				       ovs_interface->connection_uuid ? ", " : "",
-				       ovs_interface->connection_uuid ?: "");
-				if (g_strcmp0 (ovs_interface->type, "internal") == 0) {
-					/* Currently the factory only creates NMDevices for
-					 * internal interfaces. Ignore the rest. */
-					g_signal_emit (self, signals[DEVICE_ADDED], 0,
-					               ovs_interface->name, NM_DEVICE_TYPE_OVS_INTERFACE);
-				}
-			}
-			g_hash_table_insert (priv->interfaces, g_strdup (key), ovs_interface);
-		}
+		if (_row_update_decode (value, update2, &op, &row))
+			_interface_update (self, key, op, row);
 	}
 
 	/* Ports */
 	json_object_foreach (port, key, value) {
-		gboolean old = FALSE;
-		gboolean new = FALSE;
-
-		if (json_unpack (value, "{s:{}}", "old") == 0)
-			old = TRUE;
-
-		if (json_unpack (value, "{s:{s:s, s:o, s:o}}", "new",
-		                 "name", &name,
-		                 "external_ids", &external_ids,
-		                 "interfaces", &items) == 0)
-			new = TRUE;
-
-		if (old) {
-			ovs_port = g_hash_table_lookup (priv->ports, key);
-			if (!new || g_strcmp0 (ovs_port->name, name) != 0) {
-				old = FALSE;
-				_LOGT ("removed a port: %s%s%s", ovs_port->name,
-				       ovs_port->connection_uuid ? ", " : "",
-				       ovs_port->connection_uuid ?: "");
-				g_signal_emit (self, signals[DEVICE_REMOVED], 0,
-				               ovs_port->name, NM_DEVICE_TYPE_OVS_PORT);
-			}
-			g_hash_table_remove (priv->ports, key);
-		}
-
-		if (new) {
-			ovs_port = g_slice_new (OpenvswitchPort);
-			ovs_port->name = g_strdup (name);
-			ovs_port->connection_uuid = _connection_uuid_from_external_ids (external_ids);
-			ovs_port->interfaces = g_ptr_array_new_with_free_func (g_free);
-			_uuids_to_array (ovs_port->interfaces, items);
-			if (old) {
-				_LOGT ("changed a port: %s%s%s", ovs_port->name,
-				       ovs_port->connection_uuid ? ", " : "",
-				       ovs_port->connection_uuid ?: "");
-				g_signal_emit (self, signals[DEVICE_CHANGED], 0,
-				               NM_SETTING_OVS_PORT_SETTING_NAME, ovs_port->name);
-			} else {
-				_LOGT ("added a port: %s%s%s", ovs_port->name,
-				       ovs_port->connection_uuid ? ", " : "",
-				       ovs_port->connection_uuid ?: "");
-				g_signal_emit (self, signals[DEVICE_ADDED], 0,
-				               ovs_port->name, NM_DEVICE_TYPE_OVS_PORT);
-			}
-			g_hash_table_insert (priv->ports, g_strdup (key), ovs_port);
-		}
+		if (_row_update_decode (value, update2, &op, &row))
+			_port_update (self, key, op, row);
 	}
 
 	/* Bridges */
 	json_object_foreach (bridge, key, value) {
-		gboolean old = FALSE;
-		gboolean new = FALSE;
-
-		if (json_unpack (value, "{s:{}}", "old") == 0)
-			old = TRUE;
-
-		if (json_unpack (value, "{s:{s:s, s:o, s:o}}", "new",
-		                 "name", &name,
-		                 "external_ids", &external_ids,
-		                 "ports", &items) == 0)
-			new = TRUE;
-
-		if (old) {
-			ovs_bridge = g_hash_table_lookup (priv->bridges, key);
-			if (!new || g_strcmp0 (ovs_bridge->name, name) != 0) {
-				old = FALSE;
-				_LOGT ("removed a bridge: %s%s%s", ovs_bridge->name,
-				       ovs_bridge->connection_uuid ? ", " : "",
-				       ovs_bridge->connection_uuid ?: "");
-				g_signal_emit (self, signals[DEVICE_REMOVED], 0,
-				               ovs_bridge->name, NM_DEVICE_TYPE_OVS_BRIDGE);
-			}
-			g_hash_table_remove (priv->bridges, key);
-		}
-
-		if (new) {
-			ovs_bridge = g_slice_new (OpenvswitchBridge);
-			ovs_bridge->name = g_strdup (name);
-			ovs_bridge->connection_uuid = _connection_uuid_from_external_ids (external_ids);
-			ovs_bridge->ports = g_ptr_array_new_with_free_func (g_free);
-			_uuids_to_array (ovs_bridge->ports, items);
-			if (old) {
-				_LOGT ("changed a bridge: %s%s%s", ovs_bridge->name,
-				       ovs_bridge->connection_uuid ? ", " : "",
-				       ovs_bridge->connection_uuid ?: "");
-				g_signal_emit (self, signals[DEVICE_CHANGED], 0,
-				               NM_SETTING_OVS_BRIDGE_SETTING_NAME, ovs_bridge->name);
-			} else {
-				_LOGT ("added a bridge: %s%s%s", ovs_bridge->name,
-				       ovs_bridge->connection_uuid ? ", " : "",
-				       ovs_bridge->connection_uuid ?: "");
-				g_signal_emit (self, signals[DEVICE_ADDED], 0,
-				               ovs_bridge->name, NM_DEVICE_TYPE_OVS_BRIDGE);
-			}
-			g_hash_table_insert (priv->bridges, g_strdup (key), ovs_bridge);
-		}
+		if (_row_update_decode (value, update2, &op, &row))
+			_bridge_update (self, key, op, row);
 	}
-
 }
 
 /**
@@ -1101,9 +1583,12 @@ ovsdb_got_msg (NMOvsdb *self, json_t *msg)
 			return;
 		}
 
-		if (g_strcmp0 (method, "update") == 0) {
+		if (g_strcmp0 (method, "update2") == 0) {
+			/* This is a update2 method call, for the monitor_cond. */
+			ovsdb_got_update (self, json_array_get (params, 1), TRUE);
+		} else if (g_strcmp0 (method, "update") == 0) {
 			/* This is a update method call. */
-			ovsdb_got_update (self, json_array_get (params, 1));
+			ovsdb_got_update (self, json_array_get (params, 1), FALSE);
 		} else if (g_strcmp0 (method, "echo") == 0) {
 			/* This is an echo request. */
 			ovsdb_got_echo (self, id, params);
@@ -1114,15 +1599,22 @@ ovsdb_got_msg (NMOvsdb *self, json_t *msg)
 	}
 
 	if (id > -1) {
-		/* This is a response to a method call. */
-		if (!priv->calls->len) {
-			_LOGE ("there are no queued calls expecting response %" G_GUINT64_FORMAT, id);
-			ovsdb_disconnect (self, FALSE);
-			return;
+		gs_unref_array GArray *done = NULL;
+		gboolean found = FALSE;
+		gboolean requeue = FALSE;
+		gssize error_idx = -1;
+		guint i;
+
+		/* This is a response to a method call. Find the calls it belongs to. */
+		for (i = 0; i < priv->calls->len; i++) {
+			call = &g_array_index (priv->calls, OvsdbMethodCall, i);
+			if (call->id == id) {
+				found = TRUE;
+				break;
+			}
 		}
-		call = &g_array_index (priv->calls, OvsdbMethodCall, 0);
-		if (call->id != id) {
-			_LOGE ("expected a response to call %" G_GUINT64_FORMAT ", not %" G_GUINT64_FORMAT, call->id, id);
+		if (!found) {
+			_LOGE ("there are no queued calls expecting response %" G_GUINT64_FORMAT, id);
 			ovsdb_disconnect (self, FALSE);
 			return;
 		}
@@ -1130,24 +1622,82 @@ ovsdb_got_msg (NMOvsdb *self, json_t *msg)
 
 		_call_trace ("response", call, msg);
 
+		nm_assert (priv->n_inflight > 0);
+		priv->n_inflight--;
+
 		if (!json_is_null (error)) {
 			/* The response contains an error. */
 			g_set_error (&local, G_IO_ERROR, G_IO_ERROR_FAILED,
 			             "Error call to OVSDB returned an error: %s",
 			              json_string_value (error));
+		} else if (json_is_array (result)) {
+			size_t index;
+			json_t *value;
+
+			json_array_foreach (result, index, value) {
+				if (json_object_get (value, "error")) {
+					error_idx = index;
+					break;
+				}
+			}
 		}
 
-		callback = call->callback;
-		user_data = call->user_data;
-		g_array_remove_index (priv->calls, 0);
-		callback (self, result, local, user_data);
+		if (call->command != OVSDB_MONITOR && error_idx >= 0) {
+			guint n_calls = 0;
+
+			for (i = 0; i < priv->calls->len; i++) {
+				if (g_array_index (priv->calls, OvsdbMethodCall, i).id == id)
+					n_calls++;
+			}
+			/* a merged transaction failed and nothing of it was committed. The
+			 * call that caused the error gets it, the others are sent again on
+			 * their own. */
+			requeue = (n_calls > 1);
+		}
+
+		done = g_array_new (FALSE, FALSE, sizeof (OvsdbMethodCall));
+		for (i = 0; i < priv->calls->len; ) {
+			call = &g_array_index (priv->calls, OvsdbMethodCall, i);
+			if (call->id != id) {
+				i++;
+				continue;
+			}
+
+			if (call->keys) {
+				_keys_unref (priv->inflight_keys, call->keys);
+				g_clear_pointer (&call->keys, g_ptr_array_unref);
+			}
+
+			if (   requeue
+			    && (   (guint) error_idx < call->op_start
+			        || (guint) error_idx >= call->op_end)) {
+				call->id = COMMAND_PENDING;
+				call->no_batch = TRUE;
+				i++;
+				continue;
+			}
+
+			g_array_append_val (done, *call);
+			/* the call was moved to @done. Don't let the array clear it. */
+			memset (call, 0, sizeof (*call));
+			g_array_remove_index (priv->calls, i);
+		}
+
+		for (i = 0; i < done->len; i++) {
+			call = &g_array_index (done, OvsdbMethodCall, i);
+			callback = call->callback;
+			user_data = call->user_data;
+			_clear_call (call);
+			callback (self, result, local, user_data);
+		}
+		g_clear_error (&local);
 
 		/* Don't progress further commands in case the callback hit an error
 		 * and disconnected us. */
 		if (!priv->conn)
 			return;
 
-		/* Now we're free to serialize and send the next command, if any. */
+		/* Now we're free to serialize and send the next commands, if any. */
 		ovsdb_next_command (self);
 
 		return;
@@ -1303,6 +1853,11 @@ ovsdb_disconnect (NMOvsdb *self, gboolean is_disposing)
 	_LOGD ("disconnecting from ovsdb");
 	nm_utils_error_set_cancelled (&error, is_disposing, "NMOvsdb");
 
+	/* all the calls that hold keys are about to be destroyed. */
+	if (priv->inflight_keys)
+		g_hash_table_remove_all (priv->inflight_keys);
+	priv->n_inflight = 0;
+
 	while (priv->calls->len) {
 		call = &g_array_index (priv->calls, OvsdbMethodCall, priv->calls->len - 1);
 		callback = call->callback;
@@ -1311,6 +1866,7 @@ ovsdb_disconnect (NMOvsdb *self, gboolean is_disposing)
 		callback (self, NULL, error, user_data);
 	}
 
+	priv->monitor_cond_unsupported = FALSE;
 	priv->bufp = 0;
 	g_string_truncate (priv->input, 0);
 	g_string_truncate (priv->output, 0);
@@ -1322,17 +1878,27 @@ ovsdb_disconnect (NMOvsdb *self, gboolean is_disposing)
 static void
 _monitor_bridges_cb (NMOvsdb *self, json_t *result, GError *error, gpointer user_data)
 {
+	NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE (self);
+
 	if (error) {
-		if (!nm_utils_error_is_cancelled (error, TRUE)) {
-			_LOGI ("%s", error->message);
-			ovsdb_disconnect (self, FALSE);
+		if (nm_utils_error_is_cancelled (error, TRUE))
+			return;
+		if (!priv->monitor_cond_unsupported) {
+			/* ovsdb-server before 2.6 doesn't know about monitor_cond. */
+			_LOGD ("monitor_cond failed, falling back to monitor: %s", error->message);
+			priv->monitor_cond_unsupported = TRUE;
+			ovsdb_call_method (self, OVSDB_MONITOR, NULL,
+			                   NULL, NULL, NULL, _monitor_bridges_cb, NULL);
+			return;
 		}
+		_LOGI ("%s", error->message);
+		ovsdb_disconnect (self, FALSE);
 		return;
 	}
 
 	/* Treat the first response the same as the subsequent "update"
 	 * messages we eventually get. */
-	ovsdb_got_update (self, result);
+	ovsdb_got_update (self, result, !priv->monitor_cond_unsupported);
 }
 
 static void
@@ -1379,7 +1945,7 @@ ovsdb_try_connect (NMOvsdb *self)
 		return;
 
 	/* XXX: This should probably be made configurable via NetworkManager.conf */
-	addr = g_unix_socket_address_new (RUNSTATEDIR "/openvswitch/db.sock");
+	addr = g_unix_socket_address_new (OVSDB_SOCKET_PATH);
 
 	priv->client = g_socket_client_new ();
 	priv->cancellable = g_cancellable_new ();
@@ -1476,6 +2042,7 @@ _clear_call (gpointer data)
 		g_clear_pointer (&call->ifname, g_free);
 		break;
 	}
+	g_clear_pointer (&call->keys, g_ptr_array_unref);
 }
 
 static void
@@ -1518,11 +2085,14 @@ nm_ovsdb_init (NMOvsdb *self)
 
 	priv->calls = g_array_new (FALSE, TRUE, sizeof (OvsdbMethodCall));
 	g_array_set_clear_func (priv->calls, _clear_call);
+	priv->inflight_keys = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, NULL);
 	priv->input = g_string_new (NULL);
 	priv->output = g_string_new (NULL);
 	priv->bridges = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, _free_bridge);
 	priv->ports = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, _free_port);
 	priv->interfaces = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, _free_interface);
+	priv->port_by_interface = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, g_free);
+	priv->bridge_by_port = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, g_free);
 
 	ovsdb_try_connect (self);
 }
@@ -1545,9 +2115,12 @@ dispose (GObject *object)
 		priv->calls = NULL;
 	}
 
+	g_clear_pointer (&priv->inflight_keys, g_hash_table_destroy);
 	g_clear_pointer (&priv->bridges, g_hash_table_destroy);
 	g_clear_pointer (&priv->ports, g_hash_table_destroy);
 	g_clear_pointer (&priv->interfaces, g_hash_table_destroy);
+	g_clear_pointer (&priv->port_by_interface, g_hash_table_destroy);
+	g_clear_pointer (&priv->bridge_by_port, g_hash_table_destroy);
 
 	g_cancellable_cancel (priv->cancellable);
 	g_clear_object (&priv->cancellable);
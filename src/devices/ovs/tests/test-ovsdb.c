@@ -0,0 +1,425 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <gio/gunixsocketaddress.h>
+
+#include "nm-utils/nm-jansson.h"
+#include "devices/ovs/nm-ovsdb.h"
+#include "nm-core-internal.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+#define DB_UUID        "0d9ae3ee-8ff8-4f1e-8a4b-4c4bd1d8a9f0"
+#define BRIDGE_UUID    "6d55e1a7-0f37-4d6e-a37e-0d1ec2f9d0a1"
+#define PORT_UUID      "b3a3c6c9-0b5a-4d5f-9f0e-4f3c0b1fa9e2"
+#define INTERFACE_UUID "0a6f0e2b-8b19-4a53-a6f1-71e0c1f5c0b3"
+
+#define BRIDGE_CON_UUID    "1b0e35c4-0bd9-4b77-9cdb-2a2b1c43f001"
+#define PORT_CON_UUID      "1b0e35c4-0bd9-4b77-9cdb-2a2b1c43f002"
+#define INTERFACE_CON_UUID "1b0e35c4-0bd9-4b77-9cdb-2a2b1c43f003"
+
+/* A minimal ovsdb-server. It answers monitor_cond with a database that
+ * has bridge "br0" with port "p0" and interface "i0", and keeps the
+ * transactions until the test replies to them. */
+typedef struct {
+	char *dir;
+	char *path;
+	GSocketService *service;
+	GSocketConnection *conn;
+	GCancellable *cancellable;
+	GString *input;
+	char buf[4096];
+	GPtrArray *transacts;           /* transactions waiting for a reply */
+	guint n_transacts;              /* all transactions received */
+} MockOvsdb;
+
+static void _mock_read (MockOvsdb *mock);
+
+static void
+_mock_send (MockOvsdb *mock, json_t *msg)
+{
+	GError *error = NULL;
+	char *str;
+
+	str = json_dumps (msg, 0);
+	g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (mock->conn)),
+	                           str, strlen (str), NULL, NULL, &error);
+	g_assert_no_error (error);
+	free (str);
+	json_decref (msg);
+}
+
+static json_t *
+_external_ids (const char *uuid)
+{
+	return json_pack ("[s, [[s, s]]]", "map", "NM.connection.uuid", uuid);
+}
+
+static void
+_mock_got_msg (MockOvsdb *mock, json_t *msg)
+{
+	const char *method = json_string_value (json_object_get (msg, "method"));
+	json_t *result;
+
+	if (nm_streq0 (method, "monitor_cond")) {
+		result = json_pack ("{s:{s:{s:{}}},"
+		                    " s:{s:{s:{s:s, s:[s, s], s:o}}},"
+		                    " s:{s:{s:{s:s, s:[s, s], s:o}}},"
+		                    " s:{s:{s:{s:s, s:s, s:o}}}}",
+		                    "Open_vSwitch", DB_UUID, "initial",
+		                    "Bridge", BRIDGE_UUID, "initial",
+		                    "name", "br0",
+		                    "ports", "uuid", PORT_UUID,
+		                    "external_ids", _external_ids (BRIDGE_CON_UUID),
+		                    "Port", PORT_UUID, "initial",
+		                    "name", "p0",
+		                    "interfaces", "uuid", INTERFACE_UUID,
+		                    "external_ids", _external_ids (PORT_CON_UUID),
+		                    "Interface", INTERFACE_UUID, "initial",
+		                    "name", "i0",
+		                    "type", "internal",
+		                    "external_ids", _external_ids (INTERFACE_CON_UUID));
+		g_assert (result);
+		_mock_send (mock, json_pack ("{s:O, s:o, s:n}",
+		                             "id", json_object_get (msg, "id"),
+		                             "result", result,
+		                             "error"));
+	} else if (nm_streq0 (method, "transact")) {
+		g_ptr_array_add (mock->transacts, json_incref (msg));
+		mock->n_transacts++;
+	} else
+		g_assert_not_reached ();
+}
+
+static void
+_mock_read_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	MockOvsdb *mock = user_data;
+	json_error_t json_error;
+	GError *error = NULL;
+	gssize size;
+	json_t *msg;
+
+	size = g_input_stream_read_finish (G_INPUT_STREAM (source_object), res, &error);
+	if (size <= 0) {
+		/* the client disconnected, or the mock was already freed. */
+		g_clear_error (&error);
+		return;
+	}
+
+	g_string_append_len (mock->input, mock->buf, size);
+	while (mock->input->len) {
+		msg = json_loadb (mock->input->str, mock->input->len, JSON_DISABLE_EOF_CHECK, &json_error);
+		if (!msg)
+			break;
+		g_string_erase (mock->input, 0, json_error.position);
+		_mock_got_msg (mock, msg);
+		json_decref (msg);
+	}
+
+	_mock_read (mock);
+}
+
+static void
+_mock_read (MockOvsdb *mock)
+{
+	g_input_stream_read_async (g_io_stream_get_input_stream (G_IO_STREAM (mock->conn)),
+	                           mock->buf, sizeof (mock->buf),
+	                           G_PRIORITY_DEFAULT, mock->cancellable, _mock_read_cb, mock);
+}
+
+static gboolean
+_mock_incoming (GSocketService *service,
+                GSocketConnection *connection,
+                GObject *source_object,
+                gpointer user_data)
+{
+	MockOvsdb *mock = user_data;
+
+	g_assert (!mock->conn);
+	mock->conn = g_object_ref (connection);
+	_mock_read (mock);
+	return TRUE;
+}
+
+static MockOvsdb *
+_mock_new (void)
+{
+	MockOvsdb *mock;
+	GSocketAddress *addr;
+	GError *error = NULL;
+
+	mock = g_slice_new0 (MockOvsdb);
+	mock->dir = g_dir_make_tmp ("nm-test-ovsdb-XXXXXX", &error);
+	g_assert_no_error (error);
+	mock->path = g_build_filename (mock->dir, "db.sock", NULL);
+	mock->cancellable = g_cancellable_new ();
+	mock->input = g_string_new (NULL);
+	mock->transacts = g_ptr_array_new_with_free_func ((GDestroyNotify) json_decref);
+
+	addr = g_unix_socket_address_new (mock->path);
+	mock->service = g_socket_service_new ();
+	g_socket_listener_add_address (G_SOCKET_LISTENER (mock->service), addr,
+	                               G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+	                               NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_object_unref (addr);
+	g_signal_connect (mock->service, "incoming", G_CALLBACK (_mock_incoming), mock);
+	g_socket_service_start (mock->service);
+
+	/* nm-ovsdb.c is built for the tests to connect to this socket. */
+	g_setenv ("NMTST_OVSDB_SOCKET", mock->path, TRUE);
+
+	return mock;
+}
+
+/* Frees the mock and closes the connection once the pending read is
+ * cancelled. */
+static void
+_mock_free (MockOvsdb *mock)
+{
+	g_cancellable_cancel (mock->cancellable);
+	g_object_unref (mock->cancellable);
+	g_socket_service_stop (mock->service);
+	g_socket_listener_close (G_SOCKET_LISTENER (mock->service));
+	g_object_unref (mock->service);
+	g_clear_object (&mock->conn);
+	g_ptr_array_unref (mock->transacts);
+	g_string_free (mock->input, TRUE);
+	unlink (mock->path);
+	rmdir (mock->dir);
+	g_free (mock->path);
+	g_free (mock->dir);
+	g_slice_free (MockOvsdb, mock);
+}
+
+/* Replies with success to the transaction @idx of the pending ones. */
+static void
+_mock_reply (MockOvsdb *mock, guint idx)
+{
+	json_t *msg = mock->transacts->pdata[idx];
+	json_t *result;
+	size_t i;
+
+	result = json_array ();
+	for (i = 1; i < json_array_size (json_object_get (msg, "params")); i++)
+		json_array_append_new (result, json_object ());
+
+	_mock_send (mock, json_pack ("{s:O, s:o, s:n}",
+	                             "id", json_object_get (msg, "id"),
+	                             "result", result,
+	                             "error"));
+	g_ptr_array_remove_index (mock->transacts, idx);
+}
+
+/* Counts the operations @op on @table in the pending transaction @idx. */
+static guint
+_mock_count_ops (MockOvsdb *mock, guint idx, const char *op, const char *table)
+{
+	json_t *params = json_object_get (mock->transacts->pdata[idx], "params");
+	json_t *value;
+	size_t i;
+	guint n = 0;
+
+	json_array_foreach (params, i, value) {
+		if (   nm_streq0 (json_string_value (json_object_get (value, "op")), op)
+		    && nm_streq0 (json_string_value (json_object_get (value, "table")), table))
+			n++;
+	}
+	return n;
+}
+
+#define _iterate_until(cond) \
+	NMTST_WAIT_ASSERT (3000, { \
+		if (cond) \
+			break; \
+		g_main_context_iteration (NULL, FALSE); \
+		g_usleep (1000); \
+	})
+
+static void
+_iterate (guint msec)
+{
+	NMTST_WAIT (msec, {
+		g_main_context_iteration (NULL, FALSE);
+		g_usleep (1000);
+	});
+}
+
+/* NMOvsdb doesn't cancel its pending read on dispose. Let it see the
+ * server hang up first, after which it doesn't read anymore. */
+static void
+_teardown (MockOvsdb *mock, NMOvsdb *ovsdb)
+{
+	_mock_free (mock);
+	_iterate (50);
+	g_object_unref (ovsdb);
+}
+
+/*****************************************************************************/
+
+static NMConnection *
+_connection_new (const char *type, const char *ifname, const char *uuid)
+{
+	NMSettingConnection *s_con;
+	NMConnection *connection;
+
+	connection = nmtst_create_minimal_connection (ifname, uuid, type, &s_con);
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_INTERFACE_NAME, ifname,
+	              NULL);
+	return connection;
+}
+
+static void
+_transact_cb (GError *error, gpointer user_data)
+{
+	guint *n_done = user_data;
+
+	g_assert_no_error (error);
+	(*n_done)++;
+}
+
+static void
+test_pipeline (void)
+{
+	MockOvsdb *mock = _mock_new ();
+	gs_unref_object NMOvsdb *ovsdb = NULL;
+	gs_unref_object NMConnection *bridge = NULL;
+	gs_unref_object NMConnection *port0 = NULL;
+	NMConnection *ports[5];
+	NMConnection *interfaces[7];
+	guint n_done = 0;
+	guint i;
+
+	bridge = _connection_new (NM_SETTING_OVS_BRIDGE_SETTING_NAME, "br0", BRIDGE_CON_UUID);
+	port0 = _connection_new (NM_SETTING_OVS_PORT_SETTING_NAME, "p0", PORT_CON_UUID);
+	for (i = 0; i < G_N_ELEMENTS (ports); i++) {
+		gs_free char *name = g_strdup_printf ("p%u", i + 1);
+
+		ports[i] = _connection_new (NM_SETTING_OVS_PORT_SETTING_NAME, name, NULL);
+	}
+	for (i = 0; i < G_N_ELEMENTS (interfaces); i++) {
+		gs_free char *name = g_strdup_printf ("i%u", i + 1);
+
+		interfaces[i] = _connection_new (NM_SETTING_OVS_INTERFACE_SETTING_NAME, name, NULL);
+	}
+
+	ovsdb = g_object_new (NM_TYPE_OVSDB, NULL);
+
+	/* the calls queued while the monitor is pending are merged, since new
+	 * ports of an existing bridge don't conflict with each other. */
+	for (i = 0; i < 4; i++)
+		nm_ovsdb_add_interface (ovsdb, bridge, ports[i], interfaces[i], _transact_cb, &n_done);
+
+	_iterate_until (mock->n_transacts == 1);
+	_iterate (50);
+	g_assert_cmpint (mock->n_transacts, ==, 1);
+	g_assert_cmpint (_mock_count_ops (mock, 0, "insert", "Port"), ==, 4);
+	g_assert_cmpint (_mock_count_ops (mock, 0, "insert", "Interface"), ==, 4);
+	g_assert_cmpint (_mock_count_ops (mock, 0, "mutate", "Bridge"), ==, 4);
+	g_assert_cmpint (_mock_count_ops (mock, 0, "wait", "Bridge"), ==, 0);
+
+	/* another port of the bridge is sent without waiting for the response. */
+	nm_ovsdb_add_interface (ovsdb, bridge, ports[4], interfaces[4], _transact_cb, &n_done);
+	_iterate_until (mock->n_transacts == 2);
+
+	/* so is an interface of an existing port, which leaves the bridge alone. */
+	nm_ovsdb_add_interface (ovsdb, bridge, port0, interfaces[5], _transact_cb, &n_done);
+	_iterate_until (mock->n_transacts == 3);
+	g_assert_cmpint (_mock_count_ops (mock, 2, "insert", "Interface"), ==, 1);
+	g_assert_cmpint (_mock_count_ops (mock, 2, "update", "Port"), ==, 1);
+	g_assert_cmpint (_mock_count_ops (mock, 2, "mutate", "Bridge"), ==, 0);
+
+	/* but a port that is still being added waits for the response. */
+	nm_ovsdb_add_interface (ovsdb, bridge, ports[0], interfaces[6], _transact_cb, &n_done);
+	_iterate (50);
+	g_assert_cmpint (mock->n_transacts, ==, 3);
+
+	_mock_reply (mock, 0);
+	_iterate_until (n_done == 4 && mock->n_transacts == 4);
+
+	while (mock->transacts->len)
+		_mock_reply (mock, 0);
+	_iterate_until (n_done == 7);
+
+	for (i = 0; i < G_N_ELEMENTS (ports); i++)
+		g_object_unref (ports[i]);
+	for (i = 0; i < G_N_ELEMENTS (interfaces); i++)
+		g_object_unref (interfaces[i]);
+	_teardown (mock, g_steal_pointer (&ovsdb));
+}
+
+static void
+test_delete_last_port (void)
+{
+	MockOvsdb *mock = _mock_new ();
+	gs_unref_object NMOvsdb *ovsdb = NULL;
+	gs_unref_object NMConnection *bridge = NULL;
+	gs_unref_object NMConnection *port = NULL;
+	gs_unref_object NMConnection *interface = NULL;
+	guint n_done = 0;
+
+	bridge = _connection_new (NM_SETTING_OVS_BRIDGE_SETTING_NAME, "br0", BRIDGE_CON_UUID);
+	port = _connection_new (NM_SETTING_OVS_PORT_SETTING_NAME, "p1", NULL);
+	interface = _connection_new (NM_SETTING_OVS_INTERFACE_SETTING_NAME, "i1", NULL);
+
+	ovsdb = g_object_new (NM_TYPE_OVSDB, NULL);
+
+	/* removing the last interface removes port "p0" and bridge "br0". A port
+	 * added to the bridge meanwhile must not race with that. */
+	nm_ovsdb_del_interface (ovsdb, "i0", _transact_cb, &n_done);
+	nm_ovsdb_add_interface (ovsdb, bridge, port, interface, _transact_cb, &n_done);
+
+	_iterate_until (mock->n_transacts == 1);
+	_iterate (50);
+	g_assert_cmpint (mock->n_transacts, ==, 1);
+	g_assert_cmpint (_mock_count_ops (mock, 0, "update", "Open_vSwitch"), ==, 1);
+	g_assert_cmpint (_mock_count_ops (mock, 0, "insert", "Port"), ==, 0);
+
+	_mock_reply (mock, 0);
+	_iterate_until (n_done == 1 && mock->n_transacts == 2);
+	g_assert_cmpint (_mock_count_ops (mock, 0, "insert", "Port"), ==, 1);
+
+	_mock_reply (mock, 0);
+	_iterate_until (n_done == 2);
+
+	_teardown (mock, g_steal_pointer (&ovsdb));
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	g_test_add_func ("/ovsdb/pipeline", test_pipeline);
+	g_test_add_func ("/ovsdb/delete-last-port", test_delete_last_port);
+
+	return g_test_run ();
+}
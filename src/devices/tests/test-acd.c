@@ -143,6 +143,35 @@ test_acd_probe_2 (test_fixture *fixture, gconstpointer user_data)
 	test_acd_common (fixture, &info);
 }
 
+static void
+test_acd_probe_start_fail (test_fixture *fixture, gconstpointer user_data)
+{
+	gs_unref_object NMAcdManager *manager = NULL;
+	GMainLoop *loop;
+	gulong signal_id;
+
+	manager = nm_acd_manager_new (fixture->ifindex0, fixture->hwaddr0, fixture->hwaddr0_len);
+	g_assert (manager != NULL);
+
+	/* n-acd refuses to probe 0.0.0.0, so only the first probe starts. */
+	g_assert (nm_acd_manager_add_address (manager, ADDR1));
+	g_assert (nm_acd_manager_add_address (manager, INADDR_ANY));
+
+	loop = g_main_loop_new (NULL, FALSE);
+	signal_id = g_signal_connect (manager, NM_ACD_MANAGER_PROBE_TERMINATED,
+	                              G_CALLBACK (acd_manager_probe_terminated), loop);
+	g_assert (nm_acd_manager_start_probe (manager, 50));
+	g_assert (nmtst_main_loop_run (loop, 2000));
+	g_signal_handler_disconnect (manager, signal_id);
+
+	g_assert (nm_acd_manager_check_address (manager, ADDR1));
+
+	/* the address without probe must not be announced. */
+	nm_acd_manager_announce_addresses (manager);
+	g_assert (!nmtst_main_loop_run (loop, 200));
+	g_main_loop_unref (loop);
+}
+
 static void
 test_acd_announce (test_fixture *fixture, gconstpointer user_data)
 {
@@ -181,5 +210,6 @@ _nmtstp_setup_tests (void)
 {
 	g_test_add ("/acd/probe/1", test_fixture, NULL, fixture_setup, test_acd_probe_1, fixture_teardown);
 	g_test_add ("/acd/probe/2", test_fixture, NULL, fixture_setup, test_acd_probe_2, fixture_teardown);
+	g_test_add ("/acd/probe/start-fail", test_fixture, NULL, fixture_setup, test_acd_probe_start_fail, fixture_teardown);
 	g_test_add ("/acd/announce", test_fixture, NULL, fixture_setup, test_acd_announce, fixture_teardown);
 }
@@ -456,6 +456,53 @@ test_recv (TestRecvFixture *fixture, gconstpointer user_data)
 	g_clear_pointer (&loop, g_main_loop_unref);
 }
 
+static void
+test_recv_duplicate (TestRecvFixture *fixture, gconstpointer user_data)
+{
+	const TestRecvFrame *f = &_test_recv_data0_frame0;
+	gs_unref_object NMLldpListener *listener = NULL;
+	GMainLoop *loop;
+	TestRecvCallbackInfo info = { };
+	gulong notify_id;
+	GError *error = NULL;
+	guint sd_id;
+
+	if (fixture->ifindex == 0) {
+		g_test_skip ("Tun device not available");
+		return;
+	}
+
+	listener = nm_lldp_listener_new ();
+	g_assert (listener != NULL);
+	g_assert (nm_lldp_listener_start (listener, fixture->ifindex, &error));
+	g_assert_no_error (error);
+
+	notify_id = g_signal_connect (listener, "notify::" NM_LLDP_LISTENER_NEIGHBORS,
+	                              (GCallback) lldp_neighbors_changed, &info);
+	loop = g_main_loop_new (NULL, FALSE);
+	sd_id = nm_sd_event_attach_default ();
+
+	g_assert (write (fixture->fd, f->frame, f->frame_len) == f->frame_len);
+	if (nmtst_main_loop_run (loop, 500))
+		g_assert_not_reached ();
+	g_assert_cmpint (info.num_called, ==, 1);
+
+	/* the same frame again, as a switch sends it to refresh the TTL. Had it
+	 * counted as a change, the notification would be delayed by the rate
+	 * limit of 2 seconds, but not dropped. Wait longer than that. */
+	g_assert (write (fixture->fd, f->frame, f->frame_len) == f->frame_len);
+	if (nmtst_main_loop_run (loop, 2500))
+		g_assert_not_reached ();
+	g_assert_cmpint (info.num_called, ==, 1);
+
+	nm_clear_g_signal_handler (listener, &notify_id);
+
+	_test_recv_data0_check (loop, listener);
+
+	nm_clear_g_source (&sd_id);
+	g_clear_pointer (&loop, g_main_loop_unref);
+}
+
 static void
 _test_recv_fixture_teardown (TestRecvFixture *fixture, gconstpointer user_data)
 {
@@ -482,4 +529,6 @@ _nmtstp_setup_tests (void)
 	_TEST_ADD_RECV ("/lldp/recv/0_twice", &_test_recv_data0_twice);
 	_TEST_ADD_RECV ("/lldp/recv/1",       &_test_recv_data1);
 	_TEST_ADD_RECV ("/lldp/recv/2_ttl1",  &_test_recv_data2_ttl1);
+
+	g_test_add ("/lldp/recv/0_duplicate", TestRecvFixture, NULL, _test_recv_fixture_setup, test_recv_duplicate, _test_recv_fixture_teardown);
 }
@@ -65,6 +65,14 @@ _LOG_DECLARE_SELF(NMDeviceWifi);
 
 #define SCAN_RAND_MAC_ADDRESS_EXPIRE_MIN 5
 
+/* Periodic scans of different radios are kept this far apart (milliseconds) */
+#define SCAN_STAGGER_MSEC 1500
+#define SCAN_STAGGER_MAX_DEFER 5
+
+/* Scan results of other radios younger than this are considered when
+ * looking for autoconnect candidates (milliseconds) */
+#define SCAN_PEER_RESULTS_MAX_AGE_MSEC (30 * NM_UTILS_MSEC_PER_SECOND)
+
 /*****************************************************************************/
 
 NM_GOBJECT_PROPERTIES_DEFINE (NMDeviceWifi,
@@ -89,6 +97,9 @@ typedef struct {
 	gint8             invalid_strength_counter;
 
 	CList             aps_lst_head;
+	GHashTable       *aps_idx_by_supplicant_path; /* also has the pending APs */
+	GPtrArray        *aps_pending; /* scanned APs, not yet exported */
+	guint             aps_batch_id;
 
 	NMWifiAP *        current_ap;
 	guint32           rate;
@@ -96,13 +107,22 @@ typedef struct {
 	bool              requested_scan:1;
 	bool              ssid_found:1;
 	bool              is_scanning:1;
+	bool              aps_batch_changed:1;
 
 	gint64            last_scan; /* milliseconds */
 	gint32            scheduled_scan_time; /* seconds */
 	guint8            scan_interval; /* seconds */
+	guint8            scan_stagger_count;
 	guint             pending_scan_id;
 	guint             ap_dump_id;
 
+	CList             scan_coord_lst;
+	gint64            scan_request_ms; /* when the running scan was requested, or zero */
+	gint64            scan_peer_hint_ms; /* last_scan of the peer that triggered the last rescan */
+	guint             scan_latency_ms;
+	guint             scan_latency_avg_ms;
+	guint             scan_n_results;
+
 	NMSupplicantManager   *sup_mgr;
 	NMSupplicantInterface *sup_iface;
 	guint                  sup_timeout_id; /* supplicant association timeout */
@@ -151,6 +171,20 @@ static gboolean check_scanning_prohibited (NMDeviceWifi *self, gboolean periodic
 
 static void schedule_scan (NMDeviceWifi *self, gboolean backoff);
 
+static guint _scan_coord_stagger_delay (NMDeviceWifi *self);
+
+/*****************************************************************************/
+
+/* All Wi-Fi devices share one scan coordinator. It staggers the periodic
+ * scans of the radios and lets a radio learn from the results of the
+ * others. */
+static struct {
+	CList devices_lst_head;
+	gint64 last_start_ms;
+} _scan_coord = {
+	.devices_lst_head = C_LIST_INIT (_scan_coord.devices_lst_head),
+};
+
 static void cleanup_association_attempt (NMDeviceWifi * self,
                                          gboolean disconnect);
 
@@ -197,6 +231,8 @@ static void ap_add_remove (NMDeviceWifi *self,
 
 static void _hw_addr_set_scanning (NMDeviceWifi *self, gboolean do_reset);
 
+static void _aps_batch_schedule (NMDeviceWifi *self);
+
 /*****************************************************************************/
 
 static void
@@ -229,6 +265,11 @@ _notify_scanning (NMDeviceWifi *self)
 	_LOGD (LOGD_WIFI, "wifi-scan: scanning-state: %s", scanning ? "scanning" : "idle");
 	priv->is_scanning = scanning;
 	_notify (self, PROP_SCANNING);
+
+	/* announce the APs of the scan, in case we don't get a scan-done. */
+	if (   !scanning
+	    && priv->aps_batch_changed)
+		_aps_batch_schedule (self);
 }
 
 static gboolean
@@ -328,6 +369,8 @@ supplicant_interface_release (NMDeviceWifi *self)
 	_requested_scan_set (self, FALSE);
 
 	nm_clear_g_source (&priv->pending_scan_id);
+	priv->scan_request_ms = 0;
+	priv->scan_stagger_count = 0;
 
 	/* Reset the scan interval to be pretty frequent when disconnected */
 	priv->scan_interval = SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP;
@@ -460,26 +503,61 @@ periodic_update_cb (gpointer user_data)
 	return TRUE;
 }
 
+static void
+_ap_idx_add (NMDeviceWifi *self, NMWifiAP *ap)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	const char *path = nm_wifi_ap_get_supplicant_path (ap);
+
+	/* the path of an AP never changes, the AP owns the key. */
+	if (path)
+		g_hash_table_replace (priv->aps_idx_by_supplicant_path, (gpointer) path, ap);
+}
+
+static void
+_ap_idx_remove (NMDeviceWifi *self, NMWifiAP *ap)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	const char *path = nm_wifi_ap_get_supplicant_path (ap);
+
+	if (   path
+	    && g_hash_table_lookup (priv->aps_idx_by_supplicant_path, path) == ap)
+		g_hash_table_remove (priv->aps_idx_by_supplicant_path, path);
+}
+
+static void
+_ap_link (NMDeviceWifi *self, NMWifiAP *ap)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	g_object_ref (ap);
+	ap->wifi_device = NM_DEVICE (self);
+	c_list_link_tail (&priv->aps_lst_head, &ap->aps_lst);
+	_ap_idx_add (self, ap);
+	nm_dbus_object_export (NM_DBUS_OBJECT (ap));
+	_ap_dump (self, LOGL_DEBUG, ap, "added", 0);
+}
+
+static void
+_ap_unlink (NMDeviceWifi *self, NMWifiAP *ap)
+{
+	ap->wifi_device = NULL;
+	c_list_unlink (&ap->aps_lst);
+	_ap_idx_remove (self, ap);
+	_ap_dump (self, LOGL_DEBUG, ap, "removed", 0);
+}
+
 static void
 ap_add_remove (NMDeviceWifi *self,
                gboolean is_adding, /* or else removing */
                NMWifiAP *ap,
                gboolean recheck_available_connections)
 {
-	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-
 	if (is_adding) {
-		g_object_ref (ap);
-		ap->wifi_device = NM_DEVICE (self);
-		c_list_link_tail (&priv->aps_lst_head, &ap->aps_lst);
-		nm_dbus_object_export (NM_DBUS_OBJECT (ap));
-		_ap_dump (self, LOGL_DEBUG, ap, "added", 0);
+		_ap_link (self, ap);
 		nm_device_wifi_emit_signal_access_point (NM_DEVICE (self), ap, TRUE);
-	} else {
-		ap->wifi_device = NULL;
-		c_list_unlink (&ap->aps_lst);
-		_ap_dump (self, LOGL_DEBUG, ap, "removed", 0);
-	}
+	} else
+		_ap_unlink (self, ap);
 
 	_notify (self, PROP_ACCESS_POINTS);
 
@@ -493,12 +571,89 @@ ap_add_remove (NMDeviceWifi *self,
 		nm_device_recheck_available_connections (NM_DEVICE (self));
 }
 
+/*****************************************************************************/
+
+/* The APs of a scan are collected while the scan is running, and announced
+ * in one batch once it is done: the new APs get exported, and the
+ * AccessPoints property notified, only once per batch. Until then, the
+ * pending APs are only reachable via the supplicant path index. */
+
+static void
+_aps_batch_flush (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	gs_unref_ptrarray GPtrArray *added = NULL;
+	guint i;
+
+	nm_clear_g_source (&priv->aps_batch_id);
+
+	if (!priv->aps_batch_changed)
+		return;
+	priv->aps_batch_changed = FALSE;
+
+	if (priv->aps_pending->len) {
+		added = g_steal_pointer (&priv->aps_pending);
+		priv->aps_pending = g_ptr_array_new_with_free_func (g_object_unref);
+		for (i = 0; i < added->len; i++)
+			_ap_link (self, added->pdata[i]);
+		_LOGD (LOGD_WIFI_SCAN, "wifi-scan: %u new APs", added->len);
+	}
+
+	_notify (self, PROP_ACCESS_POINTS);
+
+	if (added) {
+		for (i = 0; i < added->len; i++)
+			nm_device_wifi_emit_signal_access_point (NM_DEVICE (self), added->pdata[i], TRUE);
+	}
+
+	nm_device_emit_recheck_auto_activate (NM_DEVICE (self));
+	nm_device_recheck_available_connections (NM_DEVICE (self));
+}
+
+static gboolean
+_aps_batch_flush_cb (gpointer user_data)
+{
+	NMDeviceWifi *self = user_data;
+
+	NM_DEVICE_WIFI_GET_PRIVATE (self)->aps_batch_id = 0;
+	_aps_batch_flush (self);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_aps_batch_schedule (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	priv->aps_batch_changed = TRUE;
+
+	/* While scanning, wait for the scan to complete. */
+	if (   !priv->is_scanning
+	    && !priv->aps_batch_id)
+		priv->aps_batch_id = g_idle_add (_aps_batch_flush_cb, self);
+}
+
+static void
+_aps_batch_clear (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	guint i;
+
+	nm_clear_g_source (&priv->aps_batch_id);
+	priv->aps_batch_changed = FALSE;
+	for (i = 0; i < priv->aps_pending->len; i++)
+		_ap_idx_remove (self, priv->aps_pending->pdata[i]);
+	g_ptr_array_set_size (priv->aps_pending, 0);
+}
+
 static void
 remove_all_aps (NMDeviceWifi *self)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	NMWifiAP *ap;
 
+	_aps_batch_clear (self);
+
 	if (c_list_is_empty (&priv->aps_lst_head))
 		return;
 
@@ -1376,6 +1531,10 @@ request_wireless_scan (NMDeviceWifi *self,
 		                                      ssids ? (GBytes *const*) ssids->pdata : NULL,
 		                                      ssids ? ssids->len : 0u);
 		request_started = TRUE;
+
+		priv->scan_request_ms = nm_utils_get_monotonic_timestamp_ms ();
+		priv->scan_stagger_count = 0;
+		_scan_coord.last_start_ms = priv->scan_request_ms;
 	} else
 		_LOGD (LOGD_WIFI, "wifi-scan: scanning requested but not allowed at this time");
 
@@ -1389,8 +1548,18 @@ request_wireless_scan_periodic (gpointer user_data)
 {
 	NMDeviceWifi *self = user_data;
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	guint delay;
 
 	priv->pending_scan_id = 0;
+
+	delay = _scan_coord_stagger_delay (self);
+	if (delay > 0) {
+		priv->scan_stagger_count++;
+		_LOGD (LOGD_WIFI, "wifi-scan: another radio is scanning, deferring by %u msec", delay);
+		priv->pending_scan_id = g_timeout_add (delay, request_wireless_scan_periodic, self);
+		return G_SOURCE_REMOVE;
+	}
+
 	request_wireless_scan (self, TRUE, FALSE, NULL);
 	return G_SOURCE_REMOVE;
 }
@@ -1443,6 +1612,186 @@ schedule_scan (NMDeviceWifi *self, gboolean backoff)
 	}
 }
 
+static gboolean
+_scan_coord_freq_supported (NMDeviceWifi *self, guint32 freq)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (!(priv->capabilities & NM_WIFI_DEVICE_CAP_FREQ_VALID))
+		return TRUE;
+	if (freq < 4000)
+		return NM_FLAGS_HAS (priv->capabilities, NM_WIFI_DEVICE_CAP_FREQ_2GHZ);
+	return NM_FLAGS_HAS (priv->capabilities, NM_WIFI_DEVICE_CAP_FREQ_5GHZ);
+}
+
+/* Returns the number of milliseconds a periodic scan of @self should be
+ * deferred so that it doesn't overlap with the scan of another radio. */
+static guint
+_scan_coord_stagger_delay (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMDeviceWifiPrivate *peer_priv;
+	gint64 now_ms;
+	gint64 delay = 0;
+
+	if (priv->scan_stagger_count >= SCAN_STAGGER_MAX_DEFER)
+		return 0;
+
+	now_ms = nm_utils_get_monotonic_timestamp_ms ();
+
+	if (_scan_coord.last_start_ms)
+		delay = _scan_coord.last_start_ms + SCAN_STAGGER_MSEC - now_ms;
+
+	c_list_for_each_entry (peer_priv, &_scan_coord.devices_lst_head, scan_coord_lst) {
+		if (   peer_priv != priv
+		    && peer_priv->requested_scan) {
+			delay = MAX (delay, SCAN_STAGGER_MSEC);
+			break;
+		}
+	}
+
+	return delay > 0 ? (guint) delay : 0u;
+}
+
+/* Checks whether another radio recently saw an AP that is suitable for
+ * @connection on a band that @self supports. In that case @self should
+ * rescan soon instead of waiting for its backoff. Every peer scan gives
+ * at most one hint. */
+static gboolean
+_scan_coord_peer_has_candidate (NMDeviceWifi *self, NMConnection *connection)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMDeviceWifiPrivate *peer_priv;
+	gint64 now_ms = 0;
+
+	c_list_for_each_entry (peer_priv, &_scan_coord.devices_lst_head, scan_coord_lst) {
+		NMWifiAP *ap;
+
+		if (   peer_priv == priv
+		    || !peer_priv->last_scan
+		    || peer_priv->last_scan <= priv->scan_peer_hint_ms)
+			continue;
+
+		if (!now_ms)
+			now_ms = nm_utils_get_monotonic_timestamp_ms ();
+		if (now_ms - peer_priv->last_scan > SCAN_PEER_RESULTS_MAX_AGE_MSEC)
+			continue;
+
+		c_list_for_each_entry (ap, &peer_priv->aps_lst_head, aps_lst) {
+			if (   _scan_coord_freq_supported (self, nm_wifi_ap_get_freq (ap))
+			    && nm_wifi_ap_check_compatible (ap, connection)) {
+				priv->scan_peer_hint_ms = peer_priv->last_scan;
+				return TRUE;
+			}
+		}
+	}
+
+	return FALSE;
+}
+
+static gboolean
+_scan_coord_autoconnect_filter_func (NMSettings *settings,
+                                     NMSettingsConnection *set_con,
+                                     gpointer user_data)
+{
+	NMConnection *connection = nm_settings_connection_get_connection (set_con);
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+
+	if (!nm_connection_is_type (connection, NM_SETTING_WIRELESS_SETTING_NAME))
+		return FALSE;
+	s_con = nm_connection_get_setting_connection (connection);
+	if (!s_con || !nm_setting_connection_get_autoconnect (s_con))
+		return FALSE;
+	s_wifi = nm_connection_get_setting_wireless (connection);
+	if (!s_wifi)
+		return FALSE;
+	return !nm_streq0 (nm_setting_wireless_get_mode (s_wifi), NM_SETTING_WIRELESS_MODE_AP);
+}
+
+static gboolean
+_scan_coord_peer_hint_wanted (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMDevice *device = NM_DEVICE (self);
+
+	return    priv->sup_iface
+	       && !priv->requested_scan
+	       && nm_device_get_state (device) == NM_DEVICE_STATE_DISCONNECTED
+	       && nm_device_autoconnect_allowed (device);
+}
+
+/* Called after another radio finished a scan. If it saw an AP for one of
+ * the @connections that @self could autoconnect, rescan soon instead of
+ * waiting for the backoff. */
+static void
+_scan_coord_check_peer_hint (NMDeviceWifi *self, NMSettingsConnection *const*connections)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMDevice *device = NM_DEVICE (self);
+	guint i;
+
+	for (i = 0; connections[i]; i++) {
+		NMConnection *connection = nm_settings_connection_get_connection (connections[i]);
+
+		if (!nm_device_check_connection_compatible (device, connection, NULL))
+			continue;
+		if (!_scan_coord_peer_has_candidate (self, connection))
+			continue;
+
+		_LOGD (LOGD_WIFI, "wifi-scan: another radio sees a candidate for '%s', rescan soon",
+		       nm_connection_get_id (connection));
+		priv->scan_interval = SCAN_INTERVAL_MIN;
+		schedule_scan (self, FALSE);
+		return;
+	}
+}
+
+static void
+_scan_coord_scan_done (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMDeviceWifiPrivate *peer_priv;
+	gs_free NMSettingsConnection **connections = NULL;
+
+	priv->scan_n_results = c_list_length (&priv->aps_lst_head);
+
+	c_list_for_each_entry (peer_priv, &_scan_coord.devices_lst_head, scan_coord_lst) {
+		NMDeviceWifi *peer;
+
+		if (peer_priv == priv)
+			continue;
+
+		peer = c_list_entry (&peer_priv->scan_coord_lst, NMDeviceWifi, _priv.scan_coord_lst);
+		if (!_scan_coord_peer_hint_wanted (peer))
+			continue;
+
+		/* the candidate connections are the same for every radio. Only
+		 * collect them once per scan, and only if some radio waits for them. */
+		if (!connections) {
+			connections = nm_settings_get_connections_clone (nm_device_get_settings (NM_DEVICE (self)),
+			                                                 NULL,
+			                                                 _scan_coord_autoconnect_filter_func, NULL,
+			                                                 NULL, NULL);
+		}
+		_scan_coord_check_peer_hint (peer, connections);
+	}
+
+	if (!priv->scan_request_ms)
+		return;
+
+	priv->scan_latency_ms = priv->last_scan - priv->scan_request_ms;
+	priv->scan_latency_avg_ms =   priv->scan_latency_avg_ms
+	                            ? (priv->scan_latency_avg_ms * 7 + priv->scan_latency_ms) / 8
+	                            : priv->scan_latency_ms;
+	priv->scan_request_ms = 0;
+
+	_LOGD (LOGD_WIFI, "wifi-scan: scan took %u msec (average %u msec), %u APs known",
+	       priv->scan_latency_ms,
+	       priv->scan_latency_avg_ms,
+	       priv->scan_n_results);
+}
+
 static void
 supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
                                gboolean success,
@@ -1452,7 +1801,10 @@ supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
 
 	_LOGD (LOGD_WIFI, "wifi-scan: scan-done callback: %s", success ? "successful" : "failed");
 
+	_aps_batch_flush (self);
+
 	priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
+	_scan_coord_scan_done (self);
 	_notify (self, PROP_LAST_SCAN);
 	schedule_scan (self, success);
 
@@ -1476,10 +1828,13 @@ ap_list_dump (gpointer user_data)
 		NMWifiAP *ap;
 		gint32 now_s = nm_utils_get_monotonic_timestamp_s ();
 
-		_LOGD (LOGD_WIFI_SCAN, "APs: [now:%u last:%" G_GINT64_FORMAT " next:%u]",
+		_LOGD (LOGD_WIFI_SCAN, "APs: [now:%u last:%" G_GINT64_FORMAT " next:%u latency:%u avg-latency:%u results:%u]",
 		       now_s,
 		       priv->last_scan / NM_UTILS_MSEC_PER_SECOND,
-		       priv->scheduled_scan_time);
+		       priv->scheduled_scan_time,
+		       priv->scan_latency_ms,
+		       priv->scan_latency_avg_ms,
+		       priv->scan_n_results);
 		c_list_for_each_entry (ap, &priv->aps_lst_head, aps_lst)
 			_ap_dump (self, LOGL_DEBUG, ap, "dump", now_s);
 	}
@@ -1501,8 +1856,8 @@ try_fill_ssid_for_hidden_ap (NMDeviceWifi *self,
                              NMWifiAP *ap)
 {
 	const char *bssid;
-	NMSettingsConnection *const*connections;
-	guint i;
+	NMSettingsConnection *sett_conn;
+	NMSettingWireless *s_wifi;
 
 	g_return_if_fail (nm_wifi_ap_get_ssid (ap) == NULL);
 
@@ -1511,19 +1866,12 @@ try_fill_ssid_for_hidden_ap (NMDeviceWifi *self,
 
 	/* Look for this AP's BSSID in the seen-bssids list of a connection,
 	 * and if a match is found, copy over the SSID */
-	connections = nm_settings_get_connections (nm_device_get_settings ((NMDevice *) self), NULL);
-	for (i = 0; connections[i]; i++) {
-		NMSettingsConnection *sett_conn = connections[i];
-		NMSettingWireless *s_wifi;
+	sett_conn = nm_settings_get_connection_by_seen_bssid (nm_device_get_settings ((NMDevice *) self), bssid);
+	if (!sett_conn)
+		return;
 
-		s_wifi = nm_connection_get_setting_wireless (nm_settings_connection_get_connection (sett_conn));
-		if (s_wifi) {
-			if (nm_settings_connection_has_seen_bssid (sett_conn, bssid)) {
-				nm_wifi_ap_set_ssid (ap, nm_setting_wireless_get_ssid (s_wifi));
-				break;
-			}
-		}
-	}
+	s_wifi = nm_connection_get_setting_wireless (nm_settings_connection_get_connection (sett_conn));
+	nm_wifi_ap_set_ssid (ap, nm_setting_wireless_get_ssid (s_wifi));
 }
 
 static void
@@ -1548,7 +1896,7 @@ supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
 	if (NM_DEVICE_WIFI_GET_PRIVATE (self)->mode == NM_802_11_MODE_AP)
 		return;
 
-	found_ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, object_path);
+	found_ap = g_hash_table_lookup (priv->aps_idx_by_supplicant_path, object_path);
 	if (found_ap) {
 		if (!nm_wifi_ap_update_from_properties (found_ap, object_path, properties))
 			return;
@@ -1584,7 +1932,9 @@ supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
 			}
 		}
 
-		ap_add_remove (self, TRUE, ap, TRUE);
+		g_ptr_array_add (priv->aps_pending, g_object_ref (ap));
+		_ap_idx_add (self, ap);
+		_aps_batch_schedule (self);
 	}
 
 	/* Update the current AP if the supplicant notified a current BSS change
@@ -1608,10 +1958,17 @@ supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
 	g_return_if_fail (object_path != NULL);
 
 	priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, object_path);
+	ap = g_hash_table_lookup (priv->aps_idx_by_supplicant_path, object_path);
 	if (!ap)
 		return;
 
+	if (!c_list_is_linked (&ap->aps_lst)) {
+		/* not yet announced, just forget about it. */
+		_ap_idx_remove (self, ap);
+		g_ptr_array_remove (priv->aps_pending, ap);
+		return;
+	}
+
 	if (ap == priv->current_ap) {
 		/* The current AP cannot be removed (to prevent NM indicating that
 		 * it is connected, but to nothing), but it must be removed later
@@ -1621,7 +1978,10 @@ supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
 		if (nm_wifi_ap_set_fake (ap, TRUE))
 			_ap_dump (self, LOGL_DEBUG, ap, "updated", 0);
 	} else {
-		ap_add_remove (self, FALSE, ap, TRUE);
+		_ap_unlink (self, ap);
+		nm_device_wifi_emit_signal_access_point (NM_DEVICE (self), ap, FALSE);
+		nm_dbus_object_clear_and_unexport (&ap);
+		_aps_batch_schedule (self);
 		schedule_ap_list_dump (self);
 	}
 }
@@ -2152,8 +2512,15 @@ supplicant_iface_notify_current_bss (NMSupplicantInterface *iface,
 	NMWifiAP *new_ap = NULL;
 
 	current_bss = nm_supplicant_interface_get_current_bss (iface);
-	if (current_bss)
-		new_ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, current_bss);
+	if (current_bss) {
+		new_ap = g_hash_table_lookup (priv->aps_idx_by_supplicant_path, current_bss);
+		if (   new_ap
+		    && !c_list_is_linked (&new_ap->aps_lst)) {
+			/* the AP is still pending in the scan batch. Announce it first. */
+			_aps_batch_flush (self);
+			new_ap = g_hash_table_lookup (priv->aps_idx_by_supplicant_path, current_bss);
+		}
+	}
 
 	if (new_ap != priv->current_ap) {
 		const char *new_bssid = NULL;
@@ -3243,6 +3610,9 @@ nm_device_wifi_init (NMDeviceWifi *self)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	c_list_init (&priv->aps_lst_head);
+	priv->aps_idx_by_supplicant_path = g_hash_table_new (nm_str_hash, g_str_equal);
+	priv->aps_pending = g_ptr_array_new_with_free_func (g_object_unref);
+	c_list_link_tail (&_scan_coord.devices_lst_head, &priv->scan_coord_lst);
 
 	priv->mode = NM_802_11_MODE_INFRA;
 	priv->wowlan_restore = NM_SETTING_WIRELESS_WAKE_ON_WLAN_IGNORE;
@@ -3304,6 +3674,11 @@ finalize (GObject *object)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	nm_assert (c_list_is_empty (&priv->aps_lst_head));
+	nm_assert (g_hash_table_size (priv->aps_idx_by_supplicant_path) == 0);
+
+	g_hash_table_unref (priv->aps_idx_by_supplicant_path);
+	g_ptr_array_unref (priv->aps_pending);
+	c_list_unlink_stale (&priv->scan_coord_lst);
 
 	G_OBJECT_CLASS (nm_device_wifi_parent_class)->finalize (object);
 }
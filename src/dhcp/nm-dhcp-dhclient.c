@@ -685,10 +685,16 @@ nm_dhcp_dhclient_init (NMDhcpDhclient *self)
 	}
 
 	priv->dhcp_listener = g_object_ref (nm_dhcp_listener_get ());
-	g_signal_connect (priv->dhcp_listener,
-	                  NM_DHCP_LISTENER_EVENT,
-	                  G_CALLBACK (nm_dhcp_client_handle_event),
-	                  self);
+}
+
+static void
+constructed (GObject *object)
+{
+	NMDhcpDhclientPrivate *priv = NM_DHCP_DHCLIENT_GET_PRIVATE ((NMDhcpDhclient *) object);
+
+	G_OBJECT_CLASS (nm_dhcp_dhclient_parent_class)->constructed (object);
+
+	nm_dhcp_listener_add_client (priv->dhcp_listener, NM_DHCP_CLIENT (object));
 }
 
 static void
@@ -697,9 +703,7 @@ dispose (GObject *object)
 	NMDhcpDhclientPrivate *priv = NM_DHCP_DHCLIENT_GET_PRIVATE ((NMDhcpDhclient *) object);
 
 	if (priv->dhcp_listener) {
-		g_signal_handlers_disconnect_by_func (priv->dhcp_listener,
-		                                      G_CALLBACK (nm_dhcp_client_handle_event),
-		                                      NM_DHCP_DHCLIENT (object));
+		nm_dhcp_listener_remove_client (priv->dhcp_listener, NM_DHCP_CLIENT (object));
 		g_clear_object (&priv->dhcp_listener);
 	}
 
@@ -716,6 +720,7 @@ nm_dhcp_dhclient_class_init (NMDhcpDhclientClass *dhclient_class)
 	NMDhcpClientClass *client_class = NM_DHCP_CLIENT_CLASS (dhclient_class);
 	GObjectClass *object_class = G_OBJECT_CLASS (dhclient_class);
 
+	object_class->constructed = constructed;
 	object_class->dispose = dispose;
 
 	client_class->ip4_start = ip4_start;
@@ -236,10 +236,16 @@ nm_dhcp_dhcpcanon_init (NMDhcpDhcpcanon *self)
 	NMDhcpDhcpcanonPrivate *priv = NM_DHCP_DHCPCANON_GET_PRIVATE (self);
 
 	priv->dhcp_listener = g_object_ref (nm_dhcp_listener_get ());
-	g_signal_connect (priv->dhcp_listener,
-	                  NM_DHCP_LISTENER_EVENT,
-	                  G_CALLBACK (nm_dhcp_client_handle_event),
-	                  self);
+}
+
+static void
+constructed (GObject *object)
+{
+	NMDhcpDhcpcanonPrivate *priv = NM_DHCP_DHCPCANON_GET_PRIVATE ((NMDhcpDhcpcanon *) object);
+
+	G_OBJECT_CLASS (nm_dhcp_dhcpcanon_parent_class)->constructed (object);
+
+	nm_dhcp_listener_add_client (priv->dhcp_listener, NM_DHCP_CLIENT (object));
 }
 
 static void
@@ -248,9 +254,7 @@ dispose (GObject *object)
 	NMDhcpDhcpcanonPrivate *priv = NM_DHCP_DHCPCANON_GET_PRIVATE ((NMDhcpDhcpcanon *) object);
 
 	if (priv->dhcp_listener) {
-		g_signal_handlers_disconnect_by_func (priv->dhcp_listener,
-		                                      G_CALLBACK (nm_dhcp_client_handle_event),
-		                                      NM_DHCP_DHCPCANON (object));
+		nm_dhcp_listener_remove_client (priv->dhcp_listener, NM_DHCP_CLIENT (object));
 		g_clear_object (&priv->dhcp_listener);
 	}
 
@@ -265,6 +269,7 @@ nm_dhcp_dhcpcanon_class_init (NMDhcpDhcpcanonClass *dhcpcanon_class)
 	NMDhcpClientClass *client_class = NM_DHCP_CLIENT_CLASS (dhcpcanon_class);
 	GObjectClass *object_class = G_OBJECT_CLASS (dhcpcanon_class);
 
+	object_class->constructed = constructed;
 	object_class->dispose = dispose;
 
 	client_class->ip4_start = ip4_start;
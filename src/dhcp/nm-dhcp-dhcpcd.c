@@ -219,10 +219,16 @@ nm_dhcp_dhcpcd_init (NMDhcpDhcpcd *self)
 	NMDhcpDhcpcdPrivate *priv = NM_DHCP_DHCPCD_GET_PRIVATE (self);
 
 	priv->dhcp_listener = g_object_ref (nm_dhcp_listener_get ());
-	g_signal_connect (priv->dhcp_listener,
-	                  NM_DHCP_LISTENER_EVENT,
-	                  G_CALLBACK (nm_dhcp_client_handle_event),
-	                  self);
+}
+
+static void
+constructed (GObject *object)
+{
+	NMDhcpDhcpcdPrivate *priv = NM_DHCP_DHCPCD_GET_PRIVATE ((NMDhcpDhcpcd *) object);
+
+	G_OBJECT_CLASS (nm_dhcp_dhcpcd_parent_class)->constructed (object);
+
+	nm_dhcp_listener_add_client (priv->dhcp_listener, NM_DHCP_CLIENT (object));
 }
 
 static void
@@ -231,9 +237,7 @@ dispose (GObject *object)
 	NMDhcpDhcpcdPrivate *priv = NM_DHCP_DHCPCD_GET_PRIVATE ((NMDhcpDhcpcd *) object);
 
 	if (priv->dhcp_listener) {
-		g_signal_handlers_disconnect_by_func (priv->dhcp_listener,
-		                                      G_CALLBACK (nm_dhcp_client_handle_event),
-		                                      NM_DHCP_DHCPCD (object));
+		nm_dhcp_listener_remove_client (priv->dhcp_listener, NM_DHCP_CLIENT (object));
 		g_clear_object (&priv->dhcp_listener);
 	}
 
@@ -248,6 +252,7 @@ nm_dhcp_dhcpcd_class_init (NMDhcpDhcpcdClass *dhcpcd_class)
 	NMDhcpClientClass *client_class = NM_DHCP_CLIENT_CLASS (dhcpcd_class);
 	GObjectClass *object_class = G_OBJECT_CLASS (dhcpcd_class);
 
+	object_class->constructed = constructed;
 	object_class->dispose = dispose;
 
 	client_class->ip4_start = ip4_start;
@@ -33,4 +33,27 @@
 
 /*****************************************************************************/
 
+/* Besides the D-Bus Notify, the helper can report an event as a single
+ * datagram on a unix socket. The datagram starts with a 32 bit
+ * NM_DHCP_HELPER_EVENT_MAGIC, followed by records of
+ * NMDhcpHelperEventTlv, each followed by the name and value bytes.
+ * All integers are in host byte order. */
+
+#define NM_DHCP_HELPER_EVENT_SOCKET_PATH        NMRUNDIR "/private-dhcp-event"
+
+#define NM_DHCP_HELPER_EVENT_MAGIC              ((guint32) 0x4e4d4431u)
+#define NM_DHCP_HELPER_EVENT_MAX_SIZE           (64 * 1024)
+
+typedef enum {
+	NM_DHCP_HELPER_EVENT_TLV_OPTION = 1,
+} NMDhcpHelperEventTlvType;
+
+typedef struct {
+	guint16 type;
+	guint16 name_len;
+	guint32 value_len;
+} NMDhcpHelperEventTlv;
+
+/*****************************************************************************/
+
 #endif /* __NM_DHCP_HELPER_API_H__ */
@@ -21,9 +21,12 @@
 #include "nm-default.h"
 
 #include <unistd.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "nm-utils/nm-vpn-plugin-macros.h"
 
@@ -64,6 +67,105 @@
 
 static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
 
+/* Splits the environment entry @item on the '='. Returns FALSE for entries
+ * that are not DHCP related. */
+static gboolean
+env_item_split (const char *item, const char **out_name, gsize *out_name_len, const char **out_val)
+{
+	const char *val, **p;
+
+	val = strchr (item, '=');
+	if (!val || val == item)
+		return FALSE;
+
+	/* Ignore non-DCHP-related environment variables */
+	for (p = ignore; *p; p++) {
+		if (strncmp (item, *p, strlen (*p)) == 0)
+			return FALSE;
+	}
+
+	*out_name = item;
+	*out_name_len = val - item;
+	*out_val = &val[1];
+	return TRUE;
+}
+
+static GByteArray *
+build_event_datagram (void)
+{
+	GByteArray *buf;
+	const guint32 magic = NM_DHCP_HELPER_EVENT_MAGIC;
+	char **item;
+
+	buf = g_byte_array_sized_new (4096);
+	g_byte_array_append (buf, (const guint8 *) &magic, sizeof (magic));
+
+	for (item = environ; *item; item++) {
+		NMDhcpHelperEventTlv tlv;
+		const char *name, *val;
+		gsize name_len, val_len;
+
+		if (!env_item_split (*item, &name, &name_len, &val))
+			continue;
+
+		val_len = strlen (val);
+		if (name_len > G_MAXUINT16)
+			continue;
+
+		tlv.type = NM_DHCP_HELPER_EVENT_TLV_OPTION;
+		tlv.name_len = name_len;
+		tlv.value_len = val_len;
+		g_byte_array_append (buf, (const guint8 *) &tlv, sizeof (tlv));
+		g_byte_array_append (buf, (const guint8 *) name, name_len);
+		g_byte_array_append (buf, (const guint8 *) val, val_len);
+	}
+
+	return buf;
+}
+
+/* Sends the event as one datagram. That avoids the setup of a D-Bus
+ * connection for every lease event. */
+static gboolean
+send_event_datagram (void)
+{
+	GByteArray *buf;
+	struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+		.sun_path = NM_DHCP_HELPER_EVENT_SOCKET_PATH,
+	};
+	const struct timeval timeout = { .tv_sec = 1 };
+	nm_auto_close int fd = -1;
+	gssize r;
+	int errsv;
+
+	buf = build_event_datagram ();
+	if (buf->len > NM_DHCP_HELPER_EVENT_MAX_SIZE) {
+		_LOGi ("event too large for datagram (%u bytes)", buf->len);
+		g_byte_array_unref (buf);
+		return FALSE;
+	}
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		errsv = errno;
+		_LOGi ("could not create event socket: %s", g_strerror (errsv));
+		g_byte_array_unref (buf);
+		return FALSE;
+	}
+
+	setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout));
+
+	r = sendto (fd, buf->data, buf->len, 0, (struct sockaddr *) &addr, sizeof (addr));
+	errsv = errno;
+	g_byte_array_unref (buf);
+	if (r < 0) {
+		/* an older NetworkManager doesn't have the socket. */
+		_LOGi ("could not send event datagram: %s", g_strerror (errsv));
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static GVariant *
 build_signal_parameters (void)
 {
@@ -74,20 +176,14 @@ build_signal_parameters (void)
 
 	/* List environment and format for dbus dict */
 	for (item = environ; *item; item++) {
-		char *name, *val, **p;
-
-		/* Split on the = */
-		name = g_strdup (*item);
-		val = strchr (name, '=');
-		if (!val || val == name)
-			goto next;
-		*val++ = '\0';
-
-		/* Ignore non-DCHP-related environment variables */
-		for (p = (char **) ignore; *p; p++) {
-			if (strncmp (name, *p, strlen (*p)) == 0)
-				goto next;
-		}
+		const char *name_ptr, *val;
+		gsize name_len;
+		gs_free char *name = NULL;
+
+		if (!env_item_split (*item, &name_ptr, &name_len, &val))
+			continue;
+
+		name = g_strndup (name_ptr, name_len);
 
 		/* Value passed as a byte array rather than a string, because there are
 		 * no character encoding guarantees with DHCP, and D-Bus requires
@@ -100,9 +196,6 @@ build_signal_parameters (void)
 		                       name,
 		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
 		                                                  val, strlen (val), 1));
-
-	next:
-		g_free (name);
 	}
 
 	return g_variant_ref_sink (g_variant_new ("(a{sv})", &builder));
@@ -134,6 +227,9 @@ main (int argc, char *argv[])
 	guint try_count = 0;
 	gint64 time_end;
 
+	if (send_event_datagram ())
+		return EXIT_SUCCESS;
+
 	/* FIXME: g_dbus_connection_new_for_address_sync() tries to connect to the socket in
 	 * non-blocking mode, which can easily fail with EAGAIN, causing the creation of the
 	 * socket to fail with "Could not connect: Resource temporarily unavailable".
@@ -22,6 +22,8 @@
 #include "nm-dhcp-listener.h"
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <string.h>
@@ -64,6 +66,13 @@ typedef struct {
 	gulong              new_conn_id;
 	gulong              dis_conn_id;
 	GHashTable *        connections;
+
+	/* iface => GPtrArray of NMDhcpClient */
+	GHashTable *        clients_by_iface;
+
+	int                 event_fd;
+	GIOChannel *        event_channel;
+	guint               event_id;
 } NMDhcpListenerPrivate;
 
 struct _NMDhcpListener {
@@ -75,12 +84,6 @@ struct _NMDhcpListenerClass {
 	GObjectClass parent;
 };
 
-enum {
-	EVENT,
-	LAST_SIGNAL
-};
-static guint signals[LAST_SIGNAL] = { 0 };
-
 G_DEFINE_TYPE (NMDhcpListener, nm_dhcp_listener, G_TYPE_OBJECT)
 
 #define NM_DHCP_LISTENER_GET_PRIVATE(self) _NM_GET_PRIVATE(self, NMDhcpListener, NM_IS_DHCP_LISTENER)
@@ -138,6 +141,79 @@ get_option (GVariant *options, const char *key)
 	return converted;
 }
 
+void
+nm_dhcp_listener_add_client (NMDhcpListener *self, NMDhcpClient *client)
+{
+	NMDhcpListenerPrivate *priv;
+	const char *iface;
+	GPtrArray *clients;
+
+	g_return_if_fail (NM_IS_DHCP_LISTENER (self));
+	g_return_if_fail (NM_IS_DHCP_CLIENT (client));
+
+	priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	iface = nm_dhcp_client_get_iface (client);
+
+	clients = g_hash_table_lookup (priv->clients_by_iface, iface);
+	if (!clients) {
+		clients = g_ptr_array_new ();
+		g_hash_table_insert (priv->clients_by_iface, g_strdup (iface), clients);
+	}
+	g_ptr_array_add (clients, client);
+}
+
+void
+nm_dhcp_listener_remove_client (NMDhcpListener *self, NMDhcpClient *client)
+{
+	NMDhcpListenerPrivate *priv;
+	const char *iface;
+	GPtrArray *clients;
+
+	g_return_if_fail (NM_IS_DHCP_LISTENER (self));
+
+	priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	if (!priv->clients_by_iface)
+		return;
+
+	iface = nm_dhcp_client_get_iface (client);
+	clients = g_hash_table_lookup (priv->clients_by_iface, iface);
+	if (!clients)
+		return;
+
+	g_ptr_array_remove_fast (clients, client);
+	if (clients->len == 0)
+		g_hash_table_remove (priv->clients_by_iface, iface);
+}
+
+static gboolean
+_dispatch_event (NMDhcpListener *self,
+                 const char *iface,
+                 int pid,
+                 GVariant *options,
+                 const char *reason)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	gs_unref_ptrarray GPtrArray *clients = NULL;
+	GPtrArray *clients_idx;
+	guint i;
+
+	clients_idx = g_hash_table_lookup (priv->clients_by_iface, iface);
+	if (!clients_idx)
+		return FALSE;
+
+	/* the handler might remove clients from the table. Iterate over a
+	 * copy that keeps them alive. */
+	clients = g_ptr_array_new_full (clients_idx->len, g_object_unref);
+	for (i = 0; i < clients_idx->len; i++)
+		g_ptr_array_add (clients, g_object_ref (clients_idx->pdata[i]));
+
+	for (i = 0; i < clients->len; i++) {
+		if (nm_dhcp_client_handle_event (self, iface, pid, options, reason, clients->pdata[i]))
+			return TRUE;
+	}
+	return FALSE;
+}
+
 static void
 _method_call_handle (NMDhcpListener *self,
                      GVariant *parameters)
@@ -170,7 +246,7 @@ _method_call_handle (NMDhcpListener *self,
 		return;
 	}
 
-	g_signal_emit (self, signals[EVENT], 0, iface, pid, options, reason, &handled);
+	handled = _dispatch_event (self, iface, pid, options, reason);
 	if (!handled) {
 		if (g_ascii_strcasecmp (reason, "RELEASE") == 0) {
 			/* Ignore event when the dhcp client gets killed and we receive its last message */
@@ -276,6 +352,198 @@ dis_connection_cb (NMDBusManager *mgr,
 
 /*****************************************************************************/
 
+static GVariant *
+_event_datagram_parse (const guint8 *buf, gsize len)
+{
+	GVariantBuilder builder;
+	guint32 magic;
+
+	if (len < sizeof (magic))
+		return NULL;
+	memcpy (&magic, buf, sizeof (magic));
+	if (magic != NM_DHCP_HELPER_EVENT_MAGIC)
+		return NULL;
+	buf += sizeof (magic);
+	len -= sizeof (magic);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	while (len > 0) {
+		NMDhcpHelperEventTlv tlv;
+		gs_free char *name = NULL;
+
+		if (len < sizeof (tlv))
+			goto fail;
+		memcpy (&tlv, buf, sizeof (tlv));
+		buf += sizeof (tlv);
+		len -= sizeof (tlv);
+
+		if (   tlv.name_len == 0
+		    || (gsize) tlv.name_len + tlv.value_len > len)
+			goto fail;
+
+		if (tlv.type == NM_DHCP_HELPER_EVENT_TLV_OPTION) {
+			name = g_strndup ((const char *) buf, tlv.name_len);
+			g_variant_builder_add (&builder, "{sv}",
+			                       name,
+			                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+			                                                  &buf[tlv.name_len],
+			                                                  tlv.value_len,
+			                                                  1));
+		}
+
+		buf += tlv.name_len + tlv.value_len;
+		len -= tlv.name_len + tlv.value_len;
+	}
+
+	return g_variant_ref_sink (g_variant_new ("(a{sv})", &builder));
+
+fail:
+	g_variant_builder_clear (&builder);
+	return NULL;
+}
+
+static gboolean
+_event_socket_cb (GIOChannel *channel,
+                  GIOCondition condition,
+                  gpointer user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	gs_free guint8 *buf = NULL;
+
+	buf = g_malloc (NM_DHCP_HELPER_EVENT_MAX_SIZE);
+
+	/* handle all queued events at once. */
+	for (;;) {
+		gs_unref_variant GVariant *parameters = NULL;
+		union {
+			struct cmsghdr cmsghdr;
+			guint8 buf[CMSG_SPACE (sizeof (struct ucred))];
+		} control;
+		struct iovec iov = {
+			.iov_base = buf,
+			.iov_len = NM_DHCP_HELPER_EVENT_MAX_SIZE,
+		};
+		struct msghdr msg = {
+			.msg_iov = &iov,
+			.msg_iovlen = 1,
+			.msg_control = &control,
+			.msg_controllen = sizeof (control),
+		};
+		struct cmsghdr *cmsg;
+		const struct ucred *ucred = NULL;
+		gssize n;
+		int errsv;
+
+		n = recvmsg (priv->event_fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+		if (n < 0) {
+			errsv = errno;
+			if (errsv == EINTR)
+				continue;
+			if (errsv != EAGAIN)
+				_LOGW ("dhcp-event: failure to receive event: %s", g_strerror (errsv));
+			break;
+		}
+
+		/* the socket file is only accessible to root, but don't rely on it:
+		 * the kernel attaches the credentials of the sender (SO_PASSCRED). */
+		for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+			if (   cmsg->cmsg_level == SOL_SOCKET
+			    && cmsg->cmsg_type == SCM_CREDENTIALS
+			    && cmsg->cmsg_len >= CMSG_LEN (sizeof (struct ucred))) {
+				ucred = (const struct ucred *) CMSG_DATA (cmsg);
+				break;
+			}
+		}
+		if (!ucred || ucred->uid != 0) {
+			_LOGW ("dhcp-event: ignore event datagram from unprivileged sender");
+			continue;
+		}
+
+		parameters = _event_datagram_parse (buf, n);
+		if (!parameters) {
+			_LOGW ("dhcp-event: invalid event datagram of %zd bytes", n);
+			continue;
+		}
+		_method_call_handle (self, parameters);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+_event_socket_open (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+		.sun_path = NM_DHCP_HELPER_EVENT_SOCKET_PATH,
+	};
+	const int one = 1;
+	mode_t old_umask;
+	int fd;
+	int r;
+	int errsv;
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		errsv = errno;
+		_LOGW ("failure to create event socket: %s", g_strerror (errsv));
+		return;
+	}
+
+	if (setsockopt (fd, SOL_SOCKET, SO_PASSCRED, &one, sizeof (one)) < 0) {
+		errsv = errno;
+		_LOGW ("failure to enable credentials on event socket: %s", g_strerror (errsv));
+		nm_close (fd);
+		return;
+	}
+
+	/* only root may send events, like for the private D-Bus socket. Create
+	 * the socket file with restricted permissions right away, so that there
+	 * is no window in which others can connect. */
+	unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+	old_umask = umask (0177);
+	r = bind (fd, (struct sockaddr *) &addr, sizeof (addr));
+	errsv = errno;
+	umask (old_umask);
+	if (r < 0) {
+		_LOGW ("failure to bind event socket %s: %s", NM_DHCP_HELPER_EVENT_SOCKET_PATH, g_strerror (errsv));
+		nm_close (fd);
+		return;
+	}
+
+	if (chmod (NM_DHCP_HELPER_EVENT_SOCKET_PATH, 0600) < 0) {
+		errsv = errno;
+		_LOGW ("failure to set permissions of event socket %s: %s", NM_DHCP_HELPER_EVENT_SOCKET_PATH, g_strerror (errsv));
+		nm_close (fd);
+		unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+		return;
+	}
+
+	priv->event_fd = fd;
+	priv->event_channel = g_io_channel_unix_new (fd);
+	priv->event_id = g_io_add_watch (priv->event_channel, G_IO_IN, _event_socket_cb, self);
+}
+
+static void
+_event_socket_close (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	if (priv->event_fd < 0)
+		return;
+
+	nm_clear_g_source (&priv->event_id);
+	g_clear_pointer (&priv->event_channel, g_io_channel_unref);
+	nm_close (priv->event_fd);
+	priv->event_fd = -1;
+	unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+}
+
+/*****************************************************************************/
+
 static void
 nm_dhcp_listener_init (NMDhcpListener *self)
 {
@@ -284,6 +552,12 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	/* Maps GDBusConnection :: signal-id */
 	priv->connections = g_hash_table_new (nm_direct_hash, NULL);
 
+	priv->clients_by_iface = g_hash_table_new_full (nm_str_hash, g_str_equal,
+	                                                g_free, (GDestroyNotify) g_ptr_array_unref);
+
+	priv->event_fd = -1;
+	_event_socket_open (self);
+
 	priv->dbus_mgr = nm_dbus_manager_get ();
 
 	/* Register the socket our DHCP clients will return lease info on */
@@ -309,6 +583,9 @@ dispose (GObject *object)
 
 	g_clear_pointer (&priv->connections, g_hash_table_destroy);
 
+	_event_socket_close ((NMDhcpListener *) object);
+	g_clear_pointer (&priv->clients_by_iface, g_hash_table_destroy);
+
 	G_OBJECT_CLASS (nm_dhcp_listener_parent_class)->dispose (object);
 }
 
@@ -318,17 +595,4 @@ nm_dhcp_listener_class_init (NMDhcpListenerClass *listener_class)
 	GObjectClass *object_class = G_OBJECT_CLASS (listener_class);
 
 	object_class->dispose = dispose;
-
-	signals[EVENT] =
-	    g_signal_new (NM_DHCP_LISTENER_EVENT,
-	                  G_OBJECT_CLASS_TYPE (object_class),
-	                  G_SIGNAL_RUN_LAST, 0,
-	                  g_signal_accumulator_true_handled,
-	                  NULL, NULL,
-	                  G_TYPE_BOOLEAN,     /* listeners return TRUE if handled */
-	                  4,
-	                  G_TYPE_STRING,      /* iface */
-	                  G_TYPE_INT,         /* pid */
-	                  G_TYPE_VARIANT,     /* options */
-	                  G_TYPE_STRING);     /* reason */
 }
@@ -45,6 +45,9 @@ typedef struct {
 	const NMDhcpClientFactory *client_factory;
 	char *default_hostname;
 	CList dhcp_client_lst_head;
+
+	/* ifindex => NMDhcpClient, for IPv4 and IPv6 */
+	GHashTable *clients_by_ifindex[2];
 } NMDhcpManagerPrivate;
 
 struct _NMDhcpManager {
@@ -98,20 +101,14 @@ static NMDhcpClient *
 get_client_for_ifindex (NMDhcpManager *manager, int addr_family, int ifindex)
 {
 	NMDhcpManagerPrivate *priv;
-	NMDhcpClient *client;
 
 	g_return_val_if_fail (NM_IS_DHCP_MANAGER (manager), NULL);
 	g_return_val_if_fail (ifindex > 0, NULL);
 
 	priv = NM_DHCP_MANAGER_GET_PRIVATE (manager);
 
-	c_list_for_each_entry (client, &priv->dhcp_client_lst_head, dhcp_client_lst) {
-		if (   nm_dhcp_client_get_ifindex (client) == ifindex
-		    && nm_dhcp_client_get_addr_family (client) == addr_family)
-			return client;
-	}
-
-	return NULL;
+	return g_hash_table_lookup (priv->clients_by_ifindex[addr_family == AF_INET6],
+	                            GINT_TO_POINTER (ifindex));
 }
 
 static void client_state_changed (NMDhcpClient *client,
@@ -124,9 +121,18 @@ static void client_state_changed (NMDhcpClient *client,
 static void
 remove_client (NMDhcpManager *self, NMDhcpClient *client)
 {
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+	GHashTable *idx;
+	int ifindex;
+
 	g_signal_handlers_disconnect_by_func (client, client_state_changed, self);
 	c_list_unlink (&client->dhcp_client_lst);
 
+	idx = priv->clients_by_ifindex[nm_dhcp_client_get_addr_family (client) == AF_INET6];
+	ifindex = nm_dhcp_client_get_ifindex (client);
+	if (g_hash_table_lookup (idx, GINT_TO_POINTER (ifindex)) == client)
+		g_hash_table_remove (idx, GINT_TO_POINTER (ifindex));
+
 	/* Stopping the client is left up to the controlling device
 	 * explicitly since we may want to quit NetworkManager but not terminate
 	 * the DHCP client.
@@ -231,6 +237,9 @@ client_start (NMDhcpManager *self,
 	                       NULL);
 	nm_assert (client && c_list_is_empty (&client->dhcp_client_lst));
 	c_list_link_tail (&priv->dhcp_client_lst_head, &client->dhcp_client_lst);
+	g_hash_table_insert (priv->clients_by_ifindex[addr_family == AF_INET6],
+	                     GINT_TO_POINTER (ifindex),
+	                     client);
 	g_signal_connect (client, NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED, G_CALLBACK (client_state_changed), self);
 
 	if (addr_family == AF_INET) {
@@ -395,6 +404,8 @@ nm_dhcp_manager_init (NMDhcpManager *self)
 	const NMDhcpClientFactory *client_factory = NULL;
 
 	c_list_init (&priv->dhcp_client_lst_head);
+	priv->clients_by_ifindex[0] = g_hash_table_new (nm_direct_hash, NULL);
+	priv->clients_by_ifindex[1] = g_hash_table_new (nm_direct_hash, NULL);
 
 	for (i = 0; i < G_N_ELEMENTS (_nm_dhcp_manager_factories); i++) {
 		const NMDhcpClientFactory *f = _nm_dhcp_manager_factories[i];
@@ -464,10 +475,22 @@ dispose (GObject *object)
 	nm_clear_g_free (&priv->default_hostname);
 }
 
+static void
+finalize (GObject *object)
+{
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE ((NMDhcpManager *) object);
+
+	g_hash_table_unref (priv->clients_by_ifindex[0]);
+	g_hash_table_unref (priv->clients_by_ifindex[1]);
+
+	G_OBJECT_CLASS (nm_dhcp_manager_parent_class)->finalize (object);
+}
+
 static void
 nm_dhcp_manager_class_init (NMDhcpManagerClass *manager_class)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (manager_class);
 
 	object_class->dispose = dispose;
+	object_class->finalize = finalize;
 }
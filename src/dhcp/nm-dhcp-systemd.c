@@ -35,6 +35,7 @@
 #include "nm-dhcp-utils.h"
 #include "NetworkManagerUtils.h"
 #include "platform/nm-platform.h"
+#include "nm-config.h"
 #include "nm-dhcp-client-logging.h"
 #include "systemd/nm-sd.h"
 
@@ -59,6 +60,14 @@ typedef struct {
 	sd_dhcp6_client *client6;
 	char *lease_file;
 
+	/* the options of the lease as last written to @lease_file, without
+	 * the expiry. Used to skip writing leases that didn't change. */
+	GHashTable *lease_options;
+	sd_dhcp_lease *lease_pending;
+	CList lease_write_lst;
+
+	CList start_lst;
+
 	guint request_count;
 
 	bool privacy:1;
@@ -79,6 +88,248 @@ G_DEFINE_TYPE (NMDhcpSystemd, nm_dhcp_systemd, NM_TYPE_DHCP_CLIENT)
 
 /*****************************************************************************/
 
+/* The DHCPv4 clients of all interfaces share one start scheduler. Up to
+ * START_BURST clients are started right away within START_WINDOW_MSEC.
+ * When more interfaces start DHCP at the same time (for example, a host
+ * with many VLANs at boot), the remaining clients are queued and started
+ * one at a time at the pace of the window, each with its own random
+ * jitter, so that their DISCOVERs don't all hit the server at once. The transaction timeout of
+ * a client only starts once the client is actually started. */
+
+#define START_BURST        16
+#define START_WINDOW_MSEC  1000
+#define START_JITTER_MSEC  250
+
+static struct {
+	CList queue_lst_head;
+	gint64 window_start_ms;
+	guint window_n;
+	guint timeout_id;
+} _start_sched = {
+	.queue_lst_head = C_LIST_INIT (_start_sched.queue_lst_head),
+};
+
+static void _start_sched_schedule (void);
+
+static void
+_start_sched_start (NMDhcpSystemd *self)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	int r;
+
+	nm_assert (priv->client4);
+
+	r = sd_dhcp_client_start (priv->client4);
+	if (r < 0) {
+		_LOGW ("failed to start DHCP client: %s", g_strerror (-r));
+		nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_FAIL, NULL, NULL);
+		return;
+	}
+
+	nm_dhcp_client_start_timeout (NM_DHCP_CLIENT (self));
+}
+
+static gboolean
+_start_sched_admit (void)
+{
+	gint64 now_ms = nm_utils_get_monotonic_timestamp_ms ();
+
+	if (now_ms - _start_sched.window_start_ms >= START_WINDOW_MSEC) {
+		_start_sched.window_start_ms = now_ms;
+		_start_sched.window_n = 0;
+	}
+	if (_start_sched.window_n >= START_BURST)
+		return FALSE;
+	_start_sched.window_n++;
+	return TRUE;
+}
+
+static gboolean
+_start_sched_timeout_cb (gpointer user_data)
+{
+	_start_sched.timeout_id = 0;
+
+	/* start one client per timeout, so that every queued client gets
+	 * its own jitter. */
+	if (   !c_list_is_empty (&_start_sched.queue_lst_head)
+	    && _start_sched_admit ()) {
+		NMDhcpSystemd *self;
+
+		self = c_list_first_entry (&_start_sched.queue_lst_head, NMDhcpSystemd, _priv.start_lst);
+		c_list_unlink (&self->_priv.start_lst);
+
+		_start_sched_start (self);
+	}
+
+	_start_sched_schedule ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_start_sched_schedule (void)
+{
+	gint64 now_ms;
+	gint64 delay_ms;
+
+	if (   _start_sched.timeout_id
+	    || c_list_is_empty (&_start_sched.queue_lst_head))
+		return;
+
+	now_ms = nm_utils_get_monotonic_timestamp_ms ();
+	if (   now_ms - _start_sched.window_start_ms >= START_WINDOW_MSEC
+	    || _start_sched.window_n < START_BURST) {
+		/* the window has room. Spread the next starts over it. */
+		delay_ms = g_random_int_range (0, START_WINDOW_MSEC / START_BURST);
+	} else {
+		delay_ms =   _start_sched.window_start_ms + START_WINDOW_MSEC - now_ms
+		           + g_random_int_range (0, START_JITTER_MSEC);
+	}
+
+	_start_sched.timeout_id = g_timeout_add (delay_ms, _start_sched_timeout_cb, NULL);
+}
+
+static int
+_start_sched_enqueue (NMDhcpSystemd *self)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	int r;
+
+	if (   c_list_is_empty (&_start_sched.queue_lst_head)
+	    && _start_sched_admit ()) {
+		r = sd_dhcp_client_start (priv->client4);
+		if (r >= 0)
+			nm_dhcp_client_start_timeout (NM_DHCP_CLIENT (self));
+		return r;
+	}
+
+	_LOGD ("dhcp-client4: many clients are starting, delay start");
+	c_list_link_tail (&_start_sched.queue_lst_head, &priv->start_lst);
+	_start_sched_schedule ();
+	return 0;
+}
+
+static void
+_start_sched_dequeue (NMDhcpSystemd *self)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+
+	c_list_unlink (&priv->start_lst);
+	if (c_list_is_empty (&_start_sched.queue_lst_head))
+		nm_clear_g_source (&_start_sched.timeout_id);
+}
+
+/*****************************************************************************/
+
+/* Leases are kept in memory and written to the lease file only when
+ * something relevant changed. A renewal that merely extends the lease
+ * doesn't touch the disk. The writes of all clients are further delayed
+ * by "main.dhcp-lease-write-delay" seconds and done in one batch; a pending
+ * write is always flushed when the client stops. */
+
+#define LEASE_WRITE_DELAY_MAX_SEC 3600
+
+static struct {
+	CList pending_lst_head;
+	guint timeout_id;
+} _lease_writer = {
+	.pending_lst_head = C_LIST_INIT (_lease_writer.pending_lst_head),
+};
+
+static void
+_lease_write_flush (NMDhcpSystemd *self)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	int r;
+
+	c_list_unlink (&priv->lease_write_lst);
+	if (c_list_is_empty (&_lease_writer.pending_lst_head))
+		nm_clear_g_source (&_lease_writer.timeout_id);
+
+	if (!priv->lease_pending)
+		return;
+
+	r = dhcp_lease_save (priv->lease_pending, priv->lease_file);
+	if (r < 0)
+		_LOGW ("failed to save lease to '%s': %s", priv->lease_file, g_strerror (-r));
+	else
+		_LOGT ("lease saved to '%s'", priv->lease_file);
+
+	g_clear_pointer (&priv->lease_pending, sd_dhcp_lease_unref);
+}
+
+static gboolean
+_lease_writer_timeout_cb (gpointer user_data)
+{
+	NMDhcpSystemd *self;
+
+	_lease_writer.timeout_id = 0;
+
+	while ((self = c_list_first_entry (&_lease_writer.pending_lst_head, NMDhcpSystemd, _priv.lease_write_lst)))
+		_lease_write_flush (self);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Remembers @options as the current state of the lease and returns
+ * whether they differ from the previous state. The expiry is absolute
+ * and changes with every renewal, so it is not taken into account. */
+static gboolean
+_lease_options_update (NMDhcpSystemd *self, GHashTable *options)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *material = NULL;
+	GHashTableIter iter;
+	const char *key, *value;
+
+	material = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, g_free);
+	g_hash_table_iter_init (&iter, options);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &value)) {
+		if (!nm_streq (key, "expiry"))
+			g_hash_table_insert (material, (gpointer) key, g_strdup (value));
+	}
+
+	if (   priv->lease_options
+	    && nm_utils_hash_table_equal (priv->lease_options, material, FALSE, g_str_equal))
+		return FALSE;
+
+	g_clear_pointer (&priv->lease_options, g_hash_table_unref);
+	priv->lease_options = g_steal_pointer (&material);
+	return TRUE;
+}
+
+static void
+_lease_save (NMDhcpSystemd *self, sd_dhcp_lease *lease, GHashTable *options)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	gint64 delay;
+
+	if (!_lease_options_update (self, options)) {
+		_LOGT ("lease unchanged, not saving");
+		return;
+	}
+
+	sd_dhcp_lease_ref (lease);
+	if (priv->lease_pending)
+		sd_dhcp_lease_unref (priv->lease_pending);
+	priv->lease_pending = lease;
+
+	delay = nm_config_data_get_value_int64 (NM_CONFIG_GET_DATA,
+	                                        NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                        NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_LEASE_WRITE_DELAY,
+	                                        10, 0, LEASE_WRITE_DELAY_MAX_SEC, 0);
+	if (delay == 0) {
+		_lease_write_flush (self);
+		return;
+	}
+
+	if (!c_list_is_linked (&priv->lease_write_lst))
+		c_list_link_tail (&_lease_writer.pending_lst_head, &priv->lease_write_lst);
+	if (!_lease_writer.timeout_id)
+		_lease_writer.timeout_id = g_timeout_add_seconds (delay, _lease_writer_timeout_cb, NULL);
+}
+
+/*****************************************************************************/
+
 #define DHCP_OPTION_NIS_DOMAIN         40
 #define DHCP_OPTION_NIS_SERVERS        41
 
@@ -505,7 +756,7 @@ bound4_handle (NMDhcpSystemd *self)
 		uint8_t type = 0;
 
 		add_requests_to_options (options, dhcp4_requests);
-		dhcp_lease_save (lease, priv->lease_file);
+		_lease_save (self, lease, options);
 
 		sd_dhcp_client_get_client_id (priv->client4, &type, &client_id, &client_id_len);
 		if (client_id)
@@ -588,6 +839,9 @@ ip4_start (NMDhcpClient *client,
 	g_assert (priv->client4 == NULL);
 	g_assert (priv->client6 == NULL);
 
+	_lease_write_flush (self);
+	g_clear_pointer (&priv->lease_options, g_hash_table_unref);
+
 	g_free (priv->lease_file);
 	priv->lease_file = get_leasefile_path (AF_INET, iface, nm_dhcp_client_get_uuid (client));
 
@@ -635,6 +889,28 @@ ip4_start (NMDhcpClient *client,
 
 	dhcp_lease_load (&lease, priv->lease_file);
 
+	if (lease) {
+		gs_unref_hashtable GHashTable *options = NULL;
+		gs_unref_object NMIP4Config *ip4_config = NULL;
+
+		/* adopt the lease file from disk, so that binding to the same
+		 * lease again doesn't rewrite it. */
+		options = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, g_free);
+		ip4_config = lease_to_ip4_config (nm_dhcp_client_get_multi_idx (client),
+		                                  iface,
+		                                  nm_dhcp_client_get_ifindex (client),
+		                                  lease,
+		                                  options,
+		                                  nm_dhcp_client_get_route_table (client),
+		                                  nm_dhcp_client_get_route_metric (client),
+		                                  FALSE,
+		                                  NULL);
+		if (ip4_config) {
+			add_requests_to_options (options, dhcp4_requests);
+			_lease_options_update (self, options);
+		}
+	}
+
 	if (last_ip4_address)
 		inet_pton (AF_INET, last_ip4_address, &last_addr);
 	else if (lease)
@@ -689,14 +965,12 @@ ip4_start (NMDhcpClient *client,
 		}
 	}
 
-	r = sd_dhcp_client_start (priv->client4);
+	r = _start_sched_enqueue (self);
 	if (r < 0) {
 		nm_utils_error_set_errno (error, r, "failed to start DHCP client: %s");
 		goto errout;
 	}
 
-	nm_dhcp_client_start_timeout (client);
-
 	success = TRUE;
 
 errout:
@@ -996,6 +1270,9 @@ stop (NMDhcpClient *client, gboolean release, GBytes *duid)
 	       priv->client4 ? '4' : '6',
 	       priv->client4 ? (gpointer) priv->client4 : (gpointer) priv->client6);
 
+	_start_sched_dequeue (self);
+	_lease_write_flush (self);
+
 	if (priv->client4) {
 		sd_dhcp_client_set_callback (priv->client4, NULL, NULL);
 		r = sd_dhcp_client_stop (priv->client4);
@@ -1013,6 +1290,10 @@ stop (NMDhcpClient *client, gboolean release, GBytes *duid)
 static void
 nm_dhcp_systemd_init (NMDhcpSystemd *self)
 {
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+
+	c_list_init (&priv->start_lst);
+	c_list_init (&priv->lease_write_lst);
 }
 
 static void
@@ -1020,6 +1301,10 @@ dispose (GObject *object)
 {
 	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE ((NMDhcpSystemd *) object);
 
+	_start_sched_dequeue ((NMDhcpSystemd *) object);
+	_lease_write_flush ((NMDhcpSystemd *) object);
+
+	g_clear_pointer (&priv->lease_options, g_hash_table_unref);
 	g_clear_pointer (&priv->lease_file, g_free);
 
 	if (priv->client4) {
@@ -0,0 +1,142 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2026 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <net/ethernet.h>
+
+#include "nm-utils/nm-dedup-multi.h"
+#include "nm-utils.h"
+
+#include "dhcp/nm-dhcp-client.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+/* interfaces that don't exist, so that starting a client fails right
+ * away, with or without privileges. */
+#define IFINDEX_NONEXISTENT 0x7fff0000
+
+/* more clients than the start scheduler starts within two of its one
+ * second windows, so that the last ones wait in the queue for longer
+ * than their timeout. */
+#define N_CLIENTS           48
+#define TIMEOUT_SEC         1
+
+typedef struct {
+	GMainLoop *loop;
+	guint n_queued;
+	guint n_fail;
+	guint n_timeout;
+} StartQueueData;
+
+static void
+_start_queue_state_changed_cb (NMDhcpClient *client,
+                               NMDhcpState state,
+                               GObject *ip_config,
+                               GHashTable *options,
+                               const char *event_id,
+                               StartQueueData *data)
+{
+	switch (state) {
+	case NM_DHCP_STATE_FAIL:
+		data->n_fail++;
+		break;
+	case NM_DHCP_STATE_TIMEOUT:
+		data->n_timeout++;
+		break;
+	default:
+		break;
+	}
+
+	if (data->n_fail + data->n_timeout >= data->n_queued)
+		g_main_loop_quit (data->loop);
+}
+
+static void
+test_start_queue_timeout (void)
+{
+	nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = nm_dedup_multi_index_new ();
+	gs_unref_bytes GBytes *hwaddr = NULL;
+	const guint8 hwaddr_bin[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	NMDhcpClient *clients[N_CLIENTS];
+	StartQueueData data = { };
+	guint i;
+
+	hwaddr = g_bytes_new (hwaddr_bin, sizeof (hwaddr_bin));
+
+	for (i = 0; i < N_CLIENTS; i++) {
+		gs_free char *iface = g_strdup_printf ("nm-test-%u", i);
+		gs_free char *uuid = nm_utils_uuid_generate ();
+		GError *error = NULL;
+
+		clients[i] = g_object_new (_nm_dhcp_client_factory_internal.get_type (),
+		                           NM_DHCP_CLIENT_MULTI_IDX, multi_idx,
+		                           NM_DHCP_CLIENT_ADDR_FAMILY, AF_INET,
+		                           NM_DHCP_CLIENT_INTERFACE, iface,
+		                           NM_DHCP_CLIENT_IFINDEX, IFINDEX_NONEXISTENT + (int) i,
+		                           NM_DHCP_CLIENT_HWADDR, hwaddr,
+		                           NM_DHCP_CLIENT_UUID, uuid,
+		                           NM_DHCP_CLIENT_TIMEOUT, (guint) TIMEOUT_SEC,
+		                           NULL);
+		g_signal_connect (clients[i],
+		                  NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
+		                  G_CALLBACK (_start_queue_state_changed_cb),
+		                  &data);
+
+		/* the clients that are started right away fail right away. The
+		 * others are queued and fail once they get started. */
+		if (nm_dhcp_client_start_ip4 (clients[i], NULL, NULL, NULL, NULL, &error))
+			data.n_queued++;
+		else
+			g_clear_error (&error);
+	}
+
+	/* the queue must last longer than the timeout. */
+	g_assert_cmpint (data.n_queued, >, N_CLIENTS / 3);
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+	if (!nmtst_main_loop_run (data.loop, 10000))
+		g_assert_not_reached ();
+	g_main_loop_unref (data.loop);
+
+	/* the timeout of a client only starts when it is started, not while
+	 * it waits in the queue. */
+	g_assert_cmpint (data.n_timeout, ==, 0);
+	g_assert_cmpint (data.n_fail, ==, data.n_queued);
+
+	for (i = 0; i < N_CLIENTS; i++) {
+		g_signal_handlers_disconnect_by_data (clients[i], &data);
+		g_object_unref (clients[i]);
+	}
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, "ERR", "DEFAULT");
+
+	g_test_add_func ("/dhcp/systemd/start-queue-timeout", test_start_queue_timeout);
+
+	return g_test_run ();
+}
@@ -55,8 +55,6 @@
 #include "nm-dns-systemd-resolved.h"
 #include "nm-dns-unbound.h"
 
-#define HASH_LEN 20
-
 #ifndef RESOLVCONF_PATH
 #define RESOLVCONF_PATH "/sbin/resolvconf"
 #endif
@@ -117,8 +115,8 @@ typedef struct {
 	char *hostname;
 	guint updates_queue;
 
-	guint8 hash[HASH_LEN];  /* SHA1 hash of current DNS config */
-	guint8 prev_hash[HASH_LEN];  /* Hash when begin_updates() was called */
+	guint64 hash;       /* hash of current DNS config */
+	guint64 prev_hash;  /* Hash when begin_updates() was called */
 
 	NMDnsManagerResolvConfManager rc_manager;
 	char *mode;
@@ -955,18 +953,16 @@ update_resolv_conf (NMDnsManager *self,
 	return SR_SUCCESS;
 }
 
-static void
-compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global, guint8 buffer[HASH_LEN])
+static guint64
+compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global)
 {
-	GChecksum *sum;
-	gsize len = HASH_LEN;
+	NMHashState h;
 	NMDnsIPConfigData *ip_data;
 
-	sum = g_checksum_new (G_CHECKSUM_SHA1);
-	nm_assert (len == g_checksum_type_get_length (G_CHECKSUM_SHA1));
+	nm_hash_init (&h, 1589342307u);
 
 	if (global)
-		nm_global_dns_config_update_checksum (global, sum);
+		nm_global_dns_config_hash (global, &h);
 	else {
 		const CList *head;
 
@@ -974,11 +970,10 @@ compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global, guint8 buffer
 		 * configuration without DNS parameters gives a zero checksum. */
 		head = _ip_config_lst_head (self);
 		c_list_for_each_entry (ip_data, head, ip_config_lst)
-			nm_ip_config_hash (ip_data->ip_config, sum, TRUE);
+			nm_ip_config_hash (ip_data->ip_config, &h, TRUE);
 	}
 
-	g_checksum_get_digest (sum, buffer, &len);
-	g_checksum_free (sum);
+	return nm_hash_complete_u64 (&h);
 }
 
 static gboolean
@@ -1386,7 +1381,7 @@ update_dns (NMDnsManager *self,
 	global_config = nm_config_data_get_global_dns_config (data);
 
 	/* Update hash with config we're applying */
-	compute_hash (self, global_config, priv->hash);
+	priv->hash = compute_hash (self, global_config);
 
 	_collect_resolv_conf_data (self, global_config,
 	                           &searches, &options, &nameservers,
@@ -1704,7 +1699,7 @@ nm_dns_manager_begin_updates (NMDnsManager *self, const char *func)
 
 	/* Save current hash when starting a new batch */
 	if (priv->updates_queue == 0)
-		memcpy (priv->prev_hash, priv->hash, sizeof (priv->hash));
+		priv->prev_hash = priv->hash;
 
 	priv->updates_queue++;
 
@@ -1717,15 +1712,15 @@ nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 	NMDnsManagerPrivate *priv;
 	GError *error = NULL;
 	gboolean changed;
-	guint8 new[HASH_LEN];
+	guint64 new_hash;
 
 	g_return_if_fail (self != NULL);
 
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	g_return_if_fail (priv->updates_queue > 0);
 
-	compute_hash (self, nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)), new);
-	changed = (memcmp (new, priv->prev_hash, sizeof (new)) != 0) ? TRUE : FALSE;
+	new_hash = compute_hash (self, nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)));
+	changed = (new_hash != priv->prev_hash);
 	_LOGD ("(%s): DNS configuration %s", func, changed ? "changed" : "did not change");
 
 	priv->updates_queue--;
@@ -1741,7 +1736,7 @@ nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 		g_clear_error (&error);
 	}
 
-	memset (priv->prev_hash, 0, sizeof (priv->prev_hash));
+	priv->prev_hash = 0;
 }
 
 void
@@ -2253,7 +2248,7 @@ nm_dns_manager_init (NMDnsManager *self)
 	                                       NULL, (GDestroyNotify) _config_data_free);
 
 	/* Set the initial hash */
-	compute_hash (self, NULL, NM_DNS_MANAGER_GET_PRIVATE (self)->hash);
+	NM_DNS_MANAGER_GET_PRIVATE (self)->hash = compute_hash (self, NULL);
 
 	g_signal_connect (G_OBJECT (priv->config),
 	                  NM_CONFIG_SIGNAL_CONFIG_CHANGED,
@@ -354,7 +354,16 @@ main (int argc, char *argv[])
 		                              NM_CONFIG_KEYFILE_GROUP_LOGGING,
 		                              NM_CONFIG_KEYFILE_KEY_LOGGING_BACKEND,
 		                              NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
-		nm_logging_syslog_openlog (v, nm_config_get_is_debug (config));
+		nm_logging_syslog_openlog (v,
+		                           nm_config_get_is_debug (config),
+		                           nm_config_data_get_value_boolean (NM_CONFIG_GET_DATA_ORIG,
+		                                                             NM_CONFIG_KEYFILE_GROUP_LOGGING,
+		                                                             NM_CONFIG_KEYFILE_KEY_LOGGING_ASYNC,
+		                                                             FALSE));
+		nm_logging_flight_recorder_setup (1024 * nm_config_data_get_value_int64 (NM_CONFIG_GET_DATA_ORIG,
+		                                                                         NM_CONFIG_KEYFILE_GROUP_LOGGING,
+		                                                                         NM_CONFIG_KEYFILE_KEY_LOGGING_FLIGHT_RECORDER_SIZE,
+		                                                                         10, 0, 1024 * 1024, 0));
 	}
 
 	nm_log_info (LOGD_CORE, "NetworkManager (version " NM_DIST_VERSION ") is starting... (%s)",
@@ -56,6 +56,13 @@ struct _NMNDiscPrivate {
 	guint ra_timeout_id;  /* first RA timeout */
 	guint timeout_id;   /* prefix/dns/etc lifetime timeout */
 	char *last_error;
+
+	/* for addresses, routes and DNS servers: the position of each
+	 * item in its rdata array, the first position that might be stale,
+	 * and the pending expiry events. */
+	GHashTable *idx[3 /* _IDX_TYPE_NUM */];
+	guint idx_stale_from[3 /* _IDX_TYPE_NUM */];
+	GArray *expiry_heap;
 	NMUtilsIPv6IfaceId iid;
 
 	/* immutable values: */
@@ -178,6 +185,361 @@ nm_ndisc_get_node_type (NMNDisc *self)
 
 /*****************************************************************************/
 
+/* A RA might carry many routes and RAs come from many routers. Addresses,
+ * routes and DNS servers are indexed by their key, so that a refresh of
+ * an existing item doesn't need a linear search. Their expiry is tracked
+ * in a min-heap, so that the lifetime check only touches expired items.
+ * The heap entries are not removed when an item changes or goes away;
+ * instead, a popped entry is ignored if it no longer matches its item.
+ *
+ * Inserting or removing an item shifts the ones after it. Their positions
+ * are not updated right away, but only once a lookup finds a position that
+ * no longer holds its item. Then all positions from the first shifted one
+ * are renumbered at once.
+ *
+ * Gateways and DNS domains are few and still use linear searches. */
+
+typedef enum {
+	IDX_TYPE_ADDRESS,
+	IDX_TYPE_ROUTE,
+	IDX_TYPE_DNS_SERVER,
+	_IDX_TYPE_NUM,
+} IdxType;
+
+typedef struct {
+	struct in6_addr addr;
+	guint8 plen;
+	guint pos;
+} IdxEntry;
+
+typedef struct {
+	gint32 time;
+	guint8 type;
+	bool refresh:1;
+	guint8 plen;
+	struct in6_addr addr;
+} ExpiryEvent;
+
+static guint
+_idx_entry_hash (gconstpointer ptr)
+{
+	const IdxEntry *e = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1412693839u);
+	nm_hash_update (&h, &e->addr, sizeof (e->addr));
+	nm_hash_update_val (&h, e->plen);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_idx_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const IdxEntry *e_a = a;
+	const IdxEntry *e_b = b;
+
+	return    e_a->plen == e_b->plen
+	       && IN6_ARE_ADDR_EQUAL (&e_a->addr, &e_b->addr);
+}
+
+static GArray *
+_idx_array (NMNDiscDataInternal *rdata, IdxType type)
+{
+	switch (type) {
+	case IDX_TYPE_ADDRESS:
+		return rdata->addresses;
+	case IDX_TYPE_ROUTE:
+		return rdata->routes;
+	case IDX_TYPE_DNS_SERVER:
+		return rdata->dns_servers;
+	default:
+		nm_assert_not_reached ();
+		return NULL;
+	}
+}
+
+static gpointer
+_idx_item (NMNDiscDataInternal *rdata, IdxType type, guint pos)
+{
+	GArray *arr = _idx_array (rdata, type);
+
+	nm_assert (pos < arr->len);
+	return &arr->data[pos * g_array_get_element_size (arr)];
+}
+
+static void
+_idx_item_get_key (IdxType type, gconstpointer item, IdxEntry *key)
+{
+	memset (key, 0, sizeof (*key));
+	switch (type) {
+	case IDX_TYPE_ADDRESS:
+		key->addr = ((const NMNDiscAddress *) item)->address;
+		break;
+	case IDX_TYPE_ROUTE:
+		key->addr = ((const NMNDiscRoute *) item)->network;
+		key->plen = ((const NMNDiscRoute *) item)->plen;
+		break;
+	case IDX_TYPE_DNS_SERVER:
+		key->addr = ((const NMNDiscDNSServer *) item)->address;
+		break;
+	default:
+		nm_assert_not_reached ();
+	}
+}
+
+static void
+_idx_item_get_lifetime (IdxType type, gconstpointer item, guint32 *timestamp, guint32 *lifetime)
+{
+	switch (type) {
+	case IDX_TYPE_ADDRESS:
+		*timestamp = ((const NMNDiscAddress *) item)->timestamp;
+		*lifetime = ((const NMNDiscAddress *) item)->lifetime;
+		break;
+	case IDX_TYPE_ROUTE:
+		*timestamp = ((const NMNDiscRoute *) item)->timestamp;
+		*lifetime = ((const NMNDiscRoute *) item)->lifetime;
+		break;
+	case IDX_TYPE_DNS_SERVER:
+		*timestamp = ((const NMNDiscDNSServer *) item)->timestamp;
+		*lifetime = ((const NMNDiscDNSServer *) item)->lifetime;
+		break;
+	default:
+		nm_assert_not_reached ();
+	}
+}
+
+static void
+_idx_item_set_lifetime_zero (IdxType type, gpointer item)
+{
+	switch (type) {
+	case IDX_TYPE_ADDRESS:
+		((NMNDiscAddress *) item)->lifetime = 0;
+		break;
+	case IDX_TYPE_ROUTE:
+		((NMNDiscRoute *) item)->lifetime = 0;
+		break;
+	case IDX_TYPE_DNS_SERVER:
+		((NMNDiscDNSServer *) item)->lifetime = 0;
+		break;
+	default:
+		nm_assert_not_reached ();
+	}
+}
+
+static gint32 get_expiry_time (guint32 timestamp, guint32 lifetime);
+
+static gint32
+_idx_item_get_expiry (IdxType type, gconstpointer item, gboolean refresh)
+{
+	guint32 timestamp, lifetime;
+
+	_idx_item_get_lifetime (type, item, &timestamp, &lifetime);
+	if (refresh && lifetime != NM_NDISC_INFINITY)
+		lifetime /= 2;
+	return get_expiry_time (timestamp, lifetime);
+}
+
+static void
+_idx_set_stale (NMNDisc *ndisc, IdxType type, guint from)
+{
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+
+	priv->idx_stale_from[type] = MIN (priv->idx_stale_from[type], from);
+}
+
+/* Update the positions that might be stale after the array was shifted. */
+static void
+_idx_reindex (NMNDisc *ndisc, IdxType type)
+{
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	GArray *arr = _idx_array (&priv->rdata, type);
+	guint pos;
+
+	for (pos = priv->idx_stale_from[type]; pos < arr->len; pos++) {
+		IdxEntry key;
+		IdxEntry *e;
+
+		_idx_item_get_key (type, _idx_item (&priv->rdata, type, pos), &key);
+		e = g_hash_table_lookup (priv->idx[type], &key);
+
+		/* the items marked by clean_expired() are no longer indexed. */
+		if (e)
+			e->pos = pos;
+	}
+	priv->idx_stale_from[type] = G_MAXUINT;
+}
+
+/* Whether the position of @e holds its item. The keys are unique, so
+ * comparing the full key is enough. */
+static gboolean
+_idx_entry_valid (NMNDisc *ndisc, IdxType type, const IdxEntry *e)
+{
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	IdxEntry key;
+
+	if (e->pos >= _idx_array (&priv->rdata, type)->len)
+		return FALSE;
+	_idx_item_get_key (type, _idx_item (&priv->rdata, type, e->pos), &key);
+	return _idx_entry_equal (&key, e);
+}
+
+static IdxEntry *
+_idx_lookup (NMNDisc *ndisc, IdxType type, const IdxEntry *key)
+{
+	IdxEntry *e;
+
+	e = g_hash_table_lookup (NM_NDISC_GET_PRIVATE (ndisc)->idx[type], key);
+	if (   e
+	    && !_idx_entry_valid (ndisc, type, e)) {
+		_idx_reindex (ndisc, type);
+		nm_assert (_idx_entry_valid (ndisc, type, e));
+	}
+	return e;
+}
+
+static void
+_idx_remove (NMNDisc *ndisc, IdxType type, guint pos)
+{
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	IdxEntry key;
+
+	_idx_item_get_key (type, _idx_item (&priv->rdata, type, pos), &key);
+	if (!g_hash_table_remove (priv->idx[type], &key))
+		nm_assert_not_reached ();
+	g_array_remove_index (_idx_array (&priv->rdata, type), pos);
+	_idx_set_stale (ndisc, type, pos);
+}
+
+/* Remove the items that clean_expired() marked with a zero lifetime, in
+ * a single pass. Items with a zero lifetime are never kept otherwise. */
+static void
+_idx_remove_marked (NMNDisc *ndisc, IdxType type)
+{
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	GArray *arr = _idx_array (&priv->rdata, type);
+	guint elt_size = g_array_get_element_size (arr);
+	guint i, j;
+
+	for (i = 0, j = 0; i < arr->len; i++) {
+		guint32 timestamp, lifetime;
+
+		_idx_item_get_lifetime (type, _idx_item (&priv->rdata, type, i), &timestamp, &lifetime);
+		if (lifetime == 0) {
+			_idx_set_stale (ndisc, type, j);
+			continue;
+		}
+		if (i != j)
+			memcpy (&arr->data[j * elt_size], &arr->data[i * elt_size], elt_size);
+		j++;
+	}
+	g_array_set_size (arr, j);
+}
+
+static void
+_expiry_heap_push (NMNDisc *ndisc, const ExpiryEvent *ev)
+{
+	GArray *heap = NM_NDISC_GET_PRIVATE (ndisc)->expiry_heap;
+	guint i;
+
+	g_array_append_val (heap, *ev);
+	for (i = heap->len - 1; i > 0; ) {
+		guint parent = (i - 1) / 2;
+		ExpiryEvent tmp;
+
+		if (g_array_index (heap, ExpiryEvent, parent).time <= g_array_index (heap, ExpiryEvent, i).time)
+			break;
+		tmp = g_array_index (heap, ExpiryEvent, parent);
+		g_array_index (heap, ExpiryEvent, parent) = g_array_index (heap, ExpiryEvent, i);
+		g_array_index (heap, ExpiryEvent, i) = tmp;
+		i = parent;
+	}
+}
+
+static void
+_expiry_heap_pop (NMNDisc *ndisc)
+{
+	GArray *heap = NM_NDISC_GET_PRIVATE (ndisc)->expiry_heap;
+	guint i = 0;
+
+	nm_assert (heap->len > 0);
+
+	g_array_index (heap, ExpiryEvent, 0) = g_array_index (heap, ExpiryEvent, heap->len - 1);
+	g_array_set_size (heap, heap->len - 1);
+
+	for (;;) {
+		guint l = 2 * i + 1;
+		guint r = l + 1;
+		guint m = i;
+		ExpiryEvent tmp;
+
+		if (l < heap->len && g_array_index (heap, ExpiryEvent, l).time < g_array_index (heap, ExpiryEvent, m).time)
+			m = l;
+		if (r < heap->len && g_array_index (heap, ExpiryEvent, r).time < g_array_index (heap, ExpiryEvent, m).time)
+			m = r;
+		if (m == i)
+			break;
+		tmp = g_array_index (heap, ExpiryEvent, m);
+		g_array_index (heap, ExpiryEvent, m) = g_array_index (heap, ExpiryEvent, i);
+		g_array_index (heap, ExpiryEvent, i) = tmp;
+		i = m;
+	}
+}
+
+/* Queue the expiry of @item. DNS servers also get a refresh event at half
+ * of their lifetime. */
+static void
+_expiry_schedule (NMNDisc *ndisc, IdxType type, gconstpointer item)
+{
+	guint32 timestamp, lifetime;
+	IdxEntry key;
+	ExpiryEvent ev = {
+		.type = type,
+	};
+
+	_idx_item_get_lifetime (type, item, &timestamp, &lifetime);
+	if (lifetime == NM_NDISC_INFINITY)
+		return;
+
+	_idx_item_get_key (type, item, &key);
+	ev.addr = key.addr;
+	ev.plen = key.plen;
+
+	ev.time = _idx_item_get_expiry (type, item, FALSE);
+	_expiry_heap_push (ndisc, &ev);
+
+	if (type == IDX_TYPE_DNS_SERVER) {
+		ev.time = _idx_item_get_expiry (type, item, TRUE);
+		ev.refresh = TRUE;
+		_expiry_heap_push (ndisc, &ev);
+	}
+}
+
+static void
+_idx_insert (NMNDisc *ndisc, IdxType type, guint pos, gconstpointer item)
+{
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	IdxEntry *e;
+
+	e = g_slice_new (IdxEntry);
+	_idx_item_get_key (type, item, e);
+	nm_assert (!g_hash_table_contains (priv->idx[type], e));
+	g_hash_table_add (priv->idx[type], e);
+
+	g_array_insert_vals (_idx_array (&priv->rdata, type), pos, item, 1);
+	e->pos = pos;
+	_idx_set_stale (ndisc, type, pos + 1);
+
+	_expiry_schedule (ndisc, type, item);
+}
+
+static void
+_idx_entry_free (gpointer ptr)
+{
+	g_slice_free (IdxEntry, ptr);
+}
+
+/*****************************************************************************/
+
 static void
 _ASSERT_data_gateways (const NMNDiscDataInternal *data)
 {
@@ -347,29 +709,31 @@ nm_ndisc_add_address (NMNDisc *ndisc, const NMNDiscAddress *new)
 {
 	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
 	NMNDiscDataInternal *rdata = &priv->rdata;
-	guint i;
+	IdxEntry key;
+	IdxEntry *e;
 
 	nm_assert (new);
 	nm_assert (new->timestamp > 0 && new->timestamp < G_MAXINT32);
 	nm_assert (!IN6_IS_ADDR_UNSPECIFIED (&new->address));
 	nm_assert (!IN6_IS_ADDR_LINKLOCAL (&new->address));
 
-	for (i = 0; i < rdata->addresses->len; i++) {
-		NMNDiscAddress *item = &g_array_index (rdata->addresses, NMNDiscAddress, i);
-
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			gboolean changed;
-
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->addresses, i);
-				return TRUE;
-			}
+	_idx_item_get_key (IDX_TYPE_ADDRESS, new, &key);
+	e = _idx_lookup (ndisc, IDX_TYPE_ADDRESS, &key);
+	if (e) {
+		NMNDiscAddress *item = &g_array_index (rdata->addresses, NMNDiscAddress, e->pos);
+		gboolean changed;
 
-			changed = item->timestamp + item->lifetime  != new->timestamp + new->lifetime ||
-			          item->timestamp + item->preferred != new->timestamp + new->preferred;
-			*item = *new;
-			return changed;
+		if (new->lifetime == 0) {
+			_idx_remove (ndisc, IDX_TYPE_ADDRESS, e->pos);
+			return TRUE;
 		}
+
+		changed = item->timestamp + item->lifetime  != new->timestamp + new->lifetime ||
+		          item->timestamp + item->preferred != new->timestamp + new->preferred;
+		*item = *new;
+		if (changed)
+			_expiry_schedule (ndisc, IDX_TYPE_ADDRESS, item);
+		return changed;
 	}
 
 	/* we create at most max_addresses autoconf addresses. This is different from
@@ -381,7 +745,7 @@ nm_ndisc_add_address (NMNDisc *ndisc, const NMNDiscAddress *new)
 		return FALSE;
 
 	if (new->lifetime)
-		g_array_append_val (rdata->addresses, *new);
+		_idx_insert (ndisc, IDX_TYPE_ADDRESS, rdata->addresses->len, new);
 	return !!new->lifetime;
 }
 
@@ -401,6 +765,8 @@ nm_ndisc_add_route (NMNDisc *ndisc, const NMNDiscRoute *new)
 	NMNDiscDataInternal *rdata;
 	guint i;
 	guint insert_idx = G_MAXUINT;
+	IdxEntry key;
+	IdxEntry *e;
 
 	if (new->plen == 0 || new->plen > 128) {
 		/* Only expect non-default routes.  The router has no idea what the
@@ -416,40 +782,50 @@ nm_ndisc_add_route (NMNDisc *ndisc, const NMNDiscRoute *new)
 	priv = NM_NDISC_GET_PRIVATE (ndisc);
 	rdata = &priv->rdata;
 
-	for (i = 0; i < rdata->routes->len; ) {
-		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
+	_idx_item_get_key (IDX_TYPE_ROUTE, new, &key);
+	e = _idx_lookup (ndisc, IDX_TYPE_ROUTE, &key);
+	if (e) {
+		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, e->pos);
 
-		if (IN6_ARE_ADDR_EQUAL (&item->network, &new->network) && item->plen == new->plen) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->routes, i);
-				return TRUE;
-			}
+		if (new->lifetime == 0) {
+			_idx_remove (ndisc, IDX_TYPE_ROUTE, e->pos);
+			return TRUE;
+		}
 
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdata->routes, i);
-				continue;
-			}
+		if (item->preference == new->preference) {
+			gboolean expiry_changed;
 
+			expiry_changed =    item->timestamp != new->timestamp
+			                 || item->lifetime != new->lifetime;
 			memcpy (item, new, sizeof (*new));
+			if (expiry_changed)
+				_expiry_schedule (ndisc, IDX_TYPE_ROUTE, item);
 			return FALSE;
 		}
 
-		/* Put before less preferable routes. */
-		if (   _preference_to_priority (item->preference) < _preference_to_priority (new->preference)
-		    && insert_idx == G_MAXUINT)
-			insert_idx = i;
-
-		i++;
+		_idx_remove (ndisc, IDX_TYPE_ROUTE, e->pos);
 	}
 
-	if (new->lifetime) {
-		g_array_insert_val (rdata->routes,
-		                    insert_idx == G_MAXUINT
-		                      ? 0u
-		                      : insert_idx,
-		                    *new);
+	if (!new->lifetime)
+		return FALSE;
+
+	/* Put before less preferable routes. Only a new route (or one with a
+	 * changed preference) needs the scan. */
+	for (i = 0; i < rdata->routes->len; i++) {
+		const NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
+
+		if (_preference_to_priority (item->preference) < _preference_to_priority (new->preference)) {
+			insert_idx = i;
+			break;
+		}
 	}
-	return !!new->lifetime;
+
+	_idx_insert (ndisc, IDX_TYPE_ROUTE,
+	             insert_idx == G_MAXUINT
+	               ? 0u
+	               : insert_idx,
+	             new);
+	return TRUE;
 }
 
 gboolean
@@ -457,29 +833,31 @@ nm_ndisc_add_dns_server (NMNDisc *ndisc, const NMNDiscDNSServer *new)
 {
 	NMNDiscPrivate *priv;
 	NMNDiscDataInternal *rdata;
-	guint i;
+	IdxEntry key;
+	IdxEntry *e;
 
 	priv = NM_NDISC_GET_PRIVATE (ndisc);
 	rdata = &priv->rdata;
 
-	for (i = 0; i < rdata->dns_servers->len; i++) {
-		NMNDiscDNSServer *item = &g_array_index (rdata->dns_servers, NMNDiscDNSServer, i);
+	_idx_item_get_key (IDX_TYPE_DNS_SERVER, new, &key);
+	e = _idx_lookup (ndisc, IDX_TYPE_DNS_SERVER, &key);
+	if (e) {
+		NMNDiscDNSServer *item = &g_array_index (rdata->dns_servers, NMNDiscDNSServer, e->pos);
 
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->dns_servers, i);
-				return TRUE;
-			}
-			if (item->timestamp != new->timestamp || item->lifetime != new->lifetime) {
-				*item = *new;
-				return TRUE;
-			}
-			return FALSE;
+		if (new->lifetime == 0) {
+			_idx_remove (ndisc, IDX_TYPE_DNS_SERVER, e->pos);
+			return TRUE;
 		}
+		if (item->timestamp != new->timestamp || item->lifetime != new->lifetime) {
+			*item = *new;
+			_expiry_schedule (ndisc, IDX_TYPE_DNS_SERVER, item);
+			return TRUE;
+		}
+		return FALSE;
 	}
 
 	if (new->lifetime)
-		g_array_append_val (rdata->dns_servers, *new);
+		_idx_insert (ndisc, IDX_TYPE_DNS_SERVER, rdata->dns_servers->len, new);
 	return !!new->lifetime;
 }
 
@@ -743,6 +1121,8 @@ nm_ndisc_set_iid (NMNDisc *ndisc, const NMUtilsIPv6IfaceId iid)
 		if (rdata->addresses->len) {
 			_LOGD ("IPv6 interface identifier changed, flushing addresses");
 			g_array_remove_range (rdata->addresses, 0, rdata->addresses->len);
+			g_hash_table_remove_all (priv->idx[IDX_TYPE_ADDRESS]);
+			priv->idx_stale_from[IDX_TYPE_ADDRESS] = G_MAXUINT;
 			nm_ndisc_emit_config_change (ndisc, NM_NDISC_CONFIG_ADDRESSES);
 			solicit_routers (ndisc);
 		}
@@ -799,24 +1179,39 @@ nm_ndisc_start (NMNDisc *ndisc)
 NMNDiscConfigMap
 nm_ndisc_dad_failed (NMNDisc *ndisc, const struct in6_addr *address, gboolean emit_changed_signal)
 {
-	NMNDiscDataInternal *rdata;
-	guint i;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	IdxEntry key = { .addr = *address };
+	IdxEntry *e;
 	gboolean changed = FALSE;
 
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
-	for (i = 0; i < rdata->addresses->len; ) {
-		NMNDiscAddress *item = &g_array_index (rdata->addresses, NMNDiscAddress, i);
-
-		if (IN6_ARE_ADDR_EQUAL (&item->address, address)) {
-			_LOGD ("DAD failed for discovered address %s", nm_utils_inet6_ntop (address, NULL));
-			changed = TRUE;
-			if (!complete_address (ndisc, item)) {
-				g_array_remove_index (rdata->addresses, i);
-				continue;
+	e = _idx_lookup (ndisc, IDX_TYPE_ADDRESS, &key);
+	if (e) {
+		NMNDiscAddress *item = &g_array_index (priv->rdata.addresses, NMNDiscAddress, e->pos);
+		NMNDiscAddress completed = *item;
+		IdxEntry new_key;
+
+		nm_assert (IN6_ARE_ADDR_EQUAL (&item->address, address));
+
+		_LOGD ("DAD failed for discovered address %s", nm_utils_inet6_ntop (address, NULL));
+		changed = TRUE;
+
+		/* complete a copy, so that the item keeps its key until it is
+		 * either replaced or removed. If the new address is already known,
+		 * drop the failed one. */
+		if (complete_address (ndisc, &completed)) {
+			_idx_item_get_key (IDX_TYPE_ADDRESS, &completed, &new_key);
+			if (g_hash_table_contains (priv->idx[IDX_TYPE_ADDRESS], &new_key))
+				_idx_remove (ndisc, IDX_TYPE_ADDRESS, e->pos);
+			else {
+				new_key.pos = e->pos;
+				g_hash_table_remove (priv->idx[IDX_TYPE_ADDRESS], &key);
+				*item = completed;
+				g_hash_table_add (priv->idx[IDX_TYPE_ADDRESS],
+				                  g_slice_dup (IdxEntry, &new_key));
+				_expiry_schedule (ndisc, IDX_TYPE_ADDRESS, item);
 			}
-		}
-		i++;
+		} else
+			_idx_remove (ndisc, IDX_TYPE_ADDRESS, e->pos);
 	}
 
 	if (emit_changed_signal && changed)
@@ -1001,87 +1396,86 @@ clean_gateways (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *n
 	_ASSERT_data_gateways (rdata);
 }
 
+/* Drop the stale events, once they make up most of the heap. */
 static void
-clean_addresses (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
+_expiry_heap_compact (NMNDisc *ndisc)
 {
-	NMNDiscDataInternal *rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	guint n_items = 0;
+	guint type;
 	guint i;
 
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
+	for (type = 0; type < _IDX_TYPE_NUM; type++)
+		n_items += _idx_array (&priv->rdata, type)->len;
 
-	for (i = 0; i < rdata->addresses->len; ) {
-		const NMNDiscAddress *item = &g_array_index (rdata->addresses, NMNDiscAddress, i);
+	if (priv->expiry_heap->len <= 64 + 4 * n_items)
+		return;
 
-		if (item->lifetime != NM_NDISC_INFINITY) {
-			gint32 expiry = get_expiry (item);
+	g_array_set_size (priv->expiry_heap, 0);
+	for (type = 0; type < _IDX_TYPE_NUM; type++) {
+		GArray *arr = _idx_array (&priv->rdata, type);
 
-			if (now >= expiry) {
-				g_array_remove_index (rdata->addresses, i);
-				*changed |= NM_NDISC_CONFIG_ADDRESSES;
-				continue;
-			}
-			if (*nextevent > expiry)
-				*nextevent = expiry;
-		}
-		i++;
+		for (i = 0; i < arr->len; i++)
+			_expiry_schedule (ndisc, type, _idx_item (&priv->rdata, type, i));
 	}
 }
 
 static void
-clean_routes (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
+clean_expired (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
 {
-	NMNDiscDataInternal *rdata;
-	guint i;
-
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	GArray *heap = priv->expiry_heap;
+	static const NMNDiscConfigMap type_to_config[_IDX_TYPE_NUM] = {
+		[IDX_TYPE_ADDRESS]    = NM_NDISC_CONFIG_ADDRESSES,
+		[IDX_TYPE_ROUTE]      = NM_NDISC_CONFIG_ROUTES,
+		[IDX_TYPE_DNS_SERVER] = NM_NDISC_CONFIG_DNS_SERVERS,
+	};
+	guint removed = 0;
+	guint type;
+
+	while (heap->len > 0) {
+		const ExpiryEvent ev = g_array_index (heap, ExpiryEvent, 0);
+		IdxEntry key = {
+			.addr = ev.addr,
+			.plen = ev.plen,
+		};
+		IdxEntry *e;
+
+		e = _idx_lookup (ndisc, ev.type, &key);
+		if (   !e
+		    || _idx_item_get_expiry (ev.type, _idx_item (&priv->rdata, ev.type, e->pos), ev.refresh) != ev.time) {
+			/* the item is gone or its lifetime changed. */
+			_expiry_heap_pop (ndisc);
+			continue;
+		}
 
-	for (i = 0; i < rdata->routes->len; ) {
-		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
+		if (ev.time > now) {
+			if (*nextevent > ev.time)
+				*nextevent = ev.time;
+			break;
+		}
 
-		if (item->lifetime != NM_NDISC_INFINITY) {
-			gint32 expiry = get_expiry (item);
+		_expiry_heap_pop (ndisc);
 
-			if (now >= expiry) {
-				g_array_remove_index (rdata->routes, i);
-				*changed |= NM_NDISC_CONFIG_ROUTES;
-				continue;
-			}
-			if (*nextevent > expiry)
-				*nextevent = expiry;
+		if (ev.refresh)
+			solicit_routers (ndisc);
+		else {
+			/* only mark the item, so that the others don't shift while
+			 * we still look them up. */
+			_idx_item_set_lifetime_zero (ev.type, _idx_item (&priv->rdata, ev.type, e->pos));
+			if (!g_hash_table_remove (priv->idx[ev.type], &key))
+				nm_assert_not_reached ();
+			removed |= (1u << ev.type);
+			*changed |= type_to_config[ev.type];
 		}
-		i++;
 	}
-}
-
-static void
-clean_dns_servers (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
-{
-	NMNDiscDataInternal *rdata;
-	guint i;
-
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
 
-	for (i = 0; i < rdata->dns_servers->len; ) {
-		NMNDiscDNSServer *item = &g_array_index (rdata->dns_servers, NMNDiscDNSServer, i);
-
-		if (item->lifetime != NM_NDISC_INFINITY) {
-			gint32 expiry = get_expiry (item);
-			gint32 refresh;
-
-			if (now >= expiry) {
-				g_array_remove_index (rdata->dns_servers, i);
-				*changed |= NM_NDISC_CONFIG_DNS_SERVERS;
-				continue;
-			}
-
-			refresh = get_expiry_half (item);
-			if (now >= refresh)
-				solicit_routers (ndisc);
-			else if (*nextevent > refresh)
-				*nextevent = refresh;
-		}
-		i++;
+	for (type = 0; type < _IDX_TYPE_NUM; type++) {
+		if (NM_FLAGS_HAS (removed, 1u << type))
+			_idx_remove_marked (ndisc, type);
 	}
+
+	_expiry_heap_compact (ndisc);
 }
 
 static void
@@ -1127,9 +1521,7 @@ check_timestamps (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap changed)
 	nm_clear_g_source (&priv->timeout_id);
 
 	clean_gateways (ndisc, now, &changed, &nextevent);
-	clean_addresses (ndisc, now, &changed, &nextevent);
-	clean_routes (ndisc, now, &changed, &nextevent);
-	clean_dns_servers (ndisc, now, &changed, &nextevent);
+	clean_expired (ndisc, now, &changed, &nextevent);
 	clean_dns_domains (ndisc, now, &changed, &nextevent);
 
 	if (changed)
@@ -1268,6 +1660,14 @@ nm_ndisc_init (NMNDisc *ndisc)
 	g_array_set_clear_func (rdata->dns_domains, dns_domain_free);
 	priv->rdata.public.hop_limit = 64;
 
+	priv->idx[IDX_TYPE_ADDRESS] = g_hash_table_new_full (_idx_entry_hash, _idx_entry_equal, _idx_entry_free, NULL);
+	priv->idx[IDX_TYPE_ROUTE] = g_hash_table_new_full (_idx_entry_hash, _idx_entry_equal, _idx_entry_free, NULL);
+	priv->idx[IDX_TYPE_DNS_SERVER] = g_hash_table_new_full (_idx_entry_hash, _idx_entry_equal, _idx_entry_free, NULL);
+	priv->idx_stale_from[IDX_TYPE_ADDRESS] = G_MAXUINT;
+	priv->idx_stale_from[IDX_TYPE_ROUTE] = G_MAXUINT;
+	priv->idx_stale_from[IDX_TYPE_DNS_SERVER] = G_MAXUINT;
+	priv->expiry_heap = g_array_new (FALSE, FALSE, sizeof (ExpiryEvent));
+
 	/* Start at very low number so that last_rs - router_solicitation_interval
 	 * is much lower than nm_utils_get_monotonic_timestamp_s() at startup.
 	 */
@@ -1306,6 +1706,11 @@ finalize (GObject *object)
 	g_array_unref (rdata->dns_servers);
 	g_array_unref (rdata->dns_domains);
 
+	g_hash_table_unref (priv->idx[IDX_TYPE_ADDRESS]);
+	g_hash_table_unref (priv->idx[IDX_TYPE_ROUTE]);
+	g_hash_table_unref (priv->idx[IDX_TYPE_DNS_SERVER]);
+	g_array_unref (priv->expiry_heap);
+
 	g_clear_object (&priv->netns);
 	g_clear_object (&priv->platform);
 
@@ -520,6 +520,204 @@ test_dns_solicit_loop (void)
 	g_main_loop_unref (data.loop);
 }
 
+static void
+test_expiry_order_cb (NMNDisc *ndisc, const NMNDiscData *rdata, guint changed_int, TestData *data)
+{
+	NMNDiscConfigMap changed = changed_int;
+
+	if (data->counter == 0) {
+		g_assert_cmpint (rdata->routes_n, ==, 2);
+		match_route (rdata, 0, "2001:db8:b::", 48, "fe80::1", data->timestamp1, 2, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+		match_route (rdata, 1, "2001:db8:a::", 48, "fe80::1", data->timestamp1, 4, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+	} else if (data->counter == 1) {
+		/* the route with the shorter lifetime expires first, although
+		 * it was added last. */
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_ROUTES);
+		g_assert_cmpint (rdata->routes_n, ==, 1);
+		match_route (rdata, 0, "2001:db8:a::", 48, "fe80::1", data->timestamp1, 4, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+	} else if (data->counter == 2) {
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_ROUTES);
+		g_assert_cmpint (rdata->routes_n, ==, 0);
+
+		g_assert (nm_fake_ndisc_done (NM_FAKE_NDISC (ndisc)));
+		g_main_loop_quit (data->loop);
+	} else
+		g_assert_not_reached ();
+
+	data->counter++;
+}
+
+static void
+test_expiry_order (void)
+{
+	NMFakeNDisc *ndisc = ndisc_new ();
+	guint32 now = nm_utils_get_monotonic_timestamp_s ();
+	TestData data = { g_main_loop_new (NULL, FALSE), 0, 0, now };
+	guint id;
+
+	id = nm_fake_ndisc_add_ra (ndisc, 0, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+	g_assert (id);
+	nm_fake_ndisc_add_prefix (ndisc, id, "2001:db8:a::", 48, "fe80::1", now, 4, 4, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+	nm_fake_ndisc_add_prefix (ndisc, id, "2001:db8:b::", 48, "fe80::1", now, 2, 2, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+
+	g_signal_connect (ndisc,
+	                  NM_NDISC_CONFIG_RECEIVED,
+	                  G_CALLBACK (test_expiry_order_cb),
+	                  &data);
+
+	nm_ndisc_start (NM_NDISC (ndisc));
+	g_main_loop_run (data.loop);
+	g_assert_cmpint (data.counter, ==, 3);
+
+	g_object_unref (ndisc);
+	g_main_loop_unref (data.loop);
+}
+
+static void
+test_expiry_readd_cb (NMNDisc *ndisc, const NMNDiscData *rdata, guint changed_int, TestData *data)
+{
+	NMNDiscConfigMap changed = changed_int;
+
+	if (data->counter == 0) {
+		g_assert_cmpint (rdata->routes_n, ==, 1);
+		match_route (rdata, 0, "2001:db8:a:a::", 64, "fe80::1", data->timestamp1, 2, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+		g_assert_cmpint (rdata->addresses_n, ==, 1);
+		match_address (rdata, 0, "2001:db8:a:a::1", data->timestamp1, 2, 2);
+	} else if (data->counter == 1) {
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_ADDRESSES |
+		                              NM_NDISC_CONFIG_ROUTES);
+		g_assert_cmpint (rdata->routes_n, ==, 0);
+		g_assert_cmpint (rdata->addresses_n, ==, 0);
+	} else if (data->counter == 2) {
+		/* the second RA brings the expired items back... */
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_ADDRESSES |
+		                              NM_NDISC_CONFIG_ROUTES);
+		g_assert_cmpint (rdata->routes_n, ==, 1);
+		match_route (rdata, 0, "2001:db8:a:a::", 64, "fe80::1", data->timestamp1 + 4, 2, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+		g_assert_cmpint (rdata->addresses_n, ==, 1);
+		match_address (rdata, 0, "2001:db8:a:a::1", data->timestamp1 + 4, 2, 2);
+	} else if (data->counter == 3) {
+		/* ... and they expire again. */
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_ADDRESSES |
+		                              NM_NDISC_CONFIG_ROUTES);
+		g_assert_cmpint (rdata->routes_n, ==, 0);
+		g_assert_cmpint (rdata->addresses_n, ==, 0);
+
+		g_assert (nm_fake_ndisc_done (NM_FAKE_NDISC (ndisc)));
+		g_main_loop_quit (data->loop);
+	} else
+		g_assert_not_reached ();
+
+	data->counter++;
+}
+
+static void
+test_expiry_readd (void)
+{
+	NMFakeNDisc *ndisc = ndisc_new ();
+	guint32 now = nm_utils_get_monotonic_timestamp_s ();
+	TestData data = { g_main_loop_new (NULL, FALSE), 0, 0, now };
+	guint id;
+
+	id = nm_fake_ndisc_add_ra (ndisc, 0, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+	g_assert (id);
+	nm_fake_ndisc_add_prefix (ndisc, id, "2001:db8:a:a::", 64, "fe80::1", now, 2, 2, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+
+	/* re-add the same prefix once it expired. */
+	id = nm_fake_ndisc_add_ra (ndisc, 4, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+	g_assert (id);
+	nm_fake_ndisc_add_prefix (ndisc, id, "2001:db8:a:a::", 64, "fe80::1", now + 4, 2, 2, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+
+	g_signal_connect (ndisc,
+	                  NM_NDISC_CONFIG_RECEIVED,
+	                  G_CALLBACK (test_expiry_readd_cb),
+	                  &data);
+
+	nm_ndisc_start (NM_NDISC (ndisc));
+	g_main_loop_run (data.loop);
+	g_assert_cmpint (data.counter, ==, 4);
+
+	g_object_unref (ndisc);
+	g_main_loop_unref (data.loop);
+}
+
+#define EXPIRY_COMPACT_N_ROUTES  8
+#define EXPIRY_COMPACT_N_REFRESH 30
+
+static void
+test_expiry_compact_cb (NMNDisc *ndisc, const NMNDiscData *rdata, guint changed_int, TestData *data)
+{
+	NMNDiscConfigMap changed = changed_int;
+	guint i;
+
+	if (data->counter == 0)
+		g_assert_cmpint (rdata->routes_n, ==, EXPIRY_COMPACT_N_ROUTES);
+	else if (data->counter == 1) {
+		/* only the routes with the short lifetime expired. The routes are
+		 * in reverse order of their addition. */
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_ROUTES);
+		g_assert_cmpint (rdata->routes_n, ==, EXPIRY_COMPACT_N_ROUTES / 2);
+		for (i = 0; i < EXPIRY_COMPACT_N_ROUTES / 2; i++) {
+			gs_free char *network = g_strdup_printf ("2001:db8:a%u::", EXPIRY_COMPACT_N_ROUTES - 1 - i);
+
+			match_route (rdata, i, network, 48, "fe80::1", data->timestamp1,
+			             100 + EXPIRY_COMPACT_N_REFRESH, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+		}
+
+		g_assert (nm_fake_ndisc_done (NM_FAKE_NDISC (ndisc)));
+		g_main_loop_quit (data->loop);
+	} else
+		g_assert_not_reached ();
+
+	data->counter++;
+}
+
+static void
+test_expiry_compact (void)
+{
+	NMFakeNDisc *ndisc = ndisc_new ();
+	guint32 now = nm_utils_get_monotonic_timestamp_s ();
+	TestData data = { g_main_loop_new (NULL, FALSE), 0, 0, now };
+	guint id;
+	guint i, j;
+
+	/* every refresh with a different lifetime leaves a stale expiry event
+	 * behind. Refresh the routes often enough within the first RA, so that
+	 * the stale events get dropped, and check that the routes still expire
+	 * correctly. */
+	id = nm_fake_ndisc_add_ra (ndisc, 0, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+	g_assert (id);
+	for (j = 0; j < EXPIRY_COMPACT_N_REFRESH; j++) {
+		for (i = 0; i < EXPIRY_COMPACT_N_ROUTES; i++) {
+			gs_free char *network = g_strdup_printf ("2001:db8:a%u::", i);
+
+			nm_fake_ndisc_add_prefix (ndisc, id, network, 48, "fe80::1", now, 100 + j, 100 + j, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+		}
+	}
+
+	/* the second RA shortens the lifetime of half of the routes. */
+	id = nm_fake_ndisc_add_ra (ndisc, 0, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+	g_assert (id);
+	for (i = 0; i < EXPIRY_COMPACT_N_ROUTES; i++) {
+		gs_free char *network = g_strdup_printf ("2001:db8:a%u::", i);
+		guint32 lifetime = i < EXPIRY_COMPACT_N_ROUTES / 2 ? 3 : 100 + EXPIRY_COMPACT_N_REFRESH;
+
+		nm_fake_ndisc_add_prefix (ndisc, id, network, 48, "fe80::1", now, lifetime, lifetime, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+	}
+
+	g_signal_connect (ndisc,
+	                  NM_NDISC_CONFIG_RECEIVED,
+	                  G_CALLBACK (test_expiry_compact_cb),
+	                  &data);
+
+	nm_ndisc_start (NM_NDISC (ndisc));
+	g_main_loop_run (data.loop);
+	g_assert_cmpint (data.counter, ==, 2);
+
+	g_object_unref (ndisc);
+	g_main_loop_unref (data.loop);
+}
+
 NMTST_DEFINE ();
 
 int
@@ -539,6 +737,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/ndisc/preference-order", test_preference_order);
 	g_test_add_func ("/ndisc/preference-changed", test_preference_changed);
 	g_test_add_func ("/ndisc/dns-solicit-loop", test_dns_solicit_loop);
+	g_test_add_func ("/ndisc/expiry-order", test_expiry_order);
+	g_test_add_func ("/ndisc/expiry-readd", test_expiry_readd);
+	g_test_add_func ("/ndisc/expiry-compact", test_expiry_compact);
 
 	return g_test_run ();
 }
@@ -38,6 +38,7 @@
 typedef struct _NMActiveConnectionPrivate {
 	NMDBusTrackObjPath settings_connection;
 	NMConnection *applied_connection;
+	NMConnection *applied_connection_snapshot;
 	char *specific_object;
 	NMDevice *device;
 
@@ -415,6 +416,51 @@ nm_active_connection_get_applied_connection (NMActiveConnection *self)
 	return connection;
 }
 
+/**
+ * nm_active_connection_get_applied_connection_snapshot:
+ * @self: the #NMActiveConnection
+ *
+ * Like nm_settings_connection_get_connection_snapshot(), for the
+ * applied connection.
+ *
+ * Returns: (transfer none): a shared copy of the applied connection,
+ *   that must never be modified.
+ */
+NMConnection *
+nm_active_connection_get_applied_connection_snapshot (NMActiveConnection *self)
+{
+	NMActiveConnectionPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (self), NULL);
+
+	priv = NM_ACTIVE_CONNECTION_GET_PRIVATE (self);
+	g_return_val_if_fail (priv->applied_connection, NULL);
+
+	if (!priv->applied_connection_snapshot)
+		priv->applied_connection_snapshot = nm_simple_connection_new_clone (priv->applied_connection);
+	return priv->applied_connection_snapshot;
+}
+
+static void
+_applied_connection_snapshot_invalidate_cb (NMConnection *connection, NMActiveConnection *self)
+{
+	g_clear_object (&NM_ACTIVE_CONNECTION_GET_PRIVATE (self)->applied_connection_snapshot);
+}
+
+static void
+_applied_connection_clear (NMActiveConnection *self)
+{
+	NMActiveConnectionPrivate *priv = NM_ACTIVE_CONNECTION_GET_PRIVATE (self);
+
+	if (priv->applied_connection) {
+		g_signal_handlers_disconnect_by_func (priv->applied_connection,
+		                                      G_CALLBACK (_applied_connection_snapshot_invalidate_cb),
+		                                      self);
+		g_clear_object (&priv->applied_connection);
+	}
+	g_clear_object (&priv->applied_connection_snapshot);
+}
+
 static void
 _set_applied_connection_take (NMActiveConnection *self,
                               NMConnection *applied_connection)
@@ -430,6 +476,15 @@ _set_applied_connection_take (NMActiveConnection *self,
 	priv->applied_connection = applied_connection;
 	nm_connection_clear_secrets (priv->applied_connection);
 
+	/* the applied connection gets modified in place, for example on
+	 * reapply or when secrets arrive. */
+	g_signal_connect (priv->applied_connection, NM_CONNECTION_CHANGED,
+	                  G_CALLBACK (_applied_connection_snapshot_invalidate_cb), self);
+	g_signal_connect (priv->applied_connection, NM_CONNECTION_SECRETS_CLEARED,
+	                  G_CALLBACK (_applied_connection_snapshot_invalidate_cb), self);
+	g_signal_connect (priv->applied_connection, NM_CONNECTION_SECRETS_UPDATED,
+	                  G_CALLBACK (_applied_connection_snapshot_invalidate_cb), self);
+
 	/* we determine whether the connection is a master/slave, based solely
 	 * on the connection properties itself. */
 	s_con = nm_connection_get_setting_connection (priv->applied_connection);
@@ -1448,7 +1503,7 @@ dispose (GObject *object)
 	nm_clear_g_free (&priv->specific_object);
 
 	_set_settings_connection (self, NULL);
-	g_clear_object (&priv->applied_connection);
+	_applied_connection_clear (self);
 
 	_device_cleanup (self);
 
@@ -118,6 +118,7 @@ void          nm_active_connection_authorize (NMActiveConnection *self,
 
 NMSettingsConnection *nm_active_connection_get_settings_connection (NMActiveConnection *self);
 NMConnection *nm_active_connection_get_applied_connection (NMActiveConnection *self);
+NMConnection *nm_active_connection_get_applied_connection_snapshot (NMActiveConnection *self);
 
 NMSettingsConnection *_nm_active_connection_get_settings_connection (NMActiveConnection *self);
 
@@ -41,8 +41,11 @@
 typedef struct {
 	char *original_dev_path;
 	NMDevice *device;
+
+	/* shared snapshots. They must not be modified. */
 	NMConnection *applied_connection;
 	NMConnection *settings_connection;
+
 	guint64 ac_version_id;
 	NMDeviceState state;
 	bool realized:1;
@@ -205,162 +208,287 @@ find_settings_connection (NMCheckpoint *self,
 	return sett_conn;
 }
 
-GVariant *
-nm_checkpoint_rollback (NMCheckpoint *self)
+static guint32
+device_checkpoint_rollback (NMCheckpoint *self,
+                            NMDevice *device,
+                            DeviceCheckpoint *dev_checkpoint)
 {
 	NMCheckpointPrivate *priv = NM_CHECKPOINT_GET_PRIVATE (self);
-	DeviceCheckpoint *dev_checkpoint;
-	GHashTableIter iter;
+	gs_unref_object NMAuthSubject *subject = NULL;
 	NMSettingsConnection *connection;
-	NMDevice *device;
 	GError *local_error = NULL;
-	GVariantBuilder builder;
+	guint32 result = NM_ROLLBACK_RESULT_OK;
 
-	_LOGI ("rollback of %s", nm_dbus_object_get_path (NM_DBUS_OBJECT (self)));
-	 g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
+	_LOGD ("rollback: restoring device %s (state %d, realized %d, explicitly unmanaged %d)",
+	       nm_device_get_iface (device),
+	       (int) dev_checkpoint->state,
+	       dev_checkpoint->realized,
+	       dev_checkpoint->unmanaged_explicit);
 
-	/* Start rolling-back each device */
-	g_hash_table_iter_init (&iter, priv->devices);
-	while (g_hash_table_iter_next (&iter, (gpointer *) &device, (gpointer *) &dev_checkpoint)) {
-		gs_unref_object NMAuthSubject *subject = NULL;
-		guint32 result = NM_ROLLBACK_RESULT_OK;
-
-		_LOGD ("rollback: restoring device %s (state %d, realized %d, explicitly unmanaged %d)",
-		       nm_device_get_iface (device),
-		       (int) dev_checkpoint->state,
-		       dev_checkpoint->realized,
-		       dev_checkpoint->unmanaged_explicit);
-
-		if (nm_device_is_real (device)) {
-			if (!dev_checkpoint->realized) {
-				_LOGD ("rollback: device was not realized, unmanage it");
-				nm_device_set_unmanaged_by_flags_queue (device,
-				                                        NM_UNMANAGED_USER_EXPLICIT,
-				                                        TRUE,
-				                                        NM_DEVICE_STATE_REASON_NOW_UNMANAGED);
-				goto next_dev;
-			}
-		} else {
-			if (dev_checkpoint->realized) {
-				if (nm_device_is_software (device)) {
-					/* try to recreate software device */
-					_LOGD ("rollback: software device not realized, will re-activate");
-					goto activate;
-				} else {
-					_LOGD ("rollback: device is not realized");
-					result = NM_ROLLBACK_RESULT_ERR_FAILED;
-				}
+	if (nm_device_is_real (device)) {
+		if (!dev_checkpoint->realized) {
+			_LOGD ("rollback: device was not realized, unmanage it");
+			nm_device_set_unmanaged_by_flags_queue (device,
+			                                        NM_UNMANAGED_USER_EXPLICIT,
+			                                        TRUE,
+			                                        NM_DEVICE_STATE_REASON_NOW_UNMANAGED);
+			return result;
+		}
+	} else {
+		if (dev_checkpoint->realized) {
+			if (nm_device_is_software (device)) {
+				/* try to recreate software device */
+				_LOGD ("rollback: software device not realized, will re-activate");
+				goto activate;
+			} else {
+				_LOGD ("rollback: device is not realized");
+				result = NM_ROLLBACK_RESULT_ERR_FAILED;
 			}
-			goto next_dev;
 		}
+		return result;
+	}
 
 activate:
-		/* Manage the device again if needed */
-		if (   nm_device_get_unmanaged_flags (device, NM_UNMANAGED_USER_EXPLICIT)
-		    && dev_checkpoint->unmanaged_explicit != NM_UNMAN_FLAG_OP_SET_UNMANAGED) {
-			_LOGD ("rollback: restore unmanaged user-explicit");
+	/* Manage the device again if needed */
+	if (   nm_device_get_unmanaged_flags (device, NM_UNMANAGED_USER_EXPLICIT)
+	    && dev_checkpoint->unmanaged_explicit != NM_UNMAN_FLAG_OP_SET_UNMANAGED) {
+		_LOGD ("rollback: restore unmanaged user-explicit");
+		nm_device_set_unmanaged_by_flags_queue (device,
+		                                        NM_UNMANAGED_USER_EXPLICIT,
+		                                        dev_checkpoint->unmanaged_explicit,
+		                                        NM_DEVICE_STATE_REASON_NOW_MANAGED);
+	}
+
+	if (dev_checkpoint->state == NM_DEVICE_STATE_UNMANAGED) {
+		if (   nm_device_get_state (device) != NM_DEVICE_STATE_UNMANAGED
+		    || dev_checkpoint->unmanaged_explicit == NM_UNMAN_FLAG_OP_SET_UNMANAGED) {
+			_LOGD ("rollback: explicitly unmanage device");
 			nm_device_set_unmanaged_by_flags_queue (device,
 			                                        NM_UNMANAGED_USER_EXPLICIT,
-			                                        dev_checkpoint->unmanaged_explicit,
-			                                        NM_DEVICE_STATE_REASON_NOW_MANAGED);
+			                                        TRUE,
+			                                        NM_DEVICE_STATE_REASON_NOW_UNMANAGED);
 		}
+		return result;
+	}
 
-		if (dev_checkpoint->state == NM_DEVICE_STATE_UNMANAGED) {
-			if (   nm_device_get_state (device) != NM_DEVICE_STATE_UNMANAGED
-			    || dev_checkpoint->unmanaged_explicit == NM_UNMAN_FLAG_OP_SET_UNMANAGED) {
-				_LOGD ("rollback: explicitly unmanage device");
-				nm_device_set_unmanaged_by_flags_queue (device,
-				                                        NM_UNMANAGED_USER_EXPLICIT,
-				                                        TRUE,
-				                                        NM_DEVICE_STATE_REASON_NOW_UNMANAGED);
+	if (dev_checkpoint->applied_connection) {
+		gs_unref_object NMConnection *settings_connection = NULL;
+		gboolean need_update, need_activation;
+
+		/* The device had an active connection: check if the
+		 * connection still exists, is active and was changed */
+		connection = find_settings_connection (self, dev_checkpoint, &need_update, &need_activation);
+		if (connection) {
+			if (need_update) {
+				_LOGD ("rollback: updating connection %s",
+				        nm_settings_connection_get_uuid (connection));
+				settings_connection = nm_simple_connection_new_clone (dev_checkpoint->settings_connection);
+				nm_settings_connection_update (connection,
+				                               settings_connection,
+				                               NM_SETTINGS_CONNECTION_PERSIST_MODE_DISK,
+				                               NM_SETTINGS_CONNECTION_COMMIT_REASON_NONE,
+				                               "checkpoint-rollback",
+				                               NULL);
+			}
+		} else {
+			/* The connection was deleted, recreate it */
+			_LOGD ("rollback: adding connection %s again",
+			       nm_connection_get_uuid (dev_checkpoint->settings_connection));
+
+			settings_connection = nm_simple_connection_new_clone (dev_checkpoint->settings_connection);
+			connection = nm_settings_add_connection (nm_settings_get (),
+			                                         settings_connection,
+			                                         TRUE,
+			                                         &local_error);
+			if (!connection) {
+				_LOGD ("rollback: connection add failure: %s", local_error->message);
+				g_clear_error (&local_error);
+				result = NM_ROLLBACK_RESULT_ERR_FAILED;
+				return result;
 			}
-			goto next_dev;
+			need_activation = TRUE;
 		}
 
-		if (dev_checkpoint->applied_connection) {
-			gboolean need_update, need_activation;
-
-			/* The device had an active connection: check if the
-			 * connection still exists, is active and was changed */
-			connection = find_settings_connection (self, dev_checkpoint, &need_update, &need_activation);
-			if (connection) {
-				if (need_update) {
-					_LOGD ("rollback: updating connection %s",
-					        nm_settings_connection_get_uuid (connection));
-					nm_settings_connection_update (connection,
-					                               dev_checkpoint->settings_connection,
-					                               NM_SETTINGS_CONNECTION_PERSIST_MODE_DISK,
-					                               NM_SETTINGS_CONNECTION_COMMIT_REASON_NONE,
-					                               "checkpoint-rollback",
-					                               NULL);
-				}
-			} else {
-				/* The connection was deleted, recreate it */
-				_LOGD ("rollback: adding connection %s again",
-				       nm_connection_get_uuid (dev_checkpoint->settings_connection));
-
-				connection = nm_settings_add_connection (nm_settings_get (),
-				                                         dev_checkpoint->settings_connection,
-				                                         TRUE,
-				                                         &local_error);
-				if (!connection) {
-					_LOGD ("rollback: connection add failure: %s", local_error->message);
-					g_clear_error (&local_error);
-					result = NM_ROLLBACK_RESULT_ERR_FAILED;
-					goto next_dev;
-				}
-				need_activation = TRUE;
-			}
+		if (need_activation) {
+			gs_unref_object NMConnection *applied_connection = NULL;
 
-			if (need_activation) {
-				_LOGD ("rollback: reactivating connection %s",
-				       nm_settings_connection_get_uuid (connection));
-				subject = nm_auth_subject_new_internal ();
-
-				/* Disconnect the device if needed. This necessary because now
-				 * the manager prevents the reactivation of the same connection by
-				 * an internal subject. */
-				if (   nm_device_get_state (device) > NM_DEVICE_STATE_DISCONNECTED
-				    && nm_device_get_state (device) < NM_DEVICE_STATE_DEACTIVATING) {
-					nm_device_state_changed (device,
-					                         NM_DEVICE_STATE_DEACTIVATING,
-					                         NM_DEVICE_STATE_REASON_NEW_ACTIVATION);
-				}
-
-				if (!nm_manager_activate_connection (priv->manager,
-				                                     connection,
-				                                     dev_checkpoint->applied_connection,
-				                                     NULL,
-				                                     device,
-				                                     subject,
-				                                     NM_ACTIVATION_TYPE_MANAGED,
-				                                     dev_checkpoint->activation_reason,
-				                                     &local_error)) {
-					_LOGW ("rollback: reactivation of connection %s/%s failed: %s",
-					       nm_settings_connection_get_id (connection),
-					       nm_settings_connection_get_uuid (connection),
-					       local_error->message);
-					g_clear_error (&local_error);
-					result = NM_ROLLBACK_RESULT_ERR_FAILED;
-					goto next_dev;
-				}
-			}
-		} else {
-			/* The device was initially disconnected, deactivate any existing connection */
-			_LOGD ("rollback: disconnecting device");
+			_LOGD ("rollback: reactivating connection %s",
+			       nm_settings_connection_get_uuid (connection));
+			subject = nm_auth_subject_new_internal ();
 
+			/* Disconnect the device if needed. This necessary because now
+			 * the manager prevents the reactivation of the same connection by
+			 * an internal subject. */
 			if (   nm_device_get_state (device) > NM_DEVICE_STATE_DISCONNECTED
 			    && nm_device_get_state (device) < NM_DEVICE_STATE_DEACTIVATING) {
 				nm_device_state_changed (device,
 				                         NM_DEVICE_STATE_DEACTIVATING,
-				                         NM_DEVICE_STATE_REASON_USER_REQUESTED);
+				                         NM_DEVICE_STATE_REASON_NEW_ACTIVATION);
+			}
+
+			/* the active connection modifies its applied connection. */
+			applied_connection = nm_simple_connection_new_clone (dev_checkpoint->applied_connection);
+			if (!nm_manager_activate_connection (priv->manager,
+			                                     connection,
+			                                     applied_connection,
+			                                     NULL,
+			                                     device,
+			                                     subject,
+			                                     NM_ACTIVATION_TYPE_MANAGED,
+			                                     dev_checkpoint->activation_reason,
+			                                     &local_error)) {
+				_LOGW ("rollback: reactivation of connection %s/%s failed: %s",
+				       nm_settings_connection_get_id (connection),
+				       nm_settings_connection_get_uuid (connection),
+				       local_error->message);
+				g_clear_error (&local_error);
+				result = NM_ROLLBACK_RESULT_ERR_FAILED;
+				return result;
 			}
 		}
+	} else {
+		/* The device was initially disconnected, deactivate any existing connection */
+		_LOGD ("rollback: disconnecting device");
+
+		if (   nm_device_get_state (device) > NM_DEVICE_STATE_DISCONNECTED
+		    && nm_device_get_state (device) < NM_DEVICE_STATE_DEACTIVATING) {
+			nm_device_state_changed (device,
+			                         NM_DEVICE_STATE_DEACTIVATING,
+			                         NM_DEVICE_STATE_REASON_USER_REQUESTED);
+		}
+	}
 
-next_dev:
-		g_variant_builder_add (&builder, "{su}", dev_checkpoint->original_dev_path, result);
+	return result;
+}
+
+typedef struct {
+	NMDevice *device;
+	DeviceCheckpoint *dev_checkpoint;
+	guint depth;
+	guint idx;
+} RollbackItem;
+
+#define ROLLBACK_MAX_DEPTH 8
+
+/* The number of checkpointed devices that need to be restored before
+ * @dev_checkpoint: its parent (for VLANs and alike) and its master. */
+static guint
+device_checkpoint_get_depth (NMCheckpoint *self,
+                             DeviceCheckpoint *dev_checkpoint,
+                             GHashTable *by_master_name,
+                             guint level)
+{
+	NMCheckpointPrivate *priv = NM_CHECKPOINT_GET_PRIVATE (self);
+	DeviceCheckpoint *other;
+	NMSettingConnection *s_con;
+	NMDevice *parent;
+	const char *master;
+	guint depth = 0;
+
+	/* guard against loops */
+	if (level >= ROLLBACK_MAX_DEPTH)
+		return 0;
+
+	parent = nm_device_parent_get_device (dev_checkpoint->device);
+	if (parent) {
+		other = g_hash_table_lookup (priv->devices, parent);
+		if (other && other != dev_checkpoint)
+			depth = MAX (depth, device_checkpoint_get_depth (self, other, by_master_name, level + 1) + 1);
 	}
 
+	if (dev_checkpoint->applied_connection) {
+		s_con = nm_connection_get_setting_connection (dev_checkpoint->applied_connection);
+		master = s_con ? nm_setting_connection_get_master (s_con) : NULL;
+		if (master) {
+			other = g_hash_table_lookup (by_master_name, master);
+			if (other && other != dev_checkpoint)
+				depth = MAX (depth, device_checkpoint_get_depth (self, other, by_master_name, level + 1) + 1);
+		}
+	}
+
+	return depth;
+}
+
+static int
+rollback_item_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const RollbackItem *item_a = a;
+	const RollbackItem *item_b = b;
+
+	NM_CMP_FIELD (item_a, item_b, depth);
+	NM_CMP_FIELD (item_a, item_b, idx);
+	return 0;
+}
+
+GVariant *
+nm_checkpoint_rollback (NMCheckpoint *self)
+{
+	NMCheckpointPrivate *priv = NM_CHECKPOINT_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *by_master_name = NULL;
+	gs_free RollbackItem *items = NULL;
+	DeviceCheckpoint *dev_checkpoint;
+	GHashTableIter iter;
+	NMDevice *device;
+	GVariantBuilder builder;
+	gint64 start_us, t_us;
+	guint i, n;
+
+	_LOGI ("rollback of %s", nm_dbus_object_get_path (NM_DBUS_OBJECT (self)));
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
+
+	start_us = nm_utils_get_monotonic_timestamp_us ();
+
+	/* Index the devices by the names slaves use to refer to their master. */
+	by_master_name = g_hash_table_new (nm_str_hash, g_str_equal);
+	g_hash_table_iter_init (&iter, priv->devices);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &dev_checkpoint)) {
+		const char *iface;
+
+		if (!dev_checkpoint->applied_connection)
+			continue;
+		iface = nm_device_get_iface (dev_checkpoint->device);
+		if (iface)
+			g_hash_table_insert (by_master_name, (gpointer) iface, dev_checkpoint);
+		g_hash_table_insert (by_master_name,
+		                     (gpointer) nm_connection_get_uuid (dev_checkpoint->applied_connection),
+		                     dev_checkpoint);
+	}
+
+	n = g_hash_table_size (priv->devices);
+	items = g_new (RollbackItem, n);
+	i = 0;
+	g_hash_table_iter_init (&iter, priv->devices);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &device, (gpointer *) &dev_checkpoint)) {
+		items[i] = (RollbackItem) {
+			.device = device,
+			.dev_checkpoint = dev_checkpoint,
+			.depth = device_checkpoint_get_depth (self, dev_checkpoint, by_master_name, 0),
+			.idx = i,
+		};
+		i++;
+	}
+
+	/* Restore parents and masters before the devices that depend on them.
+	 * The restorations only queue state changes and activations, which
+	 * then proceed concurrently. */
+	g_qsort_with_data (items, n, sizeof (RollbackItem), rollback_item_cmp, NULL);
+
+	for (i = 0; i < n; i++) {
+		guint32 result;
+
+		t_us = nm_utils_get_monotonic_timestamp_us ();
+		result = device_checkpoint_rollback (self, items[i].device, items[i].dev_checkpoint);
+		_LOGD ("rollback: device %s (depth %u) restored with result %u in %"G_GINT64_FORMAT" usec",
+		       nm_device_get_iface (items[i].device),
+		       items[i].depth,
+		       result,
+		       nm_utils_get_monotonic_timestamp_us () - t_us);
+		g_variant_builder_add (&builder, "{su}", items[i].dev_checkpoint->original_dev_path, result);
+	}
+
+	_LOGD ("rollback: restored %u devices in %"G_GINT64_FORMAT" usec",
+	       n, nm_utils_get_monotonic_timestamp_us () - start_us);
+
 	if (NM_FLAGS_HAS (priv->flags, NM_CHECKPOINT_CREATE_FLAG_DELETE_NEW_CONNECTIONS)) {
 		NMSettingsConnection *con;
 		gs_free NMSettingsConnection **list = NULL;
@@ -408,7 +536,6 @@ static DeviceCheckpoint *
 device_checkpoint_create (NMDevice *device)
 {
 	DeviceCheckpoint *dev_checkpoint;
-	NMConnection *applied_connection;
 	NMSettingsConnection *settings_connection;
 	const char *path;
 	NMActRequest *act_request;
@@ -433,10 +560,11 @@ device_checkpoint_create (NMDevice *device)
 	act_request = nm_device_get_act_request (device);
 	if (act_request) {
 		settings_connection = nm_act_request_get_settings_connection (act_request);
-		applied_connection = nm_act_request_get_applied_connection (act_request);
 
-		dev_checkpoint->applied_connection = nm_simple_connection_new_clone (applied_connection);
-		dev_checkpoint->settings_connection = nm_simple_connection_new_clone (nm_settings_connection_get_connection (settings_connection));
+		/* most devices don't change until the checkpoint is destroyed, so
+		 * take the shared snapshots instead of cloning the connections. */
+		dev_checkpoint->applied_connection = g_object_ref (nm_active_connection_get_applied_connection_snapshot (NM_ACTIVE_CONNECTION (act_request)));
+		dev_checkpoint->settings_connection = g_object_ref (nm_settings_connection_get_connection_snapshot (settings_connection));
 		dev_checkpoint->ac_version_id = nm_active_connection_version_id_get (NM_ACTIVE_CONNECTION (act_request));
 		dev_checkpoint->activation_reason = nm_active_connection_get_activation_reason (NM_ACTIVE_CONNECTION (act_request));
 	}
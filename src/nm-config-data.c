@@ -795,28 +795,26 @@ nm_global_dns_config_is_empty (const NMGlobalDnsConfig *dns_config)
 }
 
 void
-nm_global_dns_config_update_checksum (const NMGlobalDnsConfig *dns_config, GChecksum *sum)
+nm_global_dns_config_hash (const NMGlobalDnsConfig *dns_config, NMHashState *h)
 {
 	NMGlobalDnsDomain *domain;
 	guint i, j;
-	guint8 v8;
 
 	g_return_if_fail (dns_config);
-	g_return_if_fail (sum);
+	g_return_if_fail (h);
 
-	v8 = NM_HASH_COMBINE_BOOLS (guint8,
-	                            !dns_config->searches,
-	                            !dns_config->options,
-	                            !dns_config->domain_list);
-	g_checksum_update (sum, (guchar *) &v8, 1);
+	nm_hash_update_bools (h,
+	                      !dns_config->searches,
+	                      !dns_config->options,
+	                      !dns_config->domain_list);
 
 	if (dns_config->searches) {
 		for (i = 0; dns_config->searches[i]; i++)
-			g_checksum_update (sum, (guchar *) dns_config->searches[i], strlen (dns_config->searches[i]) + 1);
+			nm_hash_update_str (h, dns_config->searches[i]);
 	}
 	if (dns_config->options) {
 		for (i = 0; dns_config->options[i]; i++)
-			g_checksum_update (sum, (guchar *) dns_config->options[i], strlen (dns_config->options[i]) + 1);
+			nm_hash_update_str (h, dns_config->options[i]);
 	}
 
 	if (dns_config->domain_list) {
@@ -824,20 +822,19 @@ nm_global_dns_config_update_checksum (const NMGlobalDnsConfig *dns_config, GChec
 			domain = g_hash_table_lookup (dns_config->domains, dns_config->domain_list[i]);
 			nm_assert (domain);
 
-			v8 = NM_HASH_COMBINE_BOOLS (guint8,
-			                            !domain->servers,
-			                            !domain->options);
-			g_checksum_update (sum, (guchar *) &v8, 1);
+			nm_hash_update_bools (h,
+			                      !domain->servers,
+			                      !domain->options);
 
-			g_checksum_update (sum, (guchar *) domain->name, strlen (domain->name) + 1);
+			nm_hash_update_str (h, domain->name);
 
 			if (domain->servers) {
 				for (j = 0; domain->servers[j]; j++)
-					g_checksum_update (sum, (guchar *) domain->servers[j], strlen (domain->servers[j]) + 1);
+					nm_hash_update_str (h, domain->servers[j]);
 			}
 			if (domain->options) {
 				for (j = 0; domain->options[j]; j++)
-					g_checksum_update (sum, (guchar *) domain->options[j], strlen (domain->options[j]) + 1);
+					nm_hash_update_str (h, domain->options[j]);
 			}
 		}
 	}
@@ -221,7 +221,7 @@ const char *const *nm_global_dns_domain_get_servers (const NMGlobalDnsDomain *do
 const char *const *nm_global_dns_domain_get_options (const NMGlobalDnsDomain *domain);
 gboolean nm_global_dns_config_is_internal (const NMGlobalDnsConfig *dns_config);
 gboolean nm_global_dns_config_is_empty (const NMGlobalDnsConfig *dns_config);
-void nm_global_dns_config_update_checksum (const NMGlobalDnsConfig *dns_config, GChecksum *sum);
+void nm_global_dns_config_hash (const NMGlobalDnsConfig *dns_config, NMHashState *h);
 void nm_global_dns_config_free (NMGlobalDnsConfig *dns_config);
 
 NMGlobalDnsConfig *nm_global_dns_config_from_dbus (const GValue *value, GError **error);
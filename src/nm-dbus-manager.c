@@ -47,8 +47,18 @@
 
 typedef struct {
 	GVariant *value;
+	bool pending_notify:1;
 } PropertyCacheData;
 
+typedef struct {
+	const NMDBusInterfaceInfoExtended *interface_info;
+	const GParamSpec *pspec;
+
+	/* the index of the property in @interface_info, or G_MAXUINT if
+	 * the interface has no property for @pspec. */
+	guint property_idx;
+} PropertyIdxData;
+
 typedef struct {
 	CList registration_lst;
 	NMDBusObject *obj;
@@ -75,6 +85,14 @@ typedef struct {
 	GHashTable *objects_by_path;
 	CList objects_lst_head;
 
+	/* maps (interface-info, pspec) tuples to the index of the D-Bus property. */
+	GHashTable *property_idx_by_pspec;
+
+	/* objects with pending PropertiesChanged notifications, that are
+	 * emitted together on idle. */
+	CList notify_lst_head;
+	guint notify_idle_id;
+
 	CList private_servers_lst_head;
 
 	NMDBusManagerSetPropertyHandler set_property_handler;
@@ -114,6 +132,7 @@ static const GDBusSignalInfo signal_info_objmgr_interfaces_added;
 static const GDBusSignalInfo signal_info_objmgr_interfaces_removed;
 static GVariantBuilder *_obj_collect_properties_all (NMDBusObject *obj,
                                                      GVariantBuilder *builder);
+static void _obj_notify_flush (NMDBusManager *self);
 
 /*****************************************************************************/
 
@@ -147,6 +166,35 @@ _objects_by_path_equal (gconstpointer user_data_a, gconstpointer user_data_b)
 
 /*****************************************************************************/
 
+static guint
+_property_idx_hash (gconstpointer ptr)
+{
+	const PropertyIdxData *data = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1771532243u);
+	nm_hash_update_vals (&h, data->interface_info, data->pspec);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_property_idx_equal (gconstpointer ptr_a, gconstpointer ptr_b)
+{
+	const PropertyIdxData *a = ptr_a;
+	const PropertyIdxData *b = ptr_b;
+
+	return    a->interface_info == b->interface_info
+	       && a->pspec == b->pspec;
+}
+
+static void
+_property_idx_free (gpointer ptr)
+{
+	g_slice_free (PropertyIdxData, ptr);
+}
+
+/*****************************************************************************/
+
 typedef struct {
 	CList private_servers_lst;
 
@@ -1145,6 +1193,12 @@ _nm_dbus_manager_obj_unexport (NMDBusObject *obj)
 	nm_assert (&obj->internal == g_hash_table_lookup (priv->objects_by_path, &obj->internal));
 	nm_assert (c_list_contains (&priv->objects_lst_head, &obj->internal.objects_lst));
 
+	/* the listeners of the exported-changed signal just cleared their references
+	 * to @obj. Send out these (and all other pending) property changes before
+	 * the object disappears from the bus. */
+	_obj_notify_flush (self);
+	nm_assert (c_list_is_empty (&obj->internal.notify_lst));
+
 	_obj_unregister (self, obj);
 
 	if (!g_hash_table_remove (priv->objects_by_path, &obj->internal))
@@ -1152,15 +1206,50 @@ _nm_dbus_manager_obj_unexport (NMDBusObject *obj)
 	c_list_unlink (&obj->internal.objects_lst);
 }
 
-void
-_nm_dbus_manager_obj_notify (NMDBusObject *obj,
-                             guint n_pspecs,
-                             const GParamSpec *const*pspecs)
+static guint
+_property_idx_lookup (NMDBusManager *self,
+                      const NMDBusInterfaceInfoExtended *interface_info,
+                      const GParamSpec *pspec)
 {
-	NMDBusManager *self;
-	NMDBusManagerPrivate *priv;
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	PropertyIdxData *data;
+	PropertyIdxData needle = {
+		.interface_info = interface_info,
+		.pspec = pspec,
+	};
+	guint i;
+
+	data = g_hash_table_lookup (priv->property_idx_by_pspec, &needle);
+	if (G_LIKELY (data))
+		return data->property_idx;
+
+	/* first time we see this combination. Search the property by name
+	 * and remember the result (also if there is no such property). The number
+	 * of interfaces and properties is static, so the index is bounded in size. */
+	data = g_slice_new (PropertyIdxData);
+	*data = needle;
+	data->property_idx = G_MAXUINT;
+	if (interface_info->parent.properties) {
+		for (i = 0; interface_info->parent.properties[i]; i++) {
+			const NMDBusPropertyInfoExtended *property_info = (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+
+			if (nm_streq (property_info->property_name, pspec->name)) {
+				data->property_idx = i;
+				break;
+			}
+		}
+	}
+	g_hash_table_add (priv->property_idx_by_pspec, data);
+	return data->property_idx;
+}
+
+static void
+_obj_notify_emit (NMDBusManager *self,
+                  NMDBusObject *obj)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	RegistrationData *reg_data;
-	guint i, p;
+	guint i;
 	gboolean any_legacy_signals = FALSE;
 	gboolean any_legacy_properties = FALSE;
 	GVariantBuilder legacy_builder;
@@ -1168,8 +1257,9 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 
 	nm_assert (NM_IS_DBUS_OBJECT (obj));
 	nm_assert (obj->internal.path);
-	nm_assert (NM_IS_DBUS_MANAGER (obj->internal.bus_manager));
-	nm_assert (!c_list_is_empty (&obj->internal.objects_lst));
+	nm_assert (priv->connection);
+
+	c_list_unlink (&obj->internal.notify_lst);
 
 	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
 		if (_reg_data_get_interface_info (reg_data)->legacy_property_changed) {
@@ -1178,16 +1268,8 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 		}
 	}
 
-	self = obj->internal.bus_manager;
-	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
-
-	/* do a naive search for the matching NMDBusPropertyInfoExtended infos. Since the number of
-	 * (interaces x properties) is static and possibly small, this naive search is effectively
-	 * O(1). We might wanna introduce some index to lookup the properties in question faster.
-	 *
-	 * The nice part of this implementation is however, that the order in which properties
-	 * are added to the GVariant is strictly defined to be the order in which the D-Bus property-info
-	 * is declared. Getting a defined ordering with some smart lookup would be hard. */
+	/* the order in which properties are added to the GVariant is strictly defined to
+	 * be the order in which the D-Bus property-info is declared. */
 	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
 		const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info (reg_data);
 		gboolean has_properties = FALSE;
@@ -1200,32 +1282,31 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 
 		for (i = 0; interface_info->parent.properties[i]; i++) {
 			const NMDBusPropertyInfoExtended *property_info = (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+			gs_unref_variant GVariant *value = NULL;
 
-			for (p = 0; p < n_pspecs; p++) {
-				const GParamSpec *pspec = pspecs[p];
-				gs_unref_variant GVariant *value = NULL;
-
-				if (!nm_streq (property_info->property_name, pspec->name))
-					continue;
-
-				value = _obj_get_property (reg_data, i, TRUE);
-
-				if (   property_info->include_in_legacy_property_changed
-				    && any_legacy_signals) {
-					/* also track the value in the legacy_builder to emit legacy signals below. */
-					if (!any_legacy_properties) {
-						any_legacy_properties = TRUE;
-						g_variant_builder_init (&legacy_builder, G_VARIANT_TYPE ("a{sv}"));
-					}
-					g_variant_builder_add (&legacy_builder, "{sv}", property_info->parent.name, value);
+			if (!reg_data->property_cache[i].pending_notify)
+				continue;
+			reg_data->property_cache[i].pending_notify = FALSE;
+
+			/* the cached value was cleared when the property was notified. If it is
+			 * set again, it was fetched afterwards and is up to date. */
+			value = _obj_get_property (reg_data, i, FALSE);
+
+			if (   property_info->include_in_legacy_property_changed
+			    && any_legacy_signals) {
+				/* also track the value in the legacy_builder to emit legacy signals below. */
+				if (!any_legacy_properties) {
+					any_legacy_properties = TRUE;
+					g_variant_builder_init (&legacy_builder, G_VARIANT_TYPE ("a{sv}"));
 				}
+				g_variant_builder_add (&legacy_builder, "{sv}", property_info->parent.name, value);
+			}
 
-				if (!has_properties) {
-					has_properties = TRUE;
-					g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
-				}
-				g_variant_builder_add (&builder, "{sv}", property_info->parent.name, value);
+			if (!has_properties) {
+				has_properties = TRUE;
+				g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
 			}
+			g_variant_builder_add (&builder, "{sv}", property_info->parent.name, value);
 		}
 
 		if (!has_properties)
@@ -1306,6 +1387,84 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 	}
 }
 
+static void
+_obj_notify_flush (NMDBusManager *self)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	NMDBusObject *obj;
+
+	while ((obj = c_list_first_entry (&priv->notify_lst_head, NMDBusObject, internal.notify_lst)))
+		_obj_notify_emit (self, obj);
+}
+
+static gboolean
+_obj_notify_idle_cb (gpointer user_data)
+{
+	NMDBusManager *self = user_data;
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	priv->notify_idle_id = 0;
+	_obj_notify_flush (self);
+	return G_SOURCE_REMOVE;
+}
+
+void
+_nm_dbus_manager_obj_notify (NMDBusObject *obj,
+                             guint n_pspecs,
+                             const GParamSpec *const*pspecs)
+{
+	NMDBusManager *self;
+	NMDBusManagerPrivate *priv;
+	RegistrationData *reg_data;
+	gboolean any_pending = FALSE;
+	guint p;
+
+	nm_assert (NM_IS_DBUS_OBJECT (obj));
+	nm_assert (obj->internal.path);
+	nm_assert (NM_IS_DBUS_MANAGER (obj->internal.bus_manager));
+	nm_assert (!c_list_is_empty (&obj->internal.objects_lst));
+
+	if (c_list_is_empty (&obj->internal.registration_lst_head))
+		return;
+
+	self = obj->internal.bus_manager;
+	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	/* We don't emit the PropertiesChanged signals right away. Instead, we only
+	 * mark the properties as pending and emit all pending changes of all
+	 * objects at once on idle. That way, multiple notifications for the same object
+	 * during one main-loop iteration are combined into one signal. */
+	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
+		const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info (reg_data);
+
+		if (!interface_info->parent.properties)
+			continue;
+
+		for (p = 0; p < n_pspecs; p++) {
+			guint i;
+
+			i = _property_idx_lookup (self, interface_info, pspecs[p]);
+			if (i == G_MAXUINT)
+				continue;
+
+			/* the value changed, drop the cached value so that both Get() and the
+			 * signal will fetch the current one. */
+			nm_clear_g_variant (&reg_data->property_cache[i].value);
+			reg_data->property_cache[i].pending_notify = TRUE;
+			any_pending = TRUE;
+		}
+	}
+
+	if (!any_pending)
+		return;
+
+	if (c_list_is_empty (&obj->internal.notify_lst))
+		c_list_link_tail (&priv->notify_lst_head, &obj->internal.notify_lst);
+
+	if (!priv->notify_idle_id)
+		priv->notify_idle_id = g_idle_add_full (G_PRIORITY_DEFAULT, _obj_notify_idle_cb, self, NULL);
+}
+
 void
 _nm_dbus_manager_obj_emit_signal (NMDBusObject *obj,
                                   const NMDBusInterfaceInfoExtended *interface_info,
@@ -1328,6 +1487,10 @@ _nm_dbus_manager_obj_emit_signal (NMDBusObject *obj,
 		return;
 	}
 
+	/* preserve the order of property changes and signals on @obj. */
+	if (!c_list_is_empty (&obj->internal.notify_lst))
+		_obj_notify_emit (self, obj);
+
 	g_dbus_connection_emit_signal (priv->connection,
 	                               NULL,
 	                               obj->internal.path,
@@ -1596,6 +1759,8 @@ nm_dbus_manager_stop (NMDBusManager *self)
 
 	priv->shutting_down = TRUE;
 
+	_obj_notify_flush (self);
+
 	/* during shutdown we also clear the set-property-handler. It's no longer
 	 * possible to set a property, because doing so would require authorization,
 	 * which is async, which is just complicated to get right. No more property
@@ -1619,7 +1784,9 @@ nm_dbus_manager_init (NMDBusManager *self)
 
 	c_list_init (&priv->private_servers_lst_head);
 	c_list_init (&priv->objects_lst_head);
+	c_list_init (&priv->notify_lst_head);
 	priv->objects_by_path = g_hash_table_new ((GHashFunc) _objects_by_path_hash, (GEqualFunc) _objects_by_path_equal);
+	priv->property_idx_by_pspec = g_hash_table_new_full (_property_idx_hash, _property_idx_equal, _property_idx_free, NULL);
 }
 
 static void
@@ -1633,8 +1800,11 @@ dispose (GObject *object)
 	 * expect any remaining objects. */
 	nm_assert (!priv->objects_by_path || g_hash_table_size (priv->objects_by_path) == 0);
 	nm_assert (c_list_is_empty (&priv->objects_lst_head));
+	nm_assert (c_list_is_empty (&priv->notify_lst_head));
 
+	nm_clear_g_source (&priv->notify_idle_id);
 	g_clear_pointer (&priv->objects_by_path, g_hash_table_destroy);
+	g_clear_pointer (&priv->property_idx_by_pspec, g_hash_table_destroy);
 
 	c_list_for_each_entry_safe (s, s_safe, &priv->private_servers_lst_head, private_servers_lst)
 		private_server_free (s);
@@ -240,6 +240,7 @@ nm_dbus_object_init (NMDBusObject *self)
 {
 	c_list_init (&self->internal.objects_lst);
 	c_list_init (&self->internal.registration_lst_head);
+	c_list_init (&self->internal.notify_lst);
 	self->internal.bus_manager = nm_g_object_ref (nm_dbus_manager_get ());
 }
 
@@ -0,0 +1,203 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2026 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-dispatcher-coalesce.h"
+
+#include "c-list/src/c-list.h"
+
+/*****************************************************************************/
+
+struct _NMDispatcherCoalesce {
+	CList lst;
+	NMDispatcherCoalesceQueue *queue;
+	NMDispatcherAction action;
+	GObject *device;
+	NMConnectivityState connectivity_state;
+	bool in_flight:1;
+	bool again:1;
+};
+
+struct _NMDispatcherCoalesceQueue {
+	CList lst_head;
+	NMDispatcherCoalesceSendFunc send_func;
+	gpointer user_data;
+};
+
+/*****************************************************************************/
+
+static void
+_coalesce_free (NMDispatcherCoalesce *coalesce)
+{
+	c_list_unlink_stale (&coalesce->lst);
+	g_clear_object (&coalesce->device);
+	g_slice_free (NMDispatcherCoalesce, coalesce);
+}
+
+static gboolean
+_coalesce_dispatch (NMDispatcherCoalesce *coalesce)
+{
+	NMDispatcherCoalesceQueue *queue = coalesce->queue;
+	gboolean success;
+
+	coalesce->in_flight = FALSE;
+	success = queue->send_func (coalesce,
+	                            coalesce->action,
+	                            coalesce->device,
+	                            coalesce->connectivity_state,
+	                            queue->user_data);
+	if (!coalesce->in_flight)
+		_coalesce_free (coalesce);
+	return success;
+}
+
+void
+nm_dispatcher_coalesce_set_in_flight (NMDispatcherCoalesce *coalesce)
+{
+	nm_assert (coalesce);
+
+	coalesce->in_flight = TRUE;
+}
+
+/**
+ * nm_dispatcher_coalesce_complete:
+ * @coalesce: the action that completed
+ *
+ * Called once the action sent by the send function is done. If further
+ * actions were coalesced meanwhile, the action is sent once more.
+ */
+void
+nm_dispatcher_coalesce_complete (NMDispatcherCoalesce *coalesce)
+{
+	nm_assert (coalesce && coalesce->in_flight);
+
+	if (!coalesce->again) {
+		_coalesce_free (coalesce);
+		return;
+	}
+
+	coalesce->again = FALSE;
+	_coalesce_dispatch (coalesce);
+}
+
+/**
+ * nm_dispatcher_coalesce_queue_add:
+ * @queue: the queue
+ * @action: the action
+ * @device: (allow-none): the device, or %NULL for "connectivity-change"
+ * @connectivity_state: the connectivity state
+ * @out_coalesced: (allow-none): set to %TRUE if the action was merged
+ *   into a pending one.
+ *
+ * Send the action right away, or coalesce it with the pending one of the
+ * same kind for @device.
+ *
+ * Returns: whether the action was sent or coalesced.
+ */
+gboolean
+nm_dispatcher_coalesce_queue_add (NMDispatcherCoalesceQueue *queue,
+                                  NMDispatcherAction action,
+                                  gpointer device,
+                                  NMConnectivityState connectivity_state,
+                                  gboolean *out_coalesced)
+{
+	NMDispatcherCoalesce *coalesce;
+
+	nm_assert (queue);
+	nm_assert (!device || G_IS_OBJECT (device));
+
+	c_list_for_each_entry (coalesce, &queue->lst_head, lst) {
+		if (   coalesce->action == action
+		    && coalesce->device == device) {
+			coalesce->connectivity_state = connectivity_state;
+			coalesce->again = TRUE;
+			NM_SET_OUT (out_coalesced, TRUE);
+			return TRUE;
+		}
+	}
+
+	coalesce = g_slice_new0 (NMDispatcherCoalesce);
+	coalesce->queue = queue;
+	coalesce->action = action;
+	coalesce->device = device ? g_object_ref (device) : NULL;
+	coalesce->connectivity_state = connectivity_state;
+	c_list_link_tail (&queue->lst_head, &coalesce->lst);
+	NM_SET_OUT (out_coalesced, FALSE);
+	return _coalesce_dispatch (coalesce);
+}
+
+/**
+ * nm_dispatcher_coalesce_queue_drop:
+ * @queue: the queue
+ * @device: the device
+ *
+ * Drop the coalesced actions for @device that are still waiting for the
+ * pending one to complete. Call this before sending another action for
+ * @device, like "pre-down" or "down". Otherwise, the coalesced action
+ * would be sent after it, with a state that is no longer current.
+ *
+ * Returns: the number of dropped actions.
+ */
+guint
+nm_dispatcher_coalesce_queue_drop (NMDispatcherCoalesceQueue *queue,
+                                   gpointer device)
+{
+	NMDispatcherCoalesce *coalesce;
+	guint n = 0;
+
+	nm_assert (queue);
+
+	c_list_for_each_entry (coalesce, &queue->lst_head, lst) {
+		if (   coalesce->device == device
+		    && coalesce->again) {
+			coalesce->again = FALSE;
+			n++;
+		}
+	}
+	return n;
+}
+
+NMDispatcherCoalesceQueue *
+nm_dispatcher_coalesce_queue_new (NMDispatcherCoalesceSendFunc send_func,
+                                  gpointer user_data)
+{
+	NMDispatcherCoalesceQueue *queue;
+
+	g_return_val_if_fail (send_func, NULL);
+
+	queue = g_slice_new0 (NMDispatcherCoalesceQueue);
+	c_list_init (&queue->lst_head);
+	queue->send_func = send_func;
+	queue->user_data = user_data;
+	return queue;
+}
+
+void
+nm_dispatcher_coalesce_queue_free (NMDispatcherCoalesceQueue *queue)
+{
+	if (!queue)
+		return;
+
+	/* the pending actions are still referenced by their requests. */
+	g_return_if_fail (c_list_is_empty (&queue->lst_head));
+
+	g_slice_free (NMDispatcherCoalesceQueue, queue);
+}
@@ -0,0 +1,64 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2026 Red Hat, Inc.
+ */
+
+#ifndef __NM_DISPATCHER_COALESCE_H__
+#define __NM_DISPATCHER_COALESCE_H__
+
+#include "nm-dispatcher.h"
+
+/* "dhcp4-change", "dhcp6-change" and "connectivity-change" only announce
+ * the current state. While such an action is in progress, further ones of
+ * the same kind for the same device are coalesced and sent once, with the
+ * state at that time, after the pending action completes.
+ *
+ * The queue does not send anything by itself, it calls @send_func. The
+ * device is only used as key and kept alive with a reference. */
+
+typedef struct _NMDispatcherCoalesce      NMDispatcherCoalesce;
+typedef struct _NMDispatcherCoalesceQueue NMDispatcherCoalesceQueue;
+
+/* @send_func returns whether sending succeeded. If the action is still in
+ * progress afterwards, it calls nm_dispatcher_coalesce_set_in_flight() on
+ * @coalesce, and nm_dispatcher_coalesce_complete() once it is done. */
+typedef gboolean (*NMDispatcherCoalesceSendFunc) (NMDispatcherCoalesce *coalesce,
+                                                  NMDispatcherAction action,
+                                                  gpointer device,
+                                                  NMConnectivityState connectivity_state,
+                                                  gpointer user_data);
+
+NMDispatcherCoalesceQueue *nm_dispatcher_coalesce_queue_new (NMDispatcherCoalesceSendFunc send_func,
+                                                             gpointer user_data);
+
+void nm_dispatcher_coalesce_queue_free (NMDispatcherCoalesceQueue *queue);
+
+gboolean nm_dispatcher_coalesce_queue_add (NMDispatcherCoalesceQueue *queue,
+                                           NMDispatcherAction action,
+                                           gpointer device,
+                                           NMConnectivityState connectivity_state,
+                                           gboolean *out_coalesced);
+
+guint nm_dispatcher_coalesce_queue_drop (NMDispatcherCoalesceQueue *queue,
+                                         gpointer device);
+
+void nm_dispatcher_coalesce_set_in_flight (NMDispatcherCoalesce *coalesce);
+
+void nm_dispatcher_coalesce_complete (NMDispatcherCoalesce *coalesce);
+
+#endif /* __NM_DISPATCHER_COALESCE_H__ */
@@ -27,6 +27,7 @@
 #include <errno.h>
 
 #include "nm-dispatcher-api.h"
+#include "nm-dispatcher-coalesce.h"
 #include "NetworkManagerUtils.h"
 #include "nm-utils.h"
 #include "nm-connectivity.h"
@@ -326,12 +327,15 @@ fill_vpn_props (NMProxyConfig *proxy_config,
 		dump_ip6_to_props (ip6_config, ip6_builder);
 }
 
+static NMDispatcherCoalesceQueue *coalesce_queue;
+
 typedef struct {
 	NMDispatcherAction action;
 	guint request_id;
 	NMDispatcherFunc callback;
 	gpointer user_data;
 	guint idle_id;
+	NMDispatcherCoalesce *coalesce;
 } DispatchInfo;
 
 static void
@@ -425,6 +429,7 @@ static void
 dispatcher_done_cb (GObject *proxy, GAsyncResult *result, gpointer user_data)
 {
 	DispatchInfo *info = user_data;
+	NMDispatcherCoalesce *coalesce;
 	GVariant *ret;
 	GVariantIter *results;
 	GError *error = NULL;
@@ -452,7 +457,12 @@ dispatcher_done_cb (GObject *proxy, GAsyncResult *result, gpointer user_data)
 	if (info->callback)
 		info->callback (info->request_id, info->user_data);
 
+	coalesce = g_steal_pointer (&info->coalesce);
+
 	dispatcher_info_cleanup (info);
+
+	if (coalesce)
+		nm_dispatcher_coalesce_complete (coalesce);
 }
 
 static const char *action_table[] = {
@@ -501,6 +511,7 @@ _dispatcher_call (NMDispatcherAction action,
                   NMProxyConfig *vpn_proxy_config,
                   NMIP4Config *vpn_ip4_config,
                   NMIP6Config *vpn_ip6_config,
+                  NMDispatcherCoalesce *coalesce,
                   NMDispatcherFunc callback,
                   gpointer user_data,
                   guint *out_call_id)
@@ -532,6 +543,24 @@ _dispatcher_call (NMDispatcherAction action,
 
 	g_assert (!blocking || (!callback && !user_data));
 
+	if (   !coalesce
+	    && device
+	    && coalesce_queue
+	    && !NM_IN_SET (action, NM_DISPATCHER_ACTION_VPN_PRE_UP,
+	                           NM_DISPATCHER_ACTION_VPN_UP,
+	                           NM_DISPATCHER_ACTION_VPN_PRE_DOWN,
+	                           NM_DISPATCHER_ACTION_VPN_DOWN)) {
+		guint n;
+
+		/* coalesced actions of the device must not be sent after this
+		 * one, with a state that is outdated by then. */
+		n = nm_dispatcher_coalesce_queue_drop (coalesce_queue, device);
+		if (n > 0) {
+			_LOGD ("(%s) drop %u coalesced action(s), superseded by '%s'",
+			       nm_device_get_iface (device), n, action_to_string (action));
+		}
+	}
+
 	_ensure_requests ();
 
 	/* All actions except 'hostname' and 'connectivity-change' require a device */
@@ -654,7 +683,7 @@ _dispatcher_call (NMDispatcherAction action,
 		                                               &vpn_proxy_props,
 		                                               &vpn_ip4_props,
 		                                               &vpn_ip6_props,
-		                                               nm_logging_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
+		                                               nm_logging_emit_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
 		                                G_VARIANT_TYPE ("(a(sus))"),
 		                                G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT,
 		                                NULL, &error);
@@ -676,6 +705,10 @@ _dispatcher_call (NMDispatcherAction action,
 		info->request_id = reqid;
 		info->callback = callback;
 		info->user_data = user_data;
+		if (coalesce) {
+			info->coalesce = coalesce;
+			nm_dispatcher_coalesce_set_in_flight (coalesce);
+		}
 		g_dbus_proxy_call (dispatcher_proxy, "Action",
 		                   g_variant_new ("(s@a{sa{sv}}a{sv}a{sv}a{sv}a{sv}a{sv}@a{sv}@a{sv}ssa{sv}a{sv}a{sv}b)",
 		                                  action_to_string (action),
@@ -692,7 +725,7 @@ _dispatcher_call (NMDispatcherAction action,
 		                                  &vpn_proxy_props,
 		                                  &vpn_ip4_props,
 		                                  &vpn_ip6_props,
-		                                  nm_logging_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
+		                                  nm_logging_emit_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
 		                   G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT,
 		                   NULL, dispatcher_done_cb, info);
 		success = TRUE;
@@ -733,9 +766,77 @@ nm_dispatcher_call_hostname (NMDispatcherFunc callback,
 	                         NULL, NULL, NULL, FALSE,
 	                         NM_CONNECTIVITY_UNKNOWN,
 	                         NULL, NULL, NULL, NULL,
+	                         NULL,
+	                         callback, user_data, out_call_id);
+}
+
+static gboolean
+_dispatcher_call_device (NMDispatcherAction action,
+                         NMDevice *device,
+                         NMActRequest *act_request,
+                         NMDispatcherCoalesce *coalesce,
+                         NMDispatcherFunc callback,
+                         gpointer user_data,
+                         guint *out_call_id)
+{
+	nm_assert (NM_IS_DEVICE (device));
+	if (!act_request) {
+		act_request = nm_device_get_act_request (device);
+		if (!act_request)
+			return FALSE;
+	}
+	nm_assert (NM_IN_SET (nm_active_connection_get_device (NM_ACTIVE_CONNECTION (act_request)), NULL, device));
+	return _dispatcher_call (action, FALSE,
+	                         device,
+	                         nm_act_request_get_settings_connection (act_request),
+	                         nm_act_request_get_applied_connection (act_request),
+	                         nm_active_connection_get_activation_type (NM_ACTIVE_CONNECTION (act_request)) == NM_ACTIVATION_TYPE_EXTERNAL,
+	                         NM_CONNECTIVITY_UNKNOWN,
+	                         NULL, NULL, NULL, NULL,
+	                         coalesce,
 	                         callback, user_data, out_call_id);
 }
 
+static gboolean
+_coalesce_send (NMDispatcherCoalesce *coalesce,
+                NMDispatcherAction action,
+                gpointer device,
+                NMConnectivityState connectivity_state,
+                gpointer user_data)
+{
+	if (device) {
+		return _dispatcher_call_device (action, device, NULL,
+		                                coalesce, NULL, NULL, NULL);
+	}
+	return _dispatcher_call (action, FALSE,
+	                         NULL, NULL, NULL, FALSE,
+	                         connectivity_state,
+	                         NULL, NULL, NULL, NULL,
+	                         coalesce,
+	                         NULL, NULL, NULL);
+}
+
+static gboolean
+_coalesce_call (NMDispatcherAction action,
+                NMDevice *device,
+                NMConnectivityState connectivity_state)
+{
+	gboolean coalesced;
+	gboolean success;
+
+	if (G_UNLIKELY (!coalesce_queue))
+		coalesce_queue = nm_dispatcher_coalesce_queue_new (_coalesce_send, NULL);
+
+	success = nm_dispatcher_coalesce_queue_add (coalesce_queue, action, device,
+	                                            connectivity_state, &coalesced);
+	if (coalesced) {
+		_LOGD ("(%s) coalesce action '%s' with the pending one",
+		       device ? nm_device_get_iface (device) : "",
+		       action_to_string (action));
+	}
+	return success;
+}
+
 /**
  * nm_dispatcher_call_device:
  * @action: the %NMDispatcherAction
@@ -748,7 +849,8 @@ nm_dispatcher_call_hostname (NMDispatcherFunc callback,
  * nm_dispatcher_call_cancel()
  *
  * This method always invokes the device dispatcher action asynchronously.  To ignore
- * the result, pass %NULL to @callback.
+ * the result, pass %NULL to @callback. In that case, "dhcp4-change" and
+ * "dhcp6-change" actions are coalesced with a pending one for @device.
  *
  * Returns: %TRUE if the action was dispatched, %FALSE on failure
  */
@@ -761,20 +863,16 @@ nm_dispatcher_call_device (NMDispatcherAction action,
                            guint *out_call_id)
 {
 	nm_assert (NM_IS_DEVICE (device));
-	if (!act_request) {
-		act_request = nm_device_get_act_request (device);
-		if (!act_request)
-			return FALSE;
-	}
-	nm_assert (NM_IN_SET (nm_active_connection_get_device (NM_ACTIVE_CONNECTION (act_request)), NULL, device));
-	return _dispatcher_call (action, FALSE,
-	                         device,
-	                         nm_act_request_get_settings_connection (act_request),
-	                         nm_act_request_get_applied_connection (act_request),
-	                         nm_active_connection_get_activation_type (NM_ACTIVE_CONNECTION (act_request)) == NM_ACTIVATION_TYPE_EXTERNAL,
-	                         NM_CONNECTIVITY_UNKNOWN,
-	                         NULL, NULL, NULL, NULL,
-	                         callback, user_data, out_call_id);
+
+	if (   NM_IN_SET (action, NM_DISPATCHER_ACTION_DHCP4_CHANGE,
+	                          NM_DISPATCHER_ACTION_DHCP6_CHANGE)
+	    && !act_request
+	    && !callback
+	    && !out_call_id)
+		return _coalesce_call (action, device, NM_CONNECTIVITY_UNKNOWN);
+
+	return _dispatcher_call_device (action, device, act_request, NULL,
+	                                callback, user_data, out_call_id);
 }
 
 /**
@@ -808,6 +906,7 @@ nm_dispatcher_call_device_sync (NMDispatcherAction action,
 	                         nm_active_connection_get_activation_type (NM_ACTIVE_CONNECTION (act_request)) == NM_ACTIVATION_TYPE_EXTERNAL,
 	                         NM_CONNECTIVITY_UNKNOWN,
 	                         NULL, NULL, NULL, NULL,
+	                         NULL,
 	                         NULL, NULL, NULL);
 }
 
@@ -851,6 +950,7 @@ nm_dispatcher_call_vpn (NMDispatcherAction action,
 	                         FALSE,
 	                         NM_CONNECTIVITY_UNKNOWN,
 	                         vpn_iface, vpn_proxy_config, vpn_ip4_config, vpn_ip6_config,
+	                         NULL,
 	                         callback, user_data, out_call_id);
 }
 
@@ -887,6 +987,7 @@ nm_dispatcher_call_vpn_sync (NMDispatcherAction action,
 	                         FALSE,
 	                         NM_CONNECTIVITY_UNKNOWN,
 	                         vpn_iface, vpn_proxy_config, vpn_ip4_config, vpn_ip6_config,
+	                         NULL,
 	                         NULL, NULL, NULL);
 }
 
@@ -898,7 +999,8 @@ nm_dispatcher_call_vpn_sync (NMDispatcherAction action,
  * @out_call_id: on success, a call identifier which can be passed to
  * nm_dispatcher_call_cancel()
  *
- * This method does not block the caller.
+ * This method does not block the caller. Without @callback and @out_call_id,
+ * the action is coalesced with a pending one.
  *
  * Returns: %TRUE if the action was dispatched, %FALSE on failure
  */
@@ -908,10 +1010,15 @@ nm_dispatcher_call_connectivity (NMConnectivityState connectivity_state,
                                  gpointer user_data,
                                  guint *out_call_id)
 {
+	if (   !callback
+	    && !out_call_id)
+		return _coalesce_call (NM_DISPATCHER_ACTION_CONNECTIVITY_CHANGE, NULL, connectivity_state);
+
 	return _dispatcher_call (NM_DISPATCHER_ACTION_CONNECTIVITY_CHANGE, FALSE,
 	                         NULL, NULL, NULL, FALSE,
 	                         connectivity_state,
 	                         NULL, NULL, NULL, NULL,
+	                         NULL,
 	                         callback, user_data, out_call_id);
 }
 
@@ -955,7 +1062,11 @@ dispatcher_dir_changed (GFileMonitor *monitor,
 		while (!item->has_scripts
 		    && (name = g_dir_read_name (dir))) {
 			full_name = g_build_filename (item->dir, name, NULL);
-			item->has_scripts = g_file_test (full_name, G_FILE_TEST_IS_EXECUTABLE);
+			/* the default directory contains the pre-up.d, pre-down.d and no-wait.d
+			 * directories. Only count executable files, like the dispatcher does. */
+			item->has_scripts =    name[0] != '.'
+			                    && g_file_test (full_name, G_FILE_TEST_IS_REGULAR)
+			                    && g_file_test (full_name, G_FILE_TEST_IS_EXECUTABLE);
 			g_free (full_name);
 		}
 		errsv = errno;
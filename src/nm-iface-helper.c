@@ -468,7 +468,8 @@ main (int argc, char *argv[])
 	setup_signals ();
 
 	nm_logging_syslog_openlog (global_opt.logging_backend,
-	                           global_opt.debug);
+	                           global_opt.debug,
+	                           FALSE);
 
 	_LOGI (LOGD_CORE, "nm-iface-helper (version " NM_DIST_VERSION ") is starting...");
 
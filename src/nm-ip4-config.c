@@ -829,6 +829,185 @@ nm_ip4_config_commit (const NMIP4Config *self,
 	return success;
 }
 
+/**
+ * nm_ip4_config_commit_addresses:
+ * @self: the #NMIP4Config to commit
+ * @platform: the #NMPlatform
+ *
+ * Like nm_ip4_config_commit(), but only syncs the addresses and leaves
+ * the routes alone. This is useful to refresh the lifetimes of addresses,
+ * when the routes are known to be already in sync.
+ */
+void
+nm_ip4_config_commit_addresses (const NMIP4Config *self,
+                                NMPlatform *platform)
+{
+	gs_unref_ptrarray GPtrArray *addresses = NULL;
+	int ifindex;
+
+	g_return_if_fail (NM_IS_IP4_CONFIG (self));
+
+	ifindex = nm_ip4_config_get_ifindex (self);
+	g_return_if_fail (ifindex > 0);
+
+	addresses = nm_dedup_multi_objs_to_ptr_array_head (nm_ip4_config_lookup_addresses (self),
+	                                                   NULL, NULL);
+
+	nm_platform_ip4_address_sync (platform, ifindex, addresses);
+}
+
+static int
+_address_cmp_ignore_lifetime (const NMPlatformIP4Address *a, const NMPlatformIP4Address *b)
+{
+	NMPlatformIP4Address a2 = *a;
+	NMPlatformIP4Address b2 = *b;
+
+	a2.timestamp = 0;
+	a2.lifetime = 0;
+	a2.preferred = 0;
+	b2.timestamp = 0;
+	b2.lifetime = 0;
+	b2.preferred = 0;
+	return nm_platform_ip4_address_cmp (&a2, &b2);
+}
+
+/**
+ * nm_ip4_config_equal_for_commit:
+ * @a: the config that was committed before
+ * @b: the config to commit
+ * @out_lifetimes_differ: (allow-none): set to %TRUE if the lifetimes
+ *   of some addresses differ.
+ *
+ * Compares the addresses and routes of @a and @b, that is everything
+ * that nm_ip4_config_commit() syncs to platform.
+ *
+ * Returns: %TRUE if the addresses and routes are identical, except
+ *   for the lifetimes of the addresses.
+ */
+gboolean
+nm_ip4_config_equal_for_commit (const NMIP4Config *a,
+                                const NMIP4Config *b,
+                                gboolean *out_lifetimes_differ)
+{
+	NMDedupMultiIter iter_a, iter_b;
+	gboolean lifetimes_differ = FALSE;
+
+	NM_SET_OUT (out_lifetimes_differ, FALSE);
+
+	g_return_val_if_fail (NM_IS_IP4_CONFIG (a), FALSE);
+	g_return_val_if_fail (NM_IS_IP4_CONFIG (b), FALSE);
+
+	if (   nm_ip4_config_get_ifindex (a) != nm_ip4_config_get_ifindex (b)
+	    || nm_ip4_config_get_num_addresses (a) != nm_ip4_config_get_num_addresses (b)
+	    || nm_ip4_config_get_num_routes (a) != nm_ip4_config_get_num_routes (b))
+		return FALSE;
+
+	{
+		const NMPlatformIP4Address *addr_a, *addr_b;
+
+		nm_ip_config_iter_ip4_address_init (&iter_a, a);
+		nm_ip_config_iter_ip4_address_init (&iter_b, b);
+		while (nm_ip_config_iter_ip4_address_next (&iter_a, &addr_a)) {
+			if (!nm_ip_config_iter_ip4_address_next (&iter_b, &addr_b))
+				return FALSE;
+			if (nm_platform_ip4_address_cmp (addr_a, addr_b) == 0)
+				continue;
+			if (_address_cmp_ignore_lifetime (addr_a, addr_b) != 0)
+				return FALSE;
+			lifetimes_differ = TRUE;
+		}
+	}
+
+	{
+		const NMPlatformIP4Route *route_a, *route_b;
+
+		nm_ip_config_iter_ip4_route_init (&iter_a, a);
+		nm_ip_config_iter_ip4_route_init (&iter_b, b);
+		while (nm_ip_config_iter_ip4_route_next (&iter_a, &route_a)) {
+			if (!nm_ip_config_iter_ip4_route_next (&iter_b, &route_b))
+				return FALSE;
+			if (nm_platform_ip4_route_cmp_full (route_a, route_b) != 0)
+				return FALSE;
+		}
+	}
+
+	NM_SET_OUT (out_lifetimes_differ, lifetimes_differ);
+	return TRUE;
+}
+
+/**
+ * nm_ip4_config_platform_is_synced:
+ * @self: the #NMIP4Config
+ * @platform: the #NMPlatform
+ * @route_table_sync: the mode that nm_ip4_config_commit() would use
+ *
+ * Checks the platform cache, whether nm_ip4_config_commit() would
+ * change any addresses or routes. That is the case, if something was
+ * removed or added behind our back.
+ *
+ * Returns: %TRUE if the addresses and routes of @self are configured
+ *   on platform, and there are no other addresses or routes that
+ *   a commit would remove.
+ */
+gboolean
+nm_ip4_config_platform_is_synced (const NMIP4Config *self,
+                                  NMPlatform *platform,
+                                  NMIPRouteTableSyncMode route_table_sync)
+{
+	gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+	const NMDedupMultiHeadEntry *head_entry;
+	NMDedupMultiIter iter;
+	const NMPlatformIP4Address *address;
+	const NMPlatformIP4Route *route;
+	const NMPObject *plat_obj;
+	int ifindex;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_IP4_CONFIG (self), FALSE);
+
+	ifindex = nm_ip4_config_get_ifindex (self);
+	g_return_val_if_fail (ifindex > 0, FALSE);
+
+	nm_ip_config_iter_ip4_address_for_each (&iter, self, &address) {
+		if (!nm_platform_lookup_obj (platform,
+		                             NMP_CACHE_ID_TYPE_OBJECT_TYPE,
+		                             NMP_OBJECT_UP_CAST (address)))
+			return FALSE;
+	}
+
+	head_entry = nm_platform_lookup_object (platform, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex);
+	if (head_entry) {
+		nmp_cache_iter_for_each (&iter, head_entry, &plat_obj) {
+			if (!nm_ip4_config_nmpobj_lookup (self, plat_obj))
+				return FALSE;
+		}
+	}
+
+	nm_ip_config_iter_ip4_route_for_each (&iter, self, &route) {
+		plat_obj = nm_platform_lookup_obj (platform,
+		                                   NMP_CACHE_ID_TYPE_OBJECT_TYPE,
+		                                   NMP_OBJECT_UP_CAST (route));
+		if (   !plat_obj
+		    || nm_platform_ip4_route_cmp (route,
+		                                  NMP_OBJECT_CAST_IP4_ROUTE (plat_obj),
+		                                  NM_PLATFORM_IP_ROUTE_CMP_TYPE_SEMANTICALLY) != 0)
+			return FALSE;
+	}
+
+	routes_prune = nm_platform_ip_route_get_prune_list (platform,
+	                                                    AF_INET,
+	                                                    ifindex,
+	                                                    route_table_sync);
+	if (routes_prune) {
+		for (i = 0; i < routes_prune->len; i++) {
+			if (!nm_ip4_config_nmpobj_lookup (self, routes_prune->pdata[i]))
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
 void
 _nm_ip_config_merge_route_attributes (int addr_family,
                                       NMIPRoute *s_route,
@@ -2870,14 +3049,8 @@ nm_ip4_config_nmpobj_remove (NMIP4Config *self,
 
 /*****************************************************************************/
 
-static inline void
-hash_u32 (GChecksum *sum, guint32 n)
-{
-	g_checksum_update (sum, (const guint8 *) &n, sizeof (n));
-}
-
 void
-nm_ip4_config_hash (const NMIP4Config *self, GChecksum *sum, gboolean dns_only)
+nm_ip4_config_hash (const NMIP4Config *self, NMHashState *h, gboolean dns_only)
 {
 	guint i;
 	const char *s;
@@ -2887,58 +3060,54 @@ nm_ip4_config_hash (const NMIP4Config *self, GChecksum *sum, gboolean dns_only)
 	int val;
 
 	g_return_if_fail (self);
-	g_return_if_fail (sum);
+	g_return_if_fail (h);
 
 	if (!dns_only) {
 		nm_ip_config_iter_ip4_address_for_each (&ipconf_iter, self, &address) {
-			hash_u32 (sum, address->address);
-			hash_u32 (sum, address->plen);
-			hash_u32 (sum, address->peer_address & _nm_utils_ip4_prefix_to_netmask (address->plen));
+			nm_hash_update_vals (h,
+			                     address->address,
+			                     address->plen,
+			                     address->peer_address & _nm_utils_ip4_prefix_to_netmask (address->plen));
 		}
 
 		nm_ip_config_iter_ip4_route_for_each (&ipconf_iter, self, &route) {
-			hash_u32 (sum, route->network);
-			hash_u32 (sum, route->plen);
-			hash_u32 (sum, route->gateway);
-			hash_u32 (sum, route->metric);
+			nm_hash_update_vals (h,
+			                     route->network,
+			                     route->plen,
+			                     route->gateway,
+			                     route->metric);
 		}
 
 		for (i = 0; i < nm_ip4_config_get_num_nis_servers (self); i++)
-			hash_u32 (sum, nm_ip4_config_get_nis_server (self, i));
+			nm_hash_update_val (h, nm_ip4_config_get_nis_server (self, i));
 
 		s = nm_ip4_config_get_nis_domain (self);
 		if (s)
-			g_checksum_update (sum, (const guint8 *) s, strlen (s));
+			nm_hash_update_str (h, s);
 	}
 
 	for (i = 0; i < nm_ip4_config_get_num_nameservers (self); i++)
-		hash_u32 (sum, nm_ip4_config_get_nameserver (self, i));
+		nm_hash_update_val (h, nm_ip4_config_get_nameserver (self, i));
 
 	for (i = 0; i < nm_ip4_config_get_num_wins (self); i++)
-		hash_u32 (sum, nm_ip4_config_get_wins (self, i));
+		nm_hash_update_val (h, nm_ip4_config_get_wins (self, i));
 
-	for (i = 0; i < nm_ip4_config_get_num_domains (self); i++) {
-		s = nm_ip4_config_get_domain (self, i);
-		g_checksum_update (sum, (const guint8 *) s, strlen (s));
-	}
+	for (i = 0; i < nm_ip4_config_get_num_domains (self); i++)
+		nm_hash_update_str (h, nm_ip4_config_get_domain (self, i));
 
-	for (i = 0; i < nm_ip4_config_get_num_searches (self); i++) {
-		s = nm_ip4_config_get_search (self, i);
-		g_checksum_update (sum, (const guint8 *) s, strlen (s));
-	}
+	for (i = 0; i < nm_ip4_config_get_num_searches (self); i++)
+		nm_hash_update_str (h, nm_ip4_config_get_search (self, i));
 
-	for (i = 0; i < nm_ip4_config_get_num_dns_options (self); i++) {
-		s = nm_ip4_config_get_dns_option (self, i);
-		g_checksum_update (sum, (const guint8 *) s, strlen (s));
-	}
+	for (i = 0; i < nm_ip4_config_get_num_dns_options (self); i++)
+		nm_hash_update_str (h, nm_ip4_config_get_dns_option (self, i));
 
 	val = nm_ip4_config_mdns_get (self);
 	if (val != NM_SETTING_CONNECTION_MDNS_DEFAULT)
-		g_checksum_update (sum, (const guint8 *) &val, sizeof (val));
+		nm_hash_update_val (h, val);
 
 	val = nm_ip4_config_llmnr_get (self);
 	if (val != NM_SETTING_CONNECTION_LLMNR_DEFAULT)
-		g_checksum_update (sum, (const guint8 *) &val, sizeof (val));
+		nm_hash_update_val (h, val);
 
 	/* FIXME(ip-config-checksum): the DNS priority should be considered relevant
 	 * and added into the checksum as well, but this can't be done right now
@@ -2952,6 +3121,22 @@ nm_ip4_config_hash (const NMIP4Config *self, GChecksum *sum, gboolean dns_only)
 	 */
 }
 
+static gboolean
+_equal_is_empty (const NMIP4Config *self)
+{
+	return    !nm_ip4_config_get_num_addresses (self)
+	       && !nm_ip4_config_get_num_routes (self)
+	       && !nm_ip4_config_get_num_nis_servers (self)
+	       && !nm_ip4_config_get_nis_domain (self)
+	       && !nm_ip4_config_get_num_nameservers (self)
+	       && !nm_ip4_config_get_num_wins (self)
+	       && !nm_ip4_config_get_num_domains (self)
+	       && !nm_ip4_config_get_num_searches (self)
+	       && !nm_ip4_config_get_num_dns_options (self)
+	       && nm_ip4_config_mdns_get (self) == NM_SETTING_CONNECTION_MDNS_DEFAULT
+	       && nm_ip4_config_llmnr_get (self) == NM_SETTING_CONNECTION_LLMNR_DEFAULT;
+}
+
 /**
  * nm_ip4_config_equal:
  * @a: first config to compare
@@ -2960,7 +3145,8 @@ nm_ip4_config_hash (const NMIP4Config *self, GChecksum *sum, gboolean dns_only)
  * Compares two #NMIP4Configs for basic equality.  This means that all
  * attributes must exist in the same order in both configs (addresses, routes,
  * domains, DNS servers, etc) but some attributes (address lifetimes, and address
- * and route sources) are ignored.
+ * and route sources) are ignored. These are the attributes that are
+ * considered by nm_ip4_config_hash().
  *
  * Returns: %TRUE if the configurations are basically equal to each other,
  * %FALSE if not
@@ -2968,29 +3154,105 @@ nm_ip4_config_hash (const NMIP4Config *self, GChecksum *sum, gboolean dns_only)
 gboolean
 nm_ip4_config_equal (const NMIP4Config *a, const NMIP4Config *b)
 {
-	GChecksum *a_checksum = g_checksum_new (G_CHECKSUM_SHA1);
-	GChecksum *b_checksum = g_checksum_new (G_CHECKSUM_SHA1);
-	guchar a_data[20], b_data[20];
-	gsize a_len = sizeof (a_data);
-	gsize b_len = sizeof (b_data);
-	gboolean equal;
+	NMDedupMultiIter iter_a, iter_b;
+	guint i, n;
+
+	if (a == b)
+		return TRUE;
+	if (!a || !b)
+		return _equal_is_empty (a ?: b);
+
+	/* compare field by field, so that the first difference
+	 * returns right away. */
+
+	if (   nm_ip4_config_get_num_addresses (a) != nm_ip4_config_get_num_addresses (b)
+	    || nm_ip4_config_get_num_routes (a) != nm_ip4_config_get_num_routes (b))
+		return FALSE;
+
+	n = nm_ip4_config_get_num_nameservers (a);
+	if (n != nm_ip4_config_get_num_nameservers (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (nm_ip4_config_get_nameserver (a, i) != nm_ip4_config_get_nameserver (b, i))
+			return FALSE;
+	}
+
+	{
+		const NMPlatformIP4Address *addr_a, *addr_b;
+
+		nm_ip_config_iter_ip4_address_init (&iter_a, a);
+		nm_ip_config_iter_ip4_address_init (&iter_b, b);
+		while (nm_ip_config_iter_ip4_address_next (&iter_a, &addr_a)) {
+			if (!nm_ip_config_iter_ip4_address_next (&iter_b, &addr_b))
+				return FALSE;
+			if (   addr_a->address != addr_b->address
+			    || addr_a->plen != addr_b->plen
+			    || ((addr_a->peer_address ^ addr_b->peer_address) & _nm_utils_ip4_prefix_to_netmask (addr_a->plen)))
+				return FALSE;
+		}
+	}
+
+	{
+		const NMPlatformIP4Route *route_a, *route_b;
+
+		nm_ip_config_iter_ip4_route_init (&iter_a, a);
+		nm_ip_config_iter_ip4_route_init (&iter_b, b);
+		while (nm_ip_config_iter_ip4_route_next (&iter_a, &route_a)) {
+			if (!nm_ip_config_iter_ip4_route_next (&iter_b, &route_b))
+				return FALSE;
+			if (   route_a->network != route_b->network
+			    || route_a->plen != route_b->plen
+			    || route_a->gateway != route_b->gateway
+			    || route_a->metric != route_b->metric)
+				return FALSE;
+		}
+	}
 
-	if (a)
-		nm_ip4_config_hash (a, a_checksum, FALSE);
-	if (b)
-		nm_ip4_config_hash (b, b_checksum, FALSE);
+	n = nm_ip4_config_get_num_nis_servers (a);
+	if (n != nm_ip4_config_get_num_nis_servers (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (nm_ip4_config_get_nis_server (a, i) != nm_ip4_config_get_nis_server (b, i))
+			return FALSE;
+	}
 
-	g_checksum_get_digest (a_checksum, a_data, &a_len);
-	g_checksum_get_digest (b_checksum, b_data, &b_len);
+	if (!nm_streq0 (nm_ip4_config_get_nis_domain (a), nm_ip4_config_get_nis_domain (b)))
+		return FALSE;
 
-	nm_assert (a_len == sizeof (a_data));
-	nm_assert (b_len == sizeof (b_data));
-	equal = !memcmp (a_data, b_data, a_len);
+	n = nm_ip4_config_get_num_wins (a);
+	if (n != nm_ip4_config_get_num_wins (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (nm_ip4_config_get_wins (a, i) != nm_ip4_config_get_wins (b, i))
+			return FALSE;
+	}
 
-	g_checksum_free (a_checksum);
-	g_checksum_free (b_checksum);
+	n = nm_ip4_config_get_num_domains (a);
+	if (n != nm_ip4_config_get_num_domains (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (!nm_streq (nm_ip4_config_get_domain (a, i), nm_ip4_config_get_domain (b, i)))
+			return FALSE;
+	}
+
+	n = nm_ip4_config_get_num_searches (a);
+	if (n != nm_ip4_config_get_num_searches (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (!nm_streq (nm_ip4_config_get_search (a, i), nm_ip4_config_get_search (b, i)))
+			return FALSE;
+	}
+
+	n = nm_ip4_config_get_num_dns_options (a);
+	if (n != nm_ip4_config_get_num_dns_options (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (!nm_streq (nm_ip4_config_get_dns_option (a, i), nm_ip4_config_get_dns_option (b, i)))
+			return FALSE;
+	}
 
-	return equal;
+	return    nm_ip4_config_mdns_get (a) == nm_ip4_config_mdns_get (b)
+	       && nm_ip4_config_llmnr_get (a) == nm_ip4_config_llmnr_get (b);
 }
 
 /*****************************************************************************/
@@ -171,6 +171,14 @@ void nm_ip4_config_add_dependent_routes (NMIP4Config *self,
 gboolean nm_ip4_config_commit (const NMIP4Config *self,
                                NMPlatform *platform,
                                NMIPRouteTableSyncMode route_table_sync);
+void nm_ip4_config_commit_addresses (const NMIP4Config *self,
+                                NMPlatform *platform);
+gboolean nm_ip4_config_equal_for_commit (const NMIP4Config *a,
+                                const NMIP4Config *b,
+                                gboolean *out_lifetimes_differ);
+gboolean nm_ip4_config_platform_is_synced (const NMIP4Config *self,
+                                  NMPlatform *platform,
+                                  NMIPRouteTableSyncMode route_table_sync);
 
 void nm_ip4_config_merge_setting (NMIP4Config *self,
                                   NMSettingIPConfig *setting,
@@ -292,7 +300,7 @@ const NMPObject *nm_ip4_config_nmpobj_lookup (const NMIP4Config *self,
 gboolean nm_ip4_config_nmpobj_remove (NMIP4Config *self,
                                       const NMPObject *needle);
 
-void nm_ip4_config_hash (const NMIP4Config *self, GChecksum *sum, gboolean dns_only);
+void nm_ip4_config_hash (const NMIP4Config *self, NMHashState *h, gboolean dns_only);
 gboolean nm_ip4_config_equal (const NMIP4Config *a, const NMIP4Config *b);
 
 gboolean _nm_ip_config_check_and_add_domain (GPtrArray *array, const char *domain);
@@ -399,9 +407,9 @@ nm_ip_config_get_ifindex (const NMIPConfig *self)
 }
 
 static inline void
-nm_ip_config_hash (const NMIPConfig *self, GChecksum *sum, gboolean dns_only)
+nm_ip_config_hash (const NMIPConfig *self, NMHashState *h, gboolean dns_only)
 {
-	_NM_IP_CONFIG_DISPATCH_VOID (self, nm_ip4_config_hash, nm_ip6_config_hash, sum, dns_only);
+	_NM_IP_CONFIG_DISPATCH_VOID (self, nm_ip4_config_hash, nm_ip6_config_hash, h, dns_only);
 }
 
 static inline void
@@ -580,6 +588,40 @@ nm_ip_config_replace (NMIPConfig *dst,
 	                               relevant_changes);
 }
 
+static inline gboolean
+nm_ip_config_equal_for_commit (const NMIPConfig *a,
+                               const NMIPConfig *b,
+                               gboolean *out_lifetimes_differ)
+{
+	if (NM_IS_IP4_CONFIG (a)) {
+		nm_assert (NM_IS_IP4_CONFIG (b));
+		return nm_ip4_config_equal_for_commit ((const NMIP4Config *) a,
+		                                       (const NMIP4Config *) b,
+		                                       out_lifetimes_differ);
+	} else {
+		nm_assert (NM_IS_IP6_CONFIG (a));
+		nm_assert (NM_IS_IP6_CONFIG (b));
+		return nm_ip6_config_equal_for_commit ((const NMIP6Config *) a,
+		                                       (const NMIP6Config *) b,
+		                                       out_lifetimes_differ);
+	}
+}
+
+static inline gboolean
+nm_ip_config_platform_is_synced (const NMIPConfig *self,
+                                 NMPlatform *platform,
+                                 NMIPRouteTableSyncMode route_table_sync)
+{
+	_NM_IP_CONFIG_DISPATCH (self, nm_ip4_config_platform_is_synced, nm_ip6_config_platform_is_synced, platform, route_table_sync);
+}
+
+static inline void
+nm_ip_config_commit_addresses (const NMIPConfig *self,
+                               NMPlatform *platform)
+{
+	_NM_IP_CONFIG_DISPATCH_VOID (self, nm_ip4_config_commit_addresses, nm_ip6_config_commit_addresses, platform);
+}
+
 static inline NMIPConfig *
 nm_ip_config_intersect_alloc (const NMIPConfig *a,
                               const NMIPConfig *b,
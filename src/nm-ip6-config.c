@@ -590,6 +590,193 @@ nm_ip6_config_commit (const NMIP6Config *self,
 	return success;
 }
 
+/**
+ * nm_ip6_config_commit_addresses:
+ * @self: the #NMIP6Config to commit
+ * @platform: the #NMPlatform
+ *
+ * Like nm_ip6_config_commit(), but only syncs the addresses and leaves
+ * the routes alone.
+ */
+void
+nm_ip6_config_commit_addresses (const NMIP6Config *self,
+                                NMPlatform *platform)
+{
+	gs_unref_ptrarray GPtrArray *addresses = NULL;
+	int ifindex;
+
+	g_return_if_fail (NM_IS_IP6_CONFIG (self));
+
+	ifindex = nm_ip6_config_get_ifindex (self);
+	g_return_if_fail (ifindex > 0);
+
+	addresses = nm_dedup_multi_objs_to_ptr_array_head (nm_ip6_config_lookup_addresses (self),
+	                                                   NULL, NULL);
+
+	nm_platform_ip6_address_sync (platform, ifindex, addresses, FALSE);
+}
+
+static int
+_address_cmp_ignore_lifetime (const NMPlatformIP6Address *a, const NMPlatformIP6Address *b)
+{
+	NMPlatformIP6Address a2 = *a;
+	NMPlatformIP6Address b2 = *b;
+
+	a2.timestamp = 0;
+	a2.lifetime = 0;
+	a2.preferred = 0;
+	b2.timestamp = 0;
+	b2.lifetime = 0;
+	b2.preferred = 0;
+	return nm_platform_ip6_address_cmp (&a2, &b2);
+}
+
+/**
+ * nm_ip6_config_equal_for_commit:
+ * @a: the config that was committed before
+ * @b: the config to commit
+ * @out_lifetimes_differ: (allow-none): set to %TRUE if the lifetimes
+ *   of some addresses differ.
+ *
+ * Compares the addresses and routes of @a and @b, that is everything
+ * that nm_ip6_config_commit() syncs to platform.
+ *
+ * Returns: %TRUE if the addresses and routes are identical, except
+ *   for the lifetimes of the addresses.
+ */
+gboolean
+nm_ip6_config_equal_for_commit (const NMIP6Config *a,
+                                const NMIP6Config *b,
+                                gboolean *out_lifetimes_differ)
+{
+	NMDedupMultiIter iter_a, iter_b;
+	gboolean lifetimes_differ = FALSE;
+
+	NM_SET_OUT (out_lifetimes_differ, FALSE);
+
+	g_return_val_if_fail (NM_IS_IP6_CONFIG (a), FALSE);
+	g_return_val_if_fail (NM_IS_IP6_CONFIG (b), FALSE);
+
+	if (   nm_ip6_config_get_ifindex (a) != nm_ip6_config_get_ifindex (b)
+	    || nm_ip6_config_get_num_addresses (a) != nm_ip6_config_get_num_addresses (b)
+	    || nm_ip6_config_get_num_routes (a) != nm_ip6_config_get_num_routes (b))
+		return FALSE;
+
+	{
+		const NMPlatformIP6Address *addr_a, *addr_b;
+
+		nm_ip_config_iter_ip6_address_init (&iter_a, a);
+		nm_ip_config_iter_ip6_address_init (&iter_b, b);
+		while (nm_ip_config_iter_ip6_address_next (&iter_a, &addr_a)) {
+			if (!nm_ip_config_iter_ip6_address_next (&iter_b, &addr_b))
+				return FALSE;
+			if (nm_platform_ip6_address_cmp (addr_a, addr_b) == 0)
+				continue;
+			if (_address_cmp_ignore_lifetime (addr_a, addr_b) != 0)
+				return FALSE;
+			lifetimes_differ = TRUE;
+		}
+	}
+
+	{
+		const NMPlatformIP6Route *route_a, *route_b;
+
+		nm_ip_config_iter_ip6_route_init (&iter_a, a);
+		nm_ip_config_iter_ip6_route_init (&iter_b, b);
+		while (nm_ip_config_iter_ip6_route_next (&iter_a, &route_a)) {
+			if (!nm_ip_config_iter_ip6_route_next (&iter_b, &route_b))
+				return FALSE;
+			if (nm_platform_ip6_route_cmp_full (route_a, route_b) != 0)
+				return FALSE;
+		}
+	}
+
+	NM_SET_OUT (out_lifetimes_differ, lifetimes_differ);
+	return TRUE;
+}
+
+/**
+ * nm_ip6_config_platform_is_synced:
+ * @self: the #NMIP6Config
+ * @platform: the #NMPlatform
+ * @route_table_sync: the mode that nm_ip6_config_commit() would use
+ *
+ * Checks the platform cache, whether nm_ip6_config_commit() would
+ * change any addresses or routes.
+ *
+ * Returns: %TRUE if the addresses and routes of @self are configured
+ *   on platform, and there are no other addresses or routes that
+ *   a commit would remove.
+ */
+gboolean
+nm_ip6_config_platform_is_synced (const NMIP6Config *self,
+                                  NMPlatform *platform,
+                                  NMIPRouteTableSyncMode route_table_sync)
+{
+	gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+	const NMDedupMultiHeadEntry *head_entry;
+	NMDedupMultiIter iter;
+	const NMPlatformIP6Address *address;
+	const NMPlatformIP6Route *route;
+	const NMPObject *plat_obj;
+	const NMPObject *obj;
+	int ifindex;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_IP6_CONFIG (self), FALSE);
+
+	ifindex = nm_ip6_config_get_ifindex (self);
+	g_return_val_if_fail (ifindex > 0, FALSE);
+
+	/* the plen is not part of the ID of IPv6 addresses, but a different
+	 * plen requires re-adding the address. */
+	nm_ip_config_iter_ip6_address_for_each (&iter, self, &address) {
+		plat_obj = nm_platform_lookup_obj (platform,
+		                                   NMP_CACHE_ID_TYPE_OBJECT_TYPE,
+		                                   NMP_OBJECT_UP_CAST (address));
+		if (   !plat_obj
+		    || NMP_OBJECT_CAST_IP6_ADDRESS (plat_obj)->plen != address->plen)
+			return FALSE;
+	}
+
+	/* temporary addresses are not touched by nm_platform_ip6_address_sync(). */
+	head_entry = nm_platform_lookup_object (platform, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex);
+	if (head_entry) {
+		nmp_cache_iter_for_each (&iter, head_entry, &plat_obj) {
+			if (NM_FLAGS_HAS (NMP_OBJECT_CAST_IP6_ADDRESS (plat_obj)->n_ifa_flags, IFA_F_TEMPORARY))
+				continue;
+			obj = nm_ip6_config_nmpobj_lookup (self, plat_obj);
+			if (   !obj
+			    || NMP_OBJECT_CAST_IP6_ADDRESS (obj)->plen != NMP_OBJECT_CAST_IP6_ADDRESS (plat_obj)->plen)
+				return FALSE;
+		}
+	}
+
+	nm_ip_config_iter_ip6_route_for_each (&iter, self, &route) {
+		plat_obj = nm_platform_lookup_obj (platform,
+		                                   NMP_CACHE_ID_TYPE_OBJECT_TYPE,
+		                                   NMP_OBJECT_UP_CAST (route));
+		if (   !plat_obj
+		    || nm_platform_ip6_route_cmp (route,
+		                                  NMP_OBJECT_CAST_IP6_ROUTE (plat_obj),
+		                                  NM_PLATFORM_IP_ROUTE_CMP_TYPE_SEMANTICALLY) != 0)
+			return FALSE;
+	}
+
+	routes_prune = nm_platform_ip_route_get_prune_list (platform,
+	                                                    AF_INET6,
+	                                                    ifindex,
+	                                                    route_table_sync);
+	if (routes_prune) {
+		for (i = 0; i < routes_prune->len; i++) {
+			if (!nm_ip6_config_nmpobj_lookup (self, routes_prune->pdata[i]))
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
 void
 nm_ip6_config_merge_setting (NMIP6Config *self,
                              NMSettingIPConfig *setting,
@@ -2389,63 +2576,59 @@ nm_ip6_config_nmpobj_remove (NMIP6Config *self,
 /*****************************************************************************/
 
 static inline void
-hash_u32 (GChecksum *sum, guint32 n)
+_hash_in6addr (NMHashState *h, const struct in6_addr *a)
 {
-	g_checksum_update (sum, (const guint8 *) &n, sizeof (n));
-}
-
-static inline void
-hash_in6addr (GChecksum *sum, const struct in6_addr *a)
-{
-	if (a)
-		g_checksum_update (sum, (const guint8 *) a, sizeof (*a));
-	else
-		g_checksum_update (sum, (const guint8 *) &in6addr_any, sizeof (in6addr_any));
+	nm_hash_update (h, a ?: &in6addr_any, sizeof (struct in6_addr));
 }
 
 void
-nm_ip6_config_hash (const NMIP6Config *self, GChecksum *sum, gboolean dns_only)
+nm_ip6_config_hash (const NMIP6Config *self, NMHashState *h, gboolean dns_only)
 {
 	guint32 i;
-	const char *s;
 	NMDedupMultiIter ipconf_iter;
 	const NMPlatformIP6Address *address;
 	const NMPlatformIP6Route *route;
 
 	g_return_if_fail (self);
-	g_return_if_fail (sum);
+	g_return_if_fail (h);
 
 	if (dns_only == FALSE) {
 		nm_ip_config_iter_ip6_address_for_each (&ipconf_iter, self, &address) {
-			hash_in6addr (sum, &address->address);
-			hash_u32 (sum, address->plen);
+			_hash_in6addr (h, &address->address);
+			nm_hash_update_val (h, address->plen);
 		}
 
 		nm_ip_config_iter_ip6_route_for_each (&ipconf_iter, self, &route) {
-			hash_in6addr (sum, &route->network);
-			hash_u32 (sum, route->plen);
-			hash_in6addr (sum, &route->gateway);
-			hash_u32 (sum, route->metric);
+			_hash_in6addr (h, &route->network);
+			_hash_in6addr (h, &route->gateway);
+			nm_hash_update_vals (h,
+			                     route->plen,
+			                     route->metric);
 		}
 	}
 
 	for (i = 0; i < nm_ip6_config_get_num_nameservers (self); i++)
-		hash_in6addr (sum, nm_ip6_config_get_nameserver (self, i));
+		_hash_in6addr (h, nm_ip6_config_get_nameserver (self, i));
 
-	for (i = 0; i < nm_ip6_config_get_num_domains (self); i++) {
-		s = nm_ip6_config_get_domain (self, i);
-		g_checksum_update (sum, (const guint8 *) s, strlen (s));
-	}
+	for (i = 0; i < nm_ip6_config_get_num_domains (self); i++)
+		nm_hash_update_str (h, nm_ip6_config_get_domain (self, i));
 
-	for (i = 0; i < nm_ip6_config_get_num_searches (self); i++) {
-		s = nm_ip6_config_get_search (self, i);
-		g_checksum_update (sum, (const guint8 *) s, strlen (s));
-	}
+	for (i = 0; i < nm_ip6_config_get_num_searches (self); i++)
+		nm_hash_update_str (h, nm_ip6_config_get_search (self, i));
 
-	for (i = 0; i < nm_ip6_config_get_num_dns_options (self); i++) {
-		s = nm_ip6_config_get_dns_option (self, i);
-		g_checksum_update (sum, (const guint8 *) s, strlen (s));
-	}
+	for (i = 0; i < nm_ip6_config_get_num_dns_options (self); i++)
+		nm_hash_update_str (h, nm_ip6_config_get_dns_option (self, i));
+}
+
+static gboolean
+_equal_is_empty (const NMIP6Config *self)
+{
+	return    !nm_ip6_config_get_num_addresses (self)
+	       && !nm_ip6_config_get_num_routes (self)
+	       && !nm_ip6_config_get_num_nameservers (self)
+	       && !nm_ip6_config_get_num_domains (self)
+	       && !nm_ip6_config_get_num_searches (self)
+	       && !nm_ip6_config_get_num_dns_options (self);
 }
 
 /**
@@ -2456,7 +2639,8 @@ nm_ip6_config_hash (const NMIP6Config *self, GChecksum *sum, gboolean dns_only)
  * Compares two #NMIP6Configs for basic equality.  This means that all
  * attributes must exist in the same order in both configs (addresses, routes,
  * domains, DNS servers, etc) but some attributes (address lifetimes, and address
- * and route sources) are ignored.
+ * and route sources) are ignored. These are the attributes that are
+ * considered by nm_ip6_config_hash().
  *
  * Returns: %TRUE if the configurations are basically equal to each other,
  * %FALSE if not
@@ -2464,29 +2648,84 @@ nm_ip6_config_hash (const NMIP6Config *self, GChecksum *sum, gboolean dns_only)
 gboolean
 nm_ip6_config_equal (const NMIP6Config *a, const NMIP6Config *b)
 {
-	GChecksum *a_checksum = g_checksum_new (G_CHECKSUM_SHA1);
-	GChecksum *b_checksum = g_checksum_new (G_CHECKSUM_SHA1);
-	guchar a_data[20], b_data[20];
-	gsize a_len = sizeof (a_data);
-	gsize b_len = sizeof (b_data);
-	gboolean equal;
+	NMDedupMultiIter iter_a, iter_b;
+	guint i, n;
 
-	if (a)
-		nm_ip6_config_hash (a, a_checksum, FALSE);
-	if (b)
-		nm_ip6_config_hash (b, b_checksum, FALSE);
+	if (a == b)
+		return TRUE;
+	if (!a || !b)
+		return _equal_is_empty (a ?: b);
 
-	g_checksum_get_digest (a_checksum, a_data, &a_len);
-	g_checksum_get_digest (b_checksum, b_data, &b_len);
+	/* compare field by field, so that the first difference
+	 * returns right away. */
 
-	nm_assert (a_len == sizeof (a_data));
-	nm_assert (b_len == sizeof (b_data));
-	equal = !memcmp (a_data, b_data, a_len);
+	if (   nm_ip6_config_get_num_addresses (a) != nm_ip6_config_get_num_addresses (b)
+	    || nm_ip6_config_get_num_routes (a) != nm_ip6_config_get_num_routes (b))
+		return FALSE;
 
-	g_checksum_free (a_checksum);
-	g_checksum_free (b_checksum);
+	n = nm_ip6_config_get_num_nameservers (a);
+	if (n != nm_ip6_config_get_num_nameservers (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (!IN6_ARE_ADDR_EQUAL (nm_ip6_config_get_nameserver (a, i), nm_ip6_config_get_nameserver (b, i)))
+			return FALSE;
+	}
+
+	{
+		const NMPlatformIP6Address *addr_a, *addr_b;
+
+		nm_ip_config_iter_ip6_address_init (&iter_a, a);
+		nm_ip_config_iter_ip6_address_init (&iter_b, b);
+		while (nm_ip_config_iter_ip6_address_next (&iter_a, &addr_a)) {
+			if (!nm_ip_config_iter_ip6_address_next (&iter_b, &addr_b))
+				return FALSE;
+			if (   !IN6_ARE_ADDR_EQUAL (&addr_a->address, &addr_b->address)
+			    || addr_a->plen != addr_b->plen)
+				return FALSE;
+		}
+	}
 
-	return equal;
+	{
+		const NMPlatformIP6Route *route_a, *route_b;
+
+		nm_ip_config_iter_ip6_route_init (&iter_a, a);
+		nm_ip_config_iter_ip6_route_init (&iter_b, b);
+		while (nm_ip_config_iter_ip6_route_next (&iter_a, &route_a)) {
+			if (!nm_ip_config_iter_ip6_route_next (&iter_b, &route_b))
+				return FALSE;
+			if (   !IN6_ARE_ADDR_EQUAL (&route_a->network, &route_b->network)
+			    || route_a->plen != route_b->plen
+			    || !IN6_ARE_ADDR_EQUAL (&route_a->gateway, &route_b->gateway)
+			    || route_a->metric != route_b->metric)
+				return FALSE;
+		}
+	}
+
+	n = nm_ip6_config_get_num_domains (a);
+	if (n != nm_ip6_config_get_num_domains (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (!nm_streq (nm_ip6_config_get_domain (a, i), nm_ip6_config_get_domain (b, i)))
+			return FALSE;
+	}
+
+	n = nm_ip6_config_get_num_searches (a);
+	if (n != nm_ip6_config_get_num_searches (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (!nm_streq (nm_ip6_config_get_search (a, i), nm_ip6_config_get_search (b, i)))
+			return FALSE;
+	}
+
+	n = nm_ip6_config_get_num_dns_options (a);
+	if (n != nm_ip6_config_get_num_dns_options (b))
+		return FALSE;
+	for (i = 0; i < n; i++) {
+		if (!nm_streq (nm_ip6_config_get_dns_option (a, i), nm_ip6_config_get_dns_option (b, i)))
+			return FALSE;
+	}
+
+	return TRUE;
 }
 
 /*****************************************************************************/
@@ -115,6 +115,14 @@ gboolean nm_ip6_config_commit (const NMIP6Config *self,
                                NMPlatform *platform,
                                NMIPRouteTableSyncMode route_table_sync,
                                GPtrArray **out_temporary_not_available);
+void nm_ip6_config_commit_addresses (const NMIP6Config *self,
+                                NMPlatform *platform);
+gboolean nm_ip6_config_equal_for_commit (const NMIP6Config *a,
+                                const NMIP6Config *b,
+                                gboolean *out_lifetimes_differ);
+gboolean nm_ip6_config_platform_is_synced (const NMIP6Config *self,
+                                  NMPlatform *platform,
+                                  NMIPRouteTableSyncMode route_table_sync);
 void nm_ip6_config_merge_setting (NMIP6Config *self,
                                   NMSettingIPConfig *setting,
                                   guint32 route_table,
@@ -202,7 +210,7 @@ const NMPObject *nm_ip6_config_nmpobj_lookup (const NMIP6Config *self,
 gboolean nm_ip6_config_nmpobj_remove (NMIP6Config *self,
                                       const NMPObject *needle);
 
-void nm_ip6_config_hash (const NMIP6Config *self, GChecksum *sum, gboolean dns_only);
+void nm_ip6_config_hash (const NMIP6Config *self, NMHashState *h, gboolean dns_only);
 gboolean nm_ip6_config_equal (const NMIP6Config *a, const NMIP6Config *b);
 
 void nm_ip6_config_set_privacy (NMIP6Config *self, NMSettingIP6ConfigPrivacy privacy);
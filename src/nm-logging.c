@@ -109,6 +109,12 @@ static struct Global {
 		LOG_BACKEND_JOURNAL,
 	} log_backend;
 	char *logging_domains_to_string;
+
+	/* the levels and domains as configured by the user. These are the messages
+	 * that reach the logging backend. _nm_logging_enabled_state may enable
+	 * more, if the flight recorder is active. */
+	NMLogDomain emit_state[_LOGL_N_REAL];
+
 	const LogLevelDesc level_desc[_LOGL_N];
 
 #define _DOMAIN_DESC_LEN 39
@@ -121,6 +127,11 @@ static struct Global {
 	.log_backend = LOG_BACKEND_GLIB,
 	.syslog_identifier = "SYSLOG_IDENTIFIER="G_LOG_DOMAIN,
 	.prefix = "",
+	.emit_state = {
+		[LOGL_INFO] = LOGD_DEFAULT,
+		[LOGL_WARN] = LOGD_DEFAULT,
+		[LOGL_ERR]  = LOGD_DEFAULT,
+	},
 	.level_desc = {
 		[LOGL_TRACE] = { "TRACE", "<trace>", LOG_DEBUG,   G_LOG_LEVEL_DEBUG,   },
 		[LOGL_DEBUG] = { "DEBUG", "<debug>", LOG_DEBUG,   G_LOG_LEVEL_DEBUG,   },
@@ -185,8 +196,75 @@ G_STATIC_ASSERT (sizeof (NMLogDomain) >= sizeof (guint64));
 
 /*****************************************************************************/
 
+/* The flight recorder keeps the most recent messages of all levels in memory,
+ * regardless of the configured logging level, up to @max_size bytes. The
+ * recorded messages are only passed to the logging backend when requested
+ * via nm_logging_flight_recorder_dump().
+ *
+ * The messages are stored in a single buffer of @max_size bytes, allocated
+ * once, which is used as a ring: each record is a RecorderRecord header
+ * followed by the NUL terminated message, and new records overwrite the
+ * oldest ones. The data is contiguous in at most two segments: [head, wrap)
+ * and [0, tail) if @wrapped, or [head, tail) otherwise. */
+
+typedef struct {
+	GTimeVal tv;
+	NMLogDomain domain;
+	NMLogLevel level;
+	/* the length of the message, including the trailing NUL. */
+	guint32 len;
+} RecorderRecord;
+
+#define RECORDER_ALIGN              8
+#define RECORDER_RECORD_SIZE(len)   (((sizeof (RecorderRecord) + (len)) + (RECORDER_ALIGN - 1)) & ~((gsize) (RECORDER_ALIGN - 1)))
+#define RECORDER_MIN_SIZE           4096
+#define RECORDER_DUMP_CHUNK         500
+
+G_STATIC_ASSERT ((sizeof (RecorderRecord) % RECORDER_ALIGN) == 0);
+
+static struct {
+	GMutex lock;
+	char *buf;
+	gsize max_size;
+	gsize head;
+	gsize tail;
+	gsize wrap;
+	guint n_records;
+	bool wrapped:1;
+	guint64 n_evicted;
+
+	/* the number of the oldest records that are still to be passed
+	 * to the backend by the running dump. */
+	guint dump_remaining;
+	guint dump_n;
+	guint dump_id;
+	NMLoggingFlightRecorderDumpCallback dump_callback;
+	gpointer dump_user_data;
+} recorder;
+
+/*****************************************************************************/
+
 static char *_domains_to_string (gboolean include_level_override);
 
+static void
+_enabled_state_update (void)
+{
+	int i;
+
+	for (i = 0; i < G_N_ELEMENTS (_nm_logging_enabled_state); i++) {
+		NMLogDomain d = global.emit_state[i];
+
+		if (recorder.max_size > 0) {
+			/* like for the "ALL" domain, LOGD_VPN_PLUGIN is protected
+			 * and not recorded at DEBUG and TRACE levels. */
+			d |= i < LOGL_INFO
+			     ? (LOGD_ALL & ~LOGD_VPN_PLUGIN)
+			     : LOGD_ALL;
+		}
+		_nm_logging_enabled_state[i] = d;
+	}
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -281,7 +359,7 @@ nm_logging_setup (const char  *level,
                   GError     **error)
 {
 	GString *unrecognized = NULL;
-	NMLogDomain new_logging[G_N_ELEMENTS (_nm_logging_enabled_state)];
+	NMLogDomain new_logging[G_N_ELEMENTS (global.emit_state)];
 	NMLogLevel new_log_level = global.log_level;
 	char **tmp, **iter;
 	int i;
@@ -305,7 +383,7 @@ nm_logging_setup (const char  *level,
 		if (new_log_level == _LOGL_KEEP) {
 			new_log_level = global.log_level;
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-				new_logging[i] = _nm_logging_enabled_state[i];
+				new_logging[i] = global.emit_state[i];
 		}
 	}
 
@@ -387,7 +465,7 @@ nm_logging_setup (const char  *level,
 
 		if (domain_log_level == _LOGL_KEEP) {
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-				new_logging[i] = (new_logging[i] & ~bits) | (_nm_logging_enabled_state[i] & bits);
+				new_logging[i] = (new_logging[i] & ~bits) | (global.emit_state[i] & bits);
 		} else {
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++) {
 				if (i < domain_log_level)
@@ -405,15 +483,16 @@ nm_logging_setup (const char  *level,
 
 	g_clear_pointer (&global.logging_domains_to_string, g_free);
 
-	had_platform_debug = nm_logging_enabled (LOGL_DEBUG, LOGD_PLATFORM);
+	had_platform_debug = nm_logging_emit_enabled (LOGL_DEBUG, LOGD_PLATFORM);
 
 	global.log_level = new_log_level;
 	for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-		_nm_logging_enabled_state[i] = new_logging[i];
+		global.emit_state[i] = new_logging[i];
+	_enabled_state_update ();
 
 	if (   had_platform_debug
 	    && _nm_logging_clear_platform_logging_cache
-	    && !nm_logging_enabled (LOGL_DEBUG, LOGD_PLATFORM)) {
+	    && !nm_logging_emit_enabled (LOGL_DEBUG, LOGD_PLATFORM)) {
 		/* when debug logging is enabled, platform will cache all access to
 		 * sysctl. When the user disables debug-logging, we want to clear that
 		 * cache right away. */
@@ -474,7 +553,7 @@ _domains_to_string (gboolean include_level_override)
 	str = g_string_sized_new (75);
 	for (diter = &global.domain_desc[0]; diter->name; diter++) {
 		/* If it's set for any lower level, it will also be set for LOGL_ERR */
-		if (!(diter->num & _nm_logging_enabled_state[LOGL_ERR]))
+		if (!(diter->num & global.emit_state[LOGL_ERR]))
 			continue;
 
 		if (str->len)
@@ -486,15 +565,15 @@ _domains_to_string (gboolean include_level_override)
 
 		/* Check if it's logging at a lower level than the default. */
 		for (i = 0; i < global.log_level; i++) {
-			if (diter->num & _nm_logging_enabled_state[i]) {
+			if (diter->num & global.emit_state[i]) {
 				g_string_append_printf (str, ":%s", global.level_desc[i].name);
 				break;
 			}
 		}
 		/* Check if it's logging at a higher level than the default. */
-		if (!(diter->num & _nm_logging_enabled_state[global.log_level])) {
-			for (i = global.log_level + 1; i < G_N_ELEMENTS (_nm_logging_enabled_state); i++) {
-				if (diter->num & _nm_logging_enabled_state[i]) {
+		if (!(diter->num & global.emit_state[global.log_level])) {
+			for (i = global.log_level + 1; i < G_N_ELEMENTS (global.emit_state); i++) {
+				if (diter->num & global.emit_state[i]) {
 					g_string_append_printf (str, ":%s", global.level_desc[i].name);
 					break;
 				}
@@ -527,6 +606,25 @@ nm_logging_all_domains_to_string (void)
 	return str->str;
 }
 
+/**
+ * nm_logging_emit_enabled:
+ * @level: the logging level
+ * @domain: the logging domains
+ *
+ * Unlike nm_logging_enabled(), this doesn't include the messages that
+ * are only kept by the flight recorder. Use it to decide whether to do
+ * extra work for debug logging, like making helper programs verbose.
+ *
+ * Returns: whether messages of @level and @domain reach the logging backend.
+ */
+gboolean
+nm_logging_emit_enabled (NMLogLevel level, NMLogDomain domain)
+{
+	nm_assert (((guint) level) < G_N_ELEMENTS (global.emit_state));
+	return    (((guint) level) < G_N_ELEMENTS (global.emit_state))
+	       && !!(global.emit_state[level] & domain);
+}
+
 /**
  * nm_logging_get_level:
  * @domain: find the lowest enabled logging level for the
@@ -543,7 +641,7 @@ nm_logging_get_level (NMLogDomain domain)
 
 	G_STATIC_ASSERT (LOGL_TRACE == 0);
 	while (   sl > LOGL_TRACE
-	       && nm_logging_enabled (sl - 1, domain))
+	       && NM_FLAGS_ANY (global.emit_state[sl - 1], domain))
 		sl--;
 	return sl;
 }
@@ -593,42 +691,6 @@ _iovec_set_format (struct iovec *iov, gpointer *iov_free, const char *format, ..
 	} G_STMT_END
 #endif
 
-void
-_nm_log_impl (const char *file,
-              guint line,
-              const char *func,
-              NMLogLevel level,
-              NMLogDomain domain,
-              int error,
-              const char *ifname,
-              const char *conn_uuid,
-              const char *fmt,
-              ...)
-{
-	va_list args;
-	char *msg;
-	GTimeVal tv;
-	int errno_saved;
-
-	if ((guint) level >= G_N_ELEMENTS (_nm_logging_enabled_state))
-		g_return_if_reached ();
-
-	if (!(_nm_logging_enabled_state[level] & domain))
-		return;
-
-	errno_saved = errno;
-
-	/* Make sure that %m maps to the specified error */
-	if (error != 0) {
-		if (error < 0)
-			error = -error;
-		errno = error;
-	}
-
-	va_start (args, fmt);
-	msg = g_strdup_vprintf (fmt, args);
-	va_end (args);
-
 #define MESSAGE_FMT "%s%-7s [%ld.%04ld] %s"
 #define MESSAGE_ARG(global, tv, msg) \
     (global).prefix, \
@@ -637,16 +699,28 @@ _nm_log_impl (const char *file,
     ((tv).tv_usec / 100), \
     (msg)
 
-	g_get_current_time (&tv);
-
-	if (global.debug_stderr)
-		g_printerr (MESSAGE_FMT"\n", MESSAGE_ARG (global, tv, msg));
-
+/* Pass one message to the logging backend. All arguments are captured by
+ * the caller, so that this can also run on the writer thread of the
+ * asynchronous mode. */
+static void
+_log_emit (const char *file,
+           guint line,
+           const char *func,
+           NMLogLevel level,
+           NMLogDomain domain,
+           NMLogDomain domain_enabled,
+           int error,
+           const char *ifname,
+           const char *conn_uuid,
+           const GTimeVal *tv,
+           gint64 now,
+           gint64 boottime,
+           const char *msg)
+{
 	switch (global.log_backend) {
 #if SYSTEMD_JOURNAL
 	case LOG_BACKEND_JOURNAL:
 		{
-			gint64 now, boottime;
 #define _NUM_MAX_FIELDS_SYSLOG_FACILITY 10
 			struct iovec iov_data[12 + _NUM_MAX_FIELDS_SYSLOG_FACILITY];
 			struct iovec *iov = iov_data;
@@ -654,11 +728,8 @@ _nm_log_impl (const char *file,
 			gpointer *iov_free = iov_free_data;
 			nm_auto_free_gstring GString *s_domain_all = NULL;
 
-			now = nm_utils_get_monotonic_timestamp_ns ();
-			boottime = nm_utils_monotonic_timestamp_as_boottime (now, 1);
-
 			_iovec_set_format_a (iov++, 30, "PRIORITY=%d", global.level_desc[level].syslog_level);
-			_iovec_set_format (iov++, iov_free++, "MESSAGE="MESSAGE_FMT, MESSAGE_ARG (global, tv, msg));
+			_iovec_set_format (iov++, iov_free++, "MESSAGE="MESSAGE_FMT, MESSAGE_ARG (global, *tv, msg));
 			_iovec_set_string (iov++, syslog_identifier_full (&global));
 			_iovec_set_format_a (iov++, 30, "SYSLOG_PID=%ld", (long) getpid ());
 			{
@@ -666,7 +737,7 @@ _nm_log_impl (const char *file,
 				int i_domain = _NUM_MAX_FIELDS_SYSLOG_FACILITY;
 				const char *s_domain_1 = NULL;
 				NMLogDomain dom_all = domain;
-				NMLogDomain dom = dom_all & _nm_logging_enabled_state[level];
+				NMLogDomain dom = dom_all & domain_enabled;
 
 				for (diter = &global.domain_desc[0]; diter->name; diter++) {
 					if (!NM_FLAGS_ANY (dom_all, diter->num))
@@ -729,14 +800,525 @@ _nm_log_impl (const char *file,
 #endif
 	case LOG_BACKEND_SYSLOG:
 		syslog (global.level_desc[level].syslog_level,
-		        MESSAGE_FMT, MESSAGE_ARG (global, tv, msg));
+		        MESSAGE_FMT, MESSAGE_ARG (global, *tv, msg));
 		break;
 	default:
 		g_log (syslog_identifier_domain (&global), global.level_desc[level].g_log_level,
-		       MESSAGE_FMT, MESSAGE_ARG (global, tv, msg));
+		       MESSAGE_FMT, MESSAGE_ARG (global, *tv, msg));
 		break;
 	}
 
+}
+
+/*****************************************************************************/
+
+/* In asynchronous mode, messages are copied into a preallocated ring and
+ * handed to the backend by a writer thread, so that a verbose log level
+ * doesn't slow down the main loop. When the ring is full, messages are
+ * dropped and counted; the writer reports the number of dropped messages.
+ * Messages that don't fit into the slot are not truncated, they are copied
+ * to the heap instead. The ring is flushed on fatal messages and by
+ * nm_logging_async_stop(). */
+
+#define ASYNC_RING_SIZE  1024
+#define ASYNC_MSG_MAX    1024
+
+typedef struct {
+	const char *file;
+	const char *func;
+	guint line;
+	NMLogLevel level;
+	NMLogDomain domain;
+	NMLogDomain domain_enabled;
+	int error;
+	GTimeVal tv;
+	gint64 now;
+	gint64 boottime;
+	bool has_ifname:1;
+	bool has_conn_uuid:1;
+	char ifname[64];
+	char conn_uuid[40];
+	/* set instead of @msg for messages longer than ASYNC_MSG_MAX. */
+	char *msg_long;
+	char msg[ASYNC_MSG_MAX];
+} AsyncEntry;
+
+static struct {
+	GMutex lock;
+	GCond cond_pending;
+	GCond cond_flushed;
+	GThread *thread;
+	AsyncEntry *ring;
+	guint head;
+	guint n;
+	guint64 n_dropped;
+	bool stop;
+} async;
+
+static void
+_async_emit_dropped (guint64 n_dropped)
+{
+	char msg[100];
+	GTimeVal tv;
+	gint64 now;
+
+	g_get_current_time (&tv);
+	now = nm_utils_get_monotonic_timestamp_ns ();
+	nm_sprintf_buf (msg, "logging: %"G_GUINT64_FORMAT" messages dropped, the log buffer was full", n_dropped);
+	_log_emit (__FILE__, __LINE__, G_STRFUNC, LOGL_WARN, LOGD_CORE, LOGD_CORE, 0, NULL, NULL,
+	           &tv, now, nm_utils_monotonic_timestamp_as_boottime (now, 1), msg);
+}
+
+static gpointer
+_async_thread (gpointer user_data)
+{
+	g_mutex_lock (&async.lock);
+	for (;;) {
+		guint i, first, n;
+		guint64 n_dropped;
+
+		while (   async.n == 0
+		       && !async.n_dropped
+		       && !async.stop)
+			g_cond_wait (&async.cond_pending, &async.lock);
+
+		if (   async.n == 0
+		    && !async.n_dropped
+		    && async.stop)
+			break;
+
+		/* the producers only write to free slots, so the entries can be
+		 * emitted without holding the lock. */
+		first = async.head;
+		n = async.n;
+		n_dropped = async.n_dropped;
+		async.n_dropped = 0;
+		g_mutex_unlock (&async.lock);
+
+		for (i = 0; i < n; i++) {
+			AsyncEntry *e = &async.ring[(first + i) % ASYNC_RING_SIZE];
+
+			_log_emit (e->file, e->line, e->func, e->level, e->domain, e->domain_enabled,
+			           e->error,
+			           e->has_ifname ? e->ifname : NULL,
+			           e->has_conn_uuid ? e->conn_uuid : NULL,
+			           &e->tv, e->now, e->boottime, e->msg_long ?: e->msg);
+			nm_clear_g_free (&e->msg_long);
+		}
+		if (n_dropped)
+			_async_emit_dropped (n_dropped);
+
+		g_mutex_lock (&async.lock);
+		async.head = (first + n) % ASYNC_RING_SIZE;
+		async.n -= n;
+		if (async.n == 0)
+			g_cond_broadcast (&async.cond_flushed);
+	}
+	g_cond_broadcast (&async.cond_flushed);
+	g_mutex_unlock (&async.lock);
+	return NULL;
+}
+
+static void
+_async_push (const char *file,
+             guint line,
+             const char *func,
+             NMLogLevel level,
+             NMLogDomain domain,
+             int error,
+             const char *ifname,
+             const char *conn_uuid,
+             const GTimeVal *tv,
+             gint64 now,
+             gint64 boottime,
+             const char *msg)
+{
+	AsyncEntry *e;
+	char *msg_long = NULL;
+	gsize len;
+
+	len = strlen (msg);
+	if (G_UNLIKELY (len >= ASYNC_MSG_MAX))
+		msg_long = g_strndup (msg, len);
+
+	g_mutex_lock (&async.lock);
+	if (async.n >= ASYNC_RING_SIZE) {
+		async.n_dropped++;
+		g_mutex_unlock (&async.lock);
+		g_free (msg_long);
+		return;
+	}
+
+	e = &async.ring[(async.head + async.n) % ASYNC_RING_SIZE];
+	e->file = file;
+	e->func = func;
+	e->line = line;
+	e->level = level;
+	e->domain = domain;
+	e->domain_enabled = domain & global.emit_state[level];
+	e->error = error;
+	e->tv = *tv;
+	e->now = now;
+	e->boottime = boottime;
+	e->has_ifname = !!ifname;
+	if (ifname)
+		g_strlcpy (e->ifname, ifname, sizeof (e->ifname));
+	e->has_conn_uuid = !!conn_uuid;
+	if (conn_uuid)
+		g_strlcpy (e->conn_uuid, conn_uuid, sizeof (e->conn_uuid));
+	e->msg_long = msg_long;
+	if (!msg_long)
+		memcpy (e->msg, msg, len + 1);
+
+	if (async.n++ == 0)
+		g_cond_signal (&async.cond_pending);
+	g_mutex_unlock (&async.lock);
+}
+
+/**
+ * nm_logging_async_flush:
+ *
+ * Wait until the writer thread passed all queued messages to the
+ * logging backend. Does nothing unless asynchronous logging is enabled.
+ */
+void
+nm_logging_async_flush (void)
+{
+	if (!async.thread)
+		return;
+
+	/* a fatal message on the writer thread itself can't wait for it. */
+	if (g_thread_self () == async.thread)
+		return;
+
+	g_mutex_lock (&async.lock);
+	g_cond_signal (&async.cond_pending);
+	while (async.n > 0 || async.n_dropped)
+		g_cond_wait (&async.cond_flushed, &async.lock);
+	g_mutex_unlock (&async.lock);
+}
+
+static void
+_async_start (void)
+{
+	nm_assert (!async.thread);
+
+	async.ring = g_new (AsyncEntry, ASYNC_RING_SIZE);
+	async.thread = g_thread_new ("nm-logging", _async_thread, NULL);
+
+	/* don't lose the queued messages on exit(). */
+	atexit (nm_logging_async_stop);
+}
+
+/**
+ * nm_logging_async_stop:
+ *
+ * Flush the queued messages, stop the writer thread and log synchronously
+ * from now on.
+ */
+void
+nm_logging_async_stop (void)
+{
+	GThread *thread;
+
+	if (!async.thread)
+		return;
+
+	g_mutex_lock (&async.lock);
+	async.stop = TRUE;
+	g_cond_signal (&async.cond_pending);
+	g_mutex_unlock (&async.lock);
+
+	thread = g_steal_pointer (&async.thread);
+	g_thread_join (thread);
+	g_clear_pointer (&async.ring, g_free);
+}
+
+/*****************************************************************************/
+
+static void
+_recorder_drop_oldest (void)
+{
+	const RecorderRecord *rec;
+
+	nm_assert (recorder.n_records > 0);
+
+	rec = (const RecorderRecord *) &recorder.buf[recorder.head];
+	recorder.head += RECORDER_RECORD_SIZE (rec->len);
+	recorder.n_records--;
+
+	if (recorder.n_records == 0) {
+		recorder.head = 0;
+		recorder.tail = 0;
+		recorder.wrapped = FALSE;
+	} else if (   recorder.wrapped
+	           && recorder.head == recorder.wrap) {
+		recorder.head = 0;
+		recorder.wrapped = FALSE;
+	}
+}
+
+static void
+_recorder_push (NMLogLevel level,
+                NMLogDomain domain,
+                const GTimeVal *tv,
+                const char *msg)
+{
+	RecorderRecord *rec;
+	gsize len;
+	gsize rsize;
+
+	len = strlen (msg) + 1;
+
+	g_mutex_lock (&recorder.lock);
+
+	if (!recorder.buf) {
+		g_mutex_unlock (&recorder.lock);
+		return;
+	}
+
+	/* a message that does not fit into the buffer at all is truncated. */
+	if (RECORDER_RECORD_SIZE (len) > recorder.max_size)
+		len = recorder.max_size - sizeof (RecorderRecord);
+	rsize = RECORDER_RECORD_SIZE (len);
+
+	for (;;) {
+		if (!recorder.wrapped) {
+			if (recorder.max_size - recorder.tail >= rsize)
+				break;
+			/* not enough space left at the end of the buffer, continue
+			 * at its start. */
+			recorder.wrap = recorder.tail;
+			recorder.tail = 0;
+			recorder.wrapped = TRUE;
+		}
+		if (recorder.head - recorder.tail >= rsize)
+			break;
+
+		_recorder_drop_oldest ();
+		recorder.n_evicted++;
+		if (recorder.dump_remaining > 0) {
+			/* the running dump lost its oldest message. */
+			recorder.dump_remaining--;
+		}
+	}
+
+	rec = (RecorderRecord *) &recorder.buf[recorder.tail];
+	rec->tv = *tv;
+	rec->domain = domain;
+	rec->level = level;
+	rec->len = len;
+	memcpy (&rec[1], msg, len - 1);
+	((char *) &rec[1])[len - 1] = '\0';
+
+	recorder.tail += rsize;
+	recorder.n_records++;
+
+	g_mutex_unlock (&recorder.lock);
+}
+
+/**
+ * nm_logging_flight_recorder_setup:
+ * @max_size: the number of bytes that the recorded messages
+ *   may use, or zero to disable the flight recorder.
+ *
+ * Start or stop recording messages of all levels and domains in memory.
+ * The buffer is allocated right away, changing its size drops the
+ * messages recorded so far.
+ */
+void
+nm_logging_flight_recorder_setup (gsize max_size)
+{
+	if (max_size > 0) {
+		max_size = MAX (max_size, RECORDER_MIN_SIZE);
+		max_size &= ~((gsize) (RECORDER_ALIGN - 1));
+	}
+
+	g_mutex_lock (&recorder.lock);
+	if (max_size != recorder.max_size) {
+		recorder.n_evicted += recorder.n_records;
+		g_free (recorder.buf);
+		recorder.buf = max_size > 0 ? g_malloc (max_size) : NULL;
+		recorder.max_size = max_size;
+		recorder.head = 0;
+		recorder.tail = 0;
+		recorder.wrap = 0;
+		recorder.wrapped = FALSE;
+		recorder.n_records = 0;
+		recorder.dump_remaining = 0;
+	}
+	g_mutex_unlock (&recorder.lock);
+
+	_enabled_state_update ();
+}
+
+gboolean
+nm_logging_flight_recorder_enabled (void)
+{
+	return recorder.max_size > 0;
+}
+
+static gboolean
+_recorder_dump_cb (gpointer user_data)
+{
+	NMLoggingFlightRecorderDumpCallback callback;
+	gint64 now = 0, boottime = 0;
+	guint i;
+
+#if SYSTEMD_JOURNAL
+	if (global.log_backend == LOG_BACKEND_JOURNAL) {
+		now = nm_utils_get_monotonic_timestamp_ns ();
+		boottime = nm_utils_monotonic_timestamp_as_boottime (now, 1);
+	}
+#endif
+
+	for (i = 0; i < RECORDER_DUMP_CHUNK; i++) {
+		const RecorderRecord *rec;
+		RecorderRecord rec_copy;
+		gs_free char *msg = NULL;
+
+		g_mutex_lock (&recorder.lock);
+		if (recorder.dump_remaining == 0) {
+			g_mutex_unlock (&recorder.lock);
+			goto done;
+		}
+		rec = (const RecorderRecord *) &recorder.buf[recorder.head];
+		rec_copy = *rec;
+		msg = g_memdup (&rec[1], rec->len);
+		_recorder_drop_oldest ();
+		recorder.dump_remaining--;
+		g_mutex_unlock (&recorder.lock);
+
+		_log_emit (NULL, 0, NULL, rec_copy.level, rec_copy.domain, rec_copy.domain, 0, NULL, NULL,
+		           &rec_copy.tv, now, boottime, msg);
+		recorder.dump_n++;
+	}
+
+	/* let the main loop run before emitting the next chunk. */
+	return G_SOURCE_CONTINUE;
+
+done:
+	nm_log_info (LOGD_CORE, "logging: flight recorder dump ends (%u messages)", recorder.dump_n);
+
+	recorder.dump_id = 0;
+	callback = recorder.dump_callback;
+	recorder.dump_callback = NULL;
+	callback (recorder.dump_n, g_steal_pointer (&recorder.dump_user_data));
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * nm_logging_flight_recorder_dump:
+ * @callback: invoked once all messages were dumped.
+ * @user_data: user data for @callback.
+ *
+ * Pass the messages recorded so far to the logging backend, with their
+ * original timestamp, and drop them from the recorder. Writing out a
+ * large recorder takes a while, so the messages are passed in chunks from
+ * an idle source and the main loop keeps running in between. Messages
+ * that are recorded in the meantime are not part of the dump.
+ *
+ * Returns: %FALSE if a dump is already in progress. In that case,
+ *   @callback is not invoked.
+ */
+gboolean
+nm_logging_flight_recorder_dump (NMLoggingFlightRecorderDumpCallback callback,
+                                 gpointer user_data)
+{
+	guint64 n_evicted;
+
+	g_return_val_if_fail (callback, FALSE);
+
+	if (recorder.dump_id)
+		return FALSE;
+
+	g_mutex_lock (&recorder.lock);
+	recorder.dump_remaining = recorder.n_records;
+	n_evicted = recorder.n_evicted;
+	recorder.n_evicted = 0;
+	g_mutex_unlock (&recorder.lock);
+
+	recorder.dump_n = 0;
+	recorder.dump_callback = callback;
+	recorder.dump_user_data = user_data;
+
+	/* the dump must not interleave with queued messages. */
+	nm_logging_async_flush ();
+
+	nm_log_info (LOGD_CORE, "logging: flight recorder dump starts (%"G_GUINT64_FORMAT" older messages were discarded)",
+	             n_evicted);
+
+	recorder.dump_id = g_idle_add (_recorder_dump_cb, NULL);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+void
+_nm_log_impl (const char *file,
+              guint line,
+              const char *func,
+              NMLogLevel level,
+              NMLogDomain domain,
+              int error,
+              const char *ifname,
+              const char *conn_uuid,
+              const char *fmt,
+              ...)
+{
+	va_list args;
+	char *msg;
+	GTimeVal tv;
+	gint64 now = 0, boottime = 0;
+	int errno_saved;
+
+	if ((guint) level >= G_N_ELEMENTS (_nm_logging_enabled_state))
+		g_return_if_reached ();
+
+	if (!(_nm_logging_enabled_state[level] & domain))
+		return;
+
+	errno_saved = errno;
+
+	/* Make sure that %m maps to the specified error */
+	if (error != 0) {
+		if (error < 0)
+			error = -error;
+		errno = error;
+	}
+
+	va_start (args, fmt);
+	msg = g_strdup_vprintf (fmt, args);
+	va_end (args);
+
+	g_get_current_time (&tv);
+
+	/* with the flight recorder, more messages are enabled than configured.
+	 * These are only recorded. */
+	if (global.emit_state[level] & domain) {
+		if (global.debug_stderr)
+			g_printerr (MESSAGE_FMT"\n", MESSAGE_ARG (global, tv, msg));
+
+#if SYSTEMD_JOURNAL
+		if (global.log_backend == LOG_BACKEND_JOURNAL) {
+			now = nm_utils_get_monotonic_timestamp_ns ();
+			boottime = nm_utils_monotonic_timestamp_as_boottime (now, 1);
+		}
+#endif
+
+		if (async.thread) {
+			_async_push (file, line, func, level, domain, error, ifname, conn_uuid,
+			             &tv, now, boottime, msg);
+		} else {
+			_log_emit (file, line, func, level, domain,
+			           domain & global.emit_state[level],
+			           error, ifname, conn_uuid, &tv, now, boottime, msg);
+		}
+	}
+
+	if (recorder.max_size > 0)
+		_recorder_push (level, domain, &tv, msg);
+
 	g_free (msg);
 
 	errno = errno_saved;
@@ -774,6 +1356,11 @@ nm_log_handler (const char *log_domain,
 		break;
 	}
 
+	if (NM_FLAGS_ANY (level, G_LOG_FLAG_FATAL | G_LOG_LEVEL_ERROR)) {
+		/* the process is about to abort. Get the queued messages out first. */
+		nm_logging_async_flush ();
+	}
+
 	if (global.debug_stderr)
 		g_printerr ("%s%s\n", global.prefix, message ?: "");
 
@@ -836,7 +1423,7 @@ nm_logging_set_prefix (const char *format, ...)
 }
 
 void
-nm_logging_syslog_openlog (const char *logging_backend, gboolean debug)
+nm_logging_syslog_openlog (const char *logging_backend, gboolean debug, gboolean async_mode)
 {
 	gboolean fetch_monotonic_timestamp = FALSE;
 	gboolean obsolete_debug_backend = FALSE;
@@ -888,6 +1475,9 @@ nm_logging_syslog_openlog (const char *logging_backend, gboolean debug)
 		nm_utils_get_monotonic_timestamp_ns ();
 	}
 
+	if (async_mode)
+		_async_start ();
+
 	if (obsolete_debug_backend)
 		nm_log_dbg (LOGD_CORE, "config: ignore deprecated logging backend 'debug', fallback to '%s'", logging_backend);
 
@@ -229,6 +229,8 @@ nm_logging_enabled (NMLogLevel level, NMLogDomain domain)
 	       && !!(_nm_logging_enabled_state[level] & domain);
 }
 
+gboolean nm_logging_emit_enabled (NMLogLevel level, NMLogDomain domain);
+
 NMLogLevel nm_logging_get_level (NMLogDomain domain);
 
 const char *nm_logging_all_levels_to_string (void);
@@ -242,9 +244,19 @@ gboolean nm_logging_setup (const char  *level,
 void nm_logging_set_syslog_identifier (const char *domain);
 void nm_logging_set_prefix (const char *format, ...) _nm_printf (1, 2);
 
-void     nm_logging_syslog_openlog (const char *logging_backend, gboolean debug);
+void     nm_logging_syslog_openlog (const char *logging_backend, gboolean debug, gboolean async_mode);
 gboolean nm_logging_syslog_enabled (void);
 
+void nm_logging_async_flush (void);
+void nm_logging_async_stop (void);
+
+typedef void (*NMLoggingFlightRecorderDumpCallback) (guint n_messages, gpointer user_data);
+
+void     nm_logging_flight_recorder_setup (gsize max_size);
+gboolean nm_logging_flight_recorder_enabled (void);
+gboolean nm_logging_flight_recorder_dump (NMLoggingFlightRecorderDumpCallback callback,
+                                          gpointer user_data);
+
 /*****************************************************************************/
 
 /* This is the default definition of _NMLOG_ENABLED(). Special implementations
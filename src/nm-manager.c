@@ -170,7 +170,11 @@ typedef struct {
 	} prop_filter;
 	NMRfkillManager *rfkill_mgr;
 
+	/* ifindexes of links that were added or removed in platform, and that
+	 * are processed together by _platform_link_cb_batch(). */
 	CList link_cb_lst;
+	GHashTable *link_cb_idx;
+	guint link_cb_source_id;
 
 	NMCheckpointManager *checkpoint_mgr;
 
@@ -204,6 +208,9 @@ typedef struct {
 	bool sleeping:1;
 	bool net_enabled:1;
 
+	bool update_state_blocked:1;
+	bool update_state_pending:1;
+
 	unsigned connectivity_check_enabled_last:2;
 
 	guint delete_volatile_connection_idle_id;
@@ -1450,6 +1457,14 @@ nm_manager_update_state (NMManager *self)
 
 	priv = NM_MANAGER_GET_PRIVATE (self);
 
+	if (priv->update_state_blocked) {
+		/* processing a batch of link changes. The state is updated once
+		 * at the end. */
+		priv->update_state_pending = TRUE;
+		return;
+	}
+	priv->update_state_pending = FALSE;
+
 	if (manager_sleeping (self))
 		new_state = NM_STATE_ASLEEP;
 	else
@@ -3194,22 +3209,15 @@ add:
 
 typedef struct {
 	CList lst;
-	NMManager *self;
 	int ifindex;
-	guint idle_id;
 } PlatformLinkCbData;
 
-static gboolean
-_platform_link_cb_idle (PlatformLinkCbData *data)
+static void
+_platform_link_process (NMManager *self, int ifindex)
 {
-	int ifindex = data->ifindex;
-	NMManager *self = data->self;
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	const NMPlatformLink *plink;
 
-	c_list_unlink_stale (&data->lst);
-	g_slice_free (PlatformLinkCbData, data);
-
 	plink = nm_platform_link_get (priv->platform, ifindex);
 	if (plink) {
 		const NMPObject *plink_keep_alive = nmp_object_ref (NMP_OBJECT_UP_CAST (plink));
@@ -3238,7 +3246,47 @@ _platform_link_cb_idle (PlatformLinkCbData *data)
 			}
 		}
 	}
+}
+
+static gboolean
+_platform_link_cb_batch (gpointer user_data)
+{
+	NMManager *self = user_data;
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	PlatformLinkCbData *data;
+	guint n = 0;
+
+	/* Process all links that changed since the batch was scheduled. Links that
+	 * were added and removed again in the meantime are no longer in the platform
+	 * cache, so no device is created (and exported) for them.
+	 *
+	 * Links that change while processing the batch are appended to the list
+	 * and handled by this loop as well. */
+	g_object_freeze_notify (G_OBJECT (self));
+	priv->update_state_blocked = TRUE;
+
+	while ((data = c_list_first_entry (&priv->link_cb_lst, PlatformLinkCbData, lst))) {
+		int ifindex = data->ifindex;
+
+		if (!g_hash_table_remove (priv->link_cb_idx, GINT_TO_POINTER (ifindex)))
+			nm_assert_not_reached ();
+		c_list_unlink_stale (&data->lst);
+		g_slice_free (PlatformLinkCbData, data);
+
+		_platform_link_process (self, ifindex);
+		n++;
+	}
+
+	priv->link_cb_source_id = 0;
+
+	priv->update_state_blocked = FALSE;
+	if (priv->update_state_pending)
+		nm_manager_update_state (self);
+
+	if (n > 1)
+		_LOGD (LOGD_PLATFORM, "processed %u link changes in one batch", n);
 
+	g_object_thaw_notify (G_OBJECT (self));
 	return G_SOURCE_REMOVE;
 }
 
@@ -3254,6 +3302,7 @@ platform_link_cb (NMPlatform *platform,
 	NMManagerPrivate *priv;
 	const NMPlatformSignalChangeType change_type = change_type_i;
 	PlatformLinkCbData *data;
+	gint64 timeout_msec;
 
 	switch (change_type) {
 	case NM_PLATFORM_SIGNAL_ADDED:
@@ -3261,11 +3310,26 @@ platform_link_cb (NMPlatform *platform,
 		self = NM_MANAGER (user_data);
 		priv = NM_MANAGER_GET_PRIVATE (self);
 
+		/* the batch looks at the current state of the link in the platform
+		 * cache. A link that is already pending needs no second entry. */
+		if (g_hash_table_contains (priv->link_cb_idx, GINT_TO_POINTER (ifindex)))
+			break;
+
 		data = g_slice_new (PlatformLinkCbData);
-		data->self = self;
 		data->ifindex = ifindex;
 		c_list_link_tail (&priv->link_cb_lst, &data->lst);
-		data->idle_id = g_idle_add ((GSourceFunc) _platform_link_cb_idle, data);
+		g_hash_table_insert (priv->link_cb_idx, GINT_TO_POINTER (ifindex), data);
+
+		if (!priv->link_cb_source_id) {
+			timeout_msec = nm_config_data_get_value_int64 (NM_CONFIG_GET_DATA,
+			                                               NM_CONFIG_KEYFILE_GROUP_MAIN,
+			                                               NM_CONFIG_KEYFILE_KEY_MAIN_LINK_EVENTS_COALESCE_TIMEOUT,
+			                                               10, 0, 10000, 0);
+			if (timeout_msec > 0)
+				priv->link_cb_source_id = g_timeout_add (timeout_msec, _platform_link_cb_batch, self);
+			else
+				priv->link_cb_source_id = g_idle_add (_platform_link_cb_batch, self);
+		}
 		break;
 	default:
 		break;
@@ -5944,6 +6008,50 @@ impl_manager_get_logging (NMDBusObject *obj,
 	                                                      nm_logging_domains_to_string ()));
 }
 
+static void
+_dump_log_recorder_cb (guint n_messages, gpointer user_data)
+{
+	GDBusMethodInvocation *invocation = user_data;
+
+	g_dbus_method_invocation_return_value (invocation,
+	                                       g_variant_new ("(u)", n_messages));
+}
+
+static void
+impl_manager_dump_log_recorder (NMDBusObject *obj,
+                                const NMDBusInterfaceInfoExtended *interface_info,
+                                const NMDBusMethodInfoExtended *method_info,
+                                GDBusConnection *connection,
+                                const char *sender,
+                                GDBusMethodInvocation *invocation,
+                                GVariant *parameters)
+{
+	NMManager *self = NM_MANAGER (obj);
+
+	/* Like for SetLogging, the permission is enforced by the D-Bus daemon. */
+	if (!nm_dbus_manager_ensure_uid (nm_dbus_object_get_manager (NM_DBUS_OBJECT (self)),
+	                                 invocation,
+	                                 G_MAXULONG,
+	                                 NM_MANAGER_ERROR,
+	                                 NM_MANAGER_ERROR_PERMISSION_DENIED))
+		return;
+
+	if (!nm_logging_flight_recorder_enabled ()) {
+		g_dbus_method_invocation_return_error_literal (invocation,
+		                                               NM_MANAGER_ERROR,
+		                                               NM_MANAGER_ERROR_FAILED,
+		                                               "The logging flight recorder is not enabled");
+		return;
+	}
+
+	if (!nm_logging_flight_recorder_dump (_dump_log_recorder_cb, invocation)) {
+		g_dbus_method_invocation_return_error_literal (invocation,
+		                                               NM_MANAGER_ERROR,
+		                                               NM_MANAGER_ERROR_FAILED,
+		                                               "A dump of the logging flight recorder is already in progress");
+	}
+}
+
 typedef struct {
 	NMManager *self;
 	GDBusMethodInvocation *context;
@@ -7033,6 +7141,7 @@ nm_manager_init (NMManager *self)
 	GFile *file;
 
 	c_list_init (&priv->link_cb_lst);
+	priv->link_cb_idx = g_hash_table_new (nm_direct_hash, NULL);
 	c_list_init (&priv->devices_lst_head);
 	c_list_init (&priv->active_connections_lst_head);
 	c_list_init (&priv->async_op_lst_head);
@@ -7288,13 +7397,14 @@ dispose (GObject *object)
 	g_signal_handlers_disconnect_by_func (priv->platform,
 	                                      G_CALLBACK (platform_link_cb),
 	                                      self);
+	nm_clear_g_source (&priv->link_cb_source_id);
 	c_list_for_each_safe (iter, iter_safe, &priv->link_cb_lst) {
 		PlatformLinkCbData *data = c_list_entry (iter, PlatformLinkCbData, lst);
 
-		g_source_remove (data->idle_id);
 		c_list_unlink_stale (iter);
 		g_slice_free (PlatformLinkCbData, data);
 	}
+	g_clear_pointer (&priv->link_cb_idx, g_hash_table_destroy);
 
 	g_slist_free_full (priv->auth_chains, (GDestroyNotify) nm_auth_chain_destroy);
 	priv->auth_chains = NULL;
@@ -7555,6 +7665,15 @@ static const NMDBusInterfaceInfoExtended interface_info_manager = {
 				),
 				.handle = impl_manager_get_logging,
 			),
+			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
+				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
+					"DumpLogRecorder",
+					.out_args = NM_DEFINE_GDBUS_ARG_INFOS (
+						NM_DEFINE_GDBUS_ARG_INFO ("n_messages", "u"),
+					),
+				),
+				.handle = impl_manager_dump_log_recorder,
+			),
 			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
 				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
 					"CheckConnectivity",
@@ -1212,8 +1212,9 @@ ip_route_add (NMPlatform *platform,
 
 	flags = NM_FLAGS_UNSET (flags, NMP_NLM_FLAG_SUPPRESS_NETLINK_FAILURE);
 
-	/* currently, only replace is implemented. */
-	g_assert (flags == NMP_NLM_FLAG_REPLACE);
+	/* currently, only replace and append are implemented. */
+	g_assert (NM_IN_SET (flags, NMP_NLM_FLAG_REPLACE,
+	                            NMP_NLM_FLAG_APPEND));
 
 	obj = nmp_object_new (addr_family == AF_INET
 	                        ? NMP_OBJECT_TYPE_IP4_ROUTE
@@ -1299,6 +1300,9 @@ ip_route_add (NMPlatform *platform,
 		case NMP_NLM_FLAG_REPLACE:
 			nlmsgflags = NLM_F_REPLACE;
 			break;
+		case NMP_NLM_FLAG_APPEND:
+			nlmsgflags = NLM_F_CREATE | NLM_F_APPEND;
+			break;
 		default:
 			g_assert_not_reached ();
 			break;
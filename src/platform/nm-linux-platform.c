@@ -372,6 +372,11 @@ typedef struct {
 	bool sysctl_get_warned;
 	GHashTable *sysctl_get_prev_values;
 
+	/* ifname -> (path -> value) of the per-interface IP sysctls, as last
+	 * written or read. */
+	GHashTable *sysctl_cache;
+	guint sysctl_cache_n_skipped;
+
 	NMUdevClient *udev_client;
 
 	struct {
@@ -3695,13 +3700,140 @@ _log_dbg_sysctl_set_impl (NMPlatform *platform, const char *pathid, int dirfd, c
 	g_free (contents);
 }
 
+/* logging the old value costs an additional read of the sysctl. Only do
+ * that if the message is actually emitted, not just recorded. */
 #define _log_dbg_sysctl_set(platform, pathid, dirfd, path, value) \
 	G_STMT_START { \
-		if (_LOGD_ENABLED ()) { \
+		if (nm_logging_emit_enabled (LOGL_DEBUG, _NMLOG_DOMAIN)) { \
 			_log_dbg_sysctl_set_impl (platform, pathid, dirfd, path, value); \
 		} \
 	} G_STMT_END
 
+/* A write-through cache for /proc/sys/net/ipv{4,6}/conf/<ifname>/<property>.
+ * Activation writes the same values over and over; writes of a value that
+ * is known to be set already are skipped.
+ *
+ * The entries of an interface live as long as the link. They are dropped
+ * when a link of that name appears, disappears or gets renamed. Other
+ * processes writing these sysctls behind our back go unnoticed until the
+ * value is read again; that is the price for not rewriting every value on
+ * each activation. The IPv6 entries are also dropped when the MTU or the IPv6
+ * settings of the link change: with an MTU below 1280, kernel destroys the
+ * IPv6 configuration of the interface and later recreates it with the
+ * defaults. "mtu" is not cached, because kernel changes it along with the
+ * link MTU. */
+
+#define SYSCTL_CACHE_IP_CONF_PREFIX_LEN NM_STRLEN ("/proc/sys/net/ipv4/conf/")
+
+static gboolean
+_sysctl_cache_parse_path (const char *path, char *ifname /* IFNAMSIZ */)
+{
+	const char *s, *property;
+	gsize len;
+
+	if (   !g_str_has_prefix (path, "/proc/sys/net/ipv4/conf/")
+	    && !g_str_has_prefix (path, "/proc/sys/net/ipv6/conf/"))
+		return FALSE;
+
+	s = &path[SYSCTL_CACHE_IP_CONF_PREFIX_LEN];
+	property = strchr (s, '/');
+	if (!property)
+		return FALSE;
+	len = property - s;
+	property++;
+	if (   len == 0
+	    || len >= IFNAMSIZ
+	    || !property[0]
+	    || strchr (property, '/')
+	    || nm_streq (property, "mtu"))
+		return FALSE;
+
+	memcpy (ifname, s, len);
+	ifname[len] = '\0';
+	return !NM_IN_STRSET (ifname, "all", "default");
+}
+
+static const char *
+_sysctl_cache_lookup (NMPlatform *platform, const char *path)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	char ifname[IFNAMSIZ];
+	GHashTable *values;
+
+	if (   !priv->sysctl_cache
+	    || !_sysctl_cache_parse_path (path, ifname))
+		return NULL;
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	return values ? g_hash_table_lookup (values, path) : NULL;
+}
+
+static void
+_sysctl_cache_update (NMPlatform *platform, const char *path, const char *value)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	char ifname[IFNAMSIZ];
+	GHashTable *values;
+
+	if (!_sysctl_cache_parse_path (path, ifname))
+		return;
+
+	if (!priv->sysctl_cache) {
+		if (!value)
+			return;
+		priv->sysctl_cache = g_hash_table_new_full (nm_str_hash, g_str_equal,
+		                                            g_free, (GDestroyNotify) g_hash_table_unref);
+	}
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	if (!value) {
+		if (values)
+			g_hash_table_remove (values, path);
+		return;
+	}
+	if (!values) {
+		values = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, g_free);
+		g_hash_table_insert (priv->sysctl_cache, g_strdup (ifname), values);
+	}
+	g_hash_table_insert (values, g_strdup (path), g_strdup (value));
+}
+
+static void
+_sysctl_cache_clear_link (NMPlatform *platform, const char *ifname, gboolean ip6_only, const char *reason)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	GHashTable *values;
+	GHashTableIter iter;
+	const char *path;
+	guint n;
+
+	if (   !priv->sysctl_cache
+	    || !ifname
+	    || !ifname[0])
+		return;
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	if (!values)
+		return;
+
+	if (!ip6_only) {
+		n = g_hash_table_size (values);
+		g_hash_table_remove (priv->sysctl_cache, ifname);
+	} else {
+		n = 0;
+		g_hash_table_iter_init (&iter, values);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &path, NULL)) {
+			if (g_str_has_prefix (path, "/proc/sys/net/ipv6/conf/")) {
+				g_hash_table_iter_remove (&iter);
+				n++;
+			}
+		}
+	}
+
+	if (n > 0)
+		_LOGT ("sysctl: drop %u cached values of '%s' (%s)", n, ifname, reason);
+}
+
 static gboolean
 sysctl_set (NMPlatform *platform, const char *pathid, int dirfd, const char *path, const char *value)
 {
@@ -3719,6 +3851,15 @@ sysctl_set (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 	ASSERT_SYSCTL_ARGS (pathid, dirfd, path);
 
 	if (dirfd < 0) {
+		if (nm_streq0 (_sysctl_cache_lookup (platform, path), value)) {
+			NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+			priv->sysctl_cache_n_skipped++;
+			_LOGD ("sysctl: setting '%s' to '%s' skipped, value unchanged (%u writes skipped)",
+			       path, value, priv->sysctl_cache_n_skipped);
+			return TRUE;
+		}
+
 		if (!nm_platform_netns_push (platform, &netns)) {
 			errno = ENETDOWN;
 			return FALSE;
@@ -3804,6 +3945,9 @@ sysctl_set (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 		       path, value);
 	}
 
+	if (dirfd < 0)
+		_sysctl_cache_update (platform, path, nwrote < len - 1 ? NULL : value);
+
 	if (nwrote < len - 1) {
 		if (nm_close (fd) != 0) {
 			if (errsv != 0)
@@ -3874,9 +4018,11 @@ _log_dbg_sysctl_get_impl (NMPlatform *platform, const char *pathid, const char *
 	}
 }
 
+/* the previous values are only remembered while the messages are emitted,
+ * see _nm_logging_clear_platform_logging_cache. */
 #define _log_dbg_sysctl_get(platform, pathid, contents) \
 	G_STMT_START { \
-		if (_LOGD_ENABLED ()) \
+		if (nm_logging_emit_enabled (LOGL_DEBUG, _NMLOG_DOMAIN)) \
 			_log_dbg_sysctl_get_impl (platform, pathid, contents); \
 	} G_STMT_END
 
@@ -3911,6 +4057,9 @@ sysctl_get (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 
 	g_strstrip (contents);
 
+	if (dirfd < 0)
+		_sysctl_cache_update (platform, path, contents);
+
 	_log_dbg_sysctl_get (platform, pathid, contents);
 
 	return contents;
@@ -4448,6 +4597,29 @@ cache_on_change (NMPlatform *platform,
 
 	switch (klass->obj_type) {
 	case NMP_OBJECT_TYPE_LINK:
+		{
+			/* a new, removed or renamed link invalidates the cached sysctls
+			 * of that name. */
+			if (   obj_old
+			    && (   cache_op == NMP_CACHE_OPS_REMOVED
+			        || !nm_streq (obj_old->link.name, obj_new->link.name)))
+				_sysctl_cache_clear_link (platform, obj_old->link.name, FALSE, "link removed or renamed");
+			if (   obj_new
+			    && obj_new->_link.netlink.is_in_netlink
+			    && (   !obj_old
+			        || !obj_old->_link.netlink.is_in_netlink
+			        || !nm_streq (obj_old->link.name, obj_new->link.name)))
+				_sysctl_cache_clear_link (platform, obj_new->link.name, FALSE, "link added or renamed");
+			else if (   obj_old
+			         && obj_new
+			         && (   obj_old->link.mtu != obj_new->link.mtu
+			             || obj_old->link.inet6_addr_gen_mode_inv != obj_new->link.inet6_addr_gen_mode_inv
+			             || memcmp (&obj_old->link.inet6_token, &obj_new->link.inet6_token, sizeof (obj_new->link.inet6_token)) != 0)) {
+				/* the IPv6 configuration of the interface might have been
+				 * recreated with the defaults. */
+				_sysctl_cache_clear_link (platform, obj_new->link.name, TRUE, "MTU or IPv6 changed");
+			}
+		}
 		{
 			/* check whether changing a slave link can cause a master link (bridge or bond) to go up/down */
 			if (   obj_old
@@ -7981,6 +8153,7 @@ finalize (GObject *object)
 		sysctl_clear_cache_list = g_slist_remove (sysctl_clear_cache_list, object);
 		g_hash_table_destroy (priv->sysctl_get_prev_values);
 	}
+	g_clear_pointer (&priv->sysctl_cache, g_hash_table_unref);
 
 	priv->udev_client = nm_udev_client_unref (priv->udev_client);
 
@@ -0,0 +1,160 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2026 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "test-common.h"
+
+#define IFINDEX NMTSTP_ENV1_IFINDEX
+
+/*****************************************************************************/
+
+static NMPObject *
+_ip4_route_new (guint i)
+{
+	NMPlatformIP4Route route = {
+		.ifindex = IFINDEX,
+		.rt_source = NM_IP_CONFIG_SOURCE_USER,
+		.network = htonl (0x0a000000u + (i << 8)),
+		.plen = 24,
+		.metric = 100,
+	};
+
+	return nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &route);
+}
+
+static GPtrArray *
+_ip4_routes_new (guint n_routes)
+{
+	GPtrArray *routes;
+	guint i;
+
+	routes = g_ptr_array_new_full (n_routes, (GDestroyNotify) nmp_object_unref);
+	for (i = 0; i < n_routes; i++)
+		g_ptr_array_add (routes, _ip4_route_new (i));
+	return routes;
+}
+
+static void
+_assert_num_routes (guint n_routes)
+{
+	gs_unref_ptrarray GPtrArray *routes = NULL;
+
+	routes = nmtstp_ip4_route_get_all (NM_PLATFORM_GET, IFINDEX);
+	g_assert_cmpint (routes ? routes->len : 0, ==, n_routes);
+}
+
+/*****************************************************************************/
+
+static void
+test_cache (void)
+{
+	gs_unref_ptrarray GPtrArray *routes = NULL;
+	const guint n_routes = nmtst_benchmark_scale (5000);
+	NMTstBenchmark bench;
+	guint i;
+
+	routes = _ip4_routes_new (n_routes);
+
+	nmtst_benchmark_start (&bench, "platform/cache/ip4-route-insert");
+	for (i = 0; i < n_routes; i++) {
+		g_assert_cmpint (nm_platform_ip_route_add (NM_PLATFORM_GET,
+		                                           NMP_NLM_FLAG_REPLACE,
+		                                           routes->pdata[i]),
+		                 ==,
+		                 NM_PLATFORM_ERROR_SUCCESS);
+	}
+	nmtst_benchmark_end (&bench, n_routes);
+
+	_assert_num_routes (n_routes);
+
+	nmtst_benchmark_start (&bench, "platform/cache/ip4-route-lookup");
+	for (i = 0; i < n_routes; i++)
+		g_assert (nm_platform_lookup_obj (NM_PLATFORM_GET, NMP_CACHE_ID_TYPE_OBJECT_TYPE, routes->pdata[i]));
+	nmtst_benchmark_end (&bench, n_routes);
+
+	nmtst_benchmark_start (&bench, "platform/cache/ip4-route-prune");
+	g_assert (nm_platform_ip_route_flush (NM_PLATFORM_GET, AF_INET, IFINDEX));
+	nmtst_benchmark_end (&bench, n_routes);
+
+	_assert_num_routes (0);
+}
+
+static void
+test_route_sync (void)
+{
+	gs_unref_ptrarray GPtrArray *routes = NULL;
+	const guint n_routes = nmtst_benchmark_scale (5000);
+	NMTstBenchmark bench;
+
+	routes = _ip4_routes_new (n_routes);
+
+	/* the initial sync adds all routes. */
+	nmtst_benchmark_start (&bench, "platform/route-sync/ip4-add");
+	{
+		gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+
+		routes_prune = nm_platform_ip_route_get_prune_list (NM_PLATFORM_GET, AF_INET, IFINDEX, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN);
+		g_assert (nm_platform_ip_route_sync (NM_PLATFORM_GET, AF_INET, IFINDEX, routes, routes_prune, NULL));
+	}
+	nmtst_benchmark_end (&bench, n_routes);
+
+	_assert_num_routes (n_routes);
+
+	/* syncing the same routes again is the common case, where nothing changes. */
+	nmtst_benchmark_start (&bench, "platform/route-sync/ip4-unchanged");
+	{
+		gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+
+		routes_prune = nm_platform_ip_route_get_prune_list (NM_PLATFORM_GET, AF_INET, IFINDEX, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN);
+		g_assert (nm_platform_ip_route_sync (NM_PLATFORM_GET, AF_INET, IFINDEX, routes, routes_prune, NULL));
+	}
+	nmtst_benchmark_end (&bench, n_routes);
+
+	_assert_num_routes (n_routes);
+
+	/* finally, sync an empty list which prunes all routes. */
+	nmtst_benchmark_start (&bench, "platform/route-sync/ip4-prune");
+	{
+		gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+
+		routes_prune = nm_platform_ip_route_get_prune_list (NM_PLATFORM_GET, AF_INET, IFINDEX, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN);
+		g_assert (nm_platform_ip_route_sync (NM_PLATFORM_GET, AF_INET, IFINDEX, NULL, routes_prune, NULL));
+	}
+	nmtst_benchmark_end (&bench, n_routes);
+
+	_assert_num_routes (0);
+}
+
+/*****************************************************************************/
+
+NMTstpSetupFunc const _nmtstp_setup_platform_func = SETUP;
+
+void
+_nmtstp_init_tests (int *argc, char ***argv)
+{
+	nmtst_init_with_logging (argc, argv, "WARN", "ALL");
+}
+
+void
+_nmtstp_setup_tests (void)
+{
+	nmtstp_env1_add_test_func ("/benchmark/platform/cache", test_cache, TRUE);
+	nmtstp_env1_add_test_func ("/benchmark/platform/route-sync", test_route_sync, TRUE);
+}
@@ -2643,6 +2643,65 @@ test_sysctl_rename (void)
 
 /*****************************************************************************/
 
+static void
+test_sysctl_cache (void)
+{
+	NMPlatform *const PL = NM_PLATFORM_GET;
+	const char *const IFNAME = "nm-dummy-0";
+	const char *const PATH = "/proc/sys/net/ipv6/conf/nm-dummy-0/hop_limit";
+	int ifindex;
+	char *v;
+
+	if (_check_sysctl_skip ())
+		return;
+
+	ifindex = nmtstp_link_dummy_add (PL, -1, IFNAME)->ifindex;
+
+	/* writing the same value again is skipped, even if somebody else
+	 * changed it meanwhile. */
+	g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), "42"));
+	nmtstp_run_command_check ("echo 43 > %s", PATH);
+	g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), "42"));
+	v = _get_sysctl_value (PATH);
+	g_assert_cmpstr (v, ==, "43");
+	g_free (v);
+
+	/* the cache lives as long as the link, not only for the main loop
+	 * iteration. */
+	nmtstp_wait_for_signal (PL, 10);
+	g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), "42"));
+	v = _get_sysctl_value (PATH);
+	g_assert_cmpstr (v, ==, "43");
+	g_free (v);
+
+	/* reading the value brings the cache back in sync. */
+	v = nm_platform_sysctl_get (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH));
+	g_assert_cmpstr (v, ==, "43");
+	g_free (v);
+	g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), "42"));
+	v = _get_sysctl_value (PATH);
+	g_assert_cmpstr (v, ==, "42");
+	g_free (v);
+
+	/* with an MTU below 1280, kernel drops the IPv6 configuration of the
+	 * interface and recreates it with the defaults afterwards. The value
+	 * cached before must not be trusted. */
+	g_assert_cmpint (nm_platform_link_set_mtu (PL, ifindex, 1200), ==, NM_PLATFORM_ERROR_SUCCESS);
+	g_assert_cmpint (nm_platform_link_set_mtu (PL, ifindex, 1500), ==, NM_PLATFORM_ERROR_SUCCESS);
+	nm_platform_process_events (PL);
+	v = _get_sysctl_value (PATH);
+	g_assert_cmpstr (v, !=, "42");
+	g_free (v);
+	g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), "42"));
+	v = _get_sysctl_value (PATH);
+	g_assert_cmpstr (v, ==, "42");
+	g_free (v);
+
+	nmtstp_link_del (PL, -1, ifindex, IFNAME);
+}
+
+/*****************************************************************************/
+
 static void
 test_sysctl_netns_switch (void)
 {
@@ -2879,6 +2938,7 @@ _nmtstp_setup_tests (void)
 
 		g_test_add_func ("/general/sysctl/rename", test_sysctl_rename);
 		g_test_add_func ("/general/sysctl/netns-switch", test_sysctl_netns_switch);
+		g_test_add_func ("/general/sysctl/cache", test_sysctl_cache);
 
 		g_test_add_func ("/link/ethtool/features/get", test_ethtool_features_get);
 	}
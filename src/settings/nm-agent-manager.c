@@ -36,6 +36,8 @@
 #include "nm-simple-connection.h"
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
+#include "nm-config.h"
+#include "nm-utils/nm-secret-utils.h"
 #include "c-list/src/c-list.h"
 
 /*****************************************************************************/
@@ -61,6 +63,9 @@ typedef struct {
 
 	CList requests;
 
+	/* secrets returned by agents, indexed by _secrets_cache_key(). */
+	GHashTable *secrets_cache;
+
 	guint64 agent_version_id;
 } NMAgentManagerPrivate;
 
@@ -135,6 +140,12 @@ static void _con_del_request_start (Request *req);
 
 static gboolean _con_get_try_complete_early (Request *req);
 
+static void req_complete (Request *req,
+                          GVariant *secrets,
+                          const char *agent_dbus_owner,
+                          const char *agent_username,
+                          GError *error);
+
 /*****************************************************************************/
 
 guint64
@@ -187,6 +198,13 @@ struct _NMAgentManagerCallId {
 
 	guint idle_id;
 
+	/* Concurrent get requests for the same secrets are merged. Only the
+	 * first request (the leader) asks the agents, the followers wait for
+	 * its result. */
+	Request *leader;
+	CList followers_lst_head;
+	CList follower_lst;
+
 	union {
 		struct {
 			char *path;
@@ -217,6 +235,238 @@ struct _NMAgentManagerCallId {
 
 /*****************************************************************************/
 
+typedef struct {
+	NMAgentManager *self;
+	char *key;
+	char *agent_dbus_owner;
+	char *agent_username;
+	GVariant *secrets;
+	guint timeout_id;
+	bool agent_has_modify:1;
+} SecretsCacheEntry;
+
+static void
+_secrets_cache_entry_free (gpointer user_data)
+{
+	SecretsCacheEntry *entry = user_data;
+
+	nm_clear_g_source (&entry->timeout_id);
+	g_free (entry->key);
+	g_free (entry->agent_dbus_owner);
+	g_free (entry->agent_username);
+	g_variant_unref (entry->secrets);
+	g_slice_free (SecretsCacheEntry, entry);
+}
+
+static gboolean
+_secrets_cache_usable (Request *req)
+{
+	nm_assert (req->request_type == REQUEST_TYPE_CON_GET);
+
+	/* hints ask the agent for specific secrets (e.g. a VPN challenge or
+	 * a one-time code). The answer is not reusable for another request. */
+	return !req->con.get.hints || !req->con.get.hints[0];
+}
+
+static char *
+_secrets_cache_key (Request *req)
+{
+	gint64 uid = -1;
+
+	nm_assert (req->request_type == REQUEST_TYPE_CON_GET);
+
+	if (nm_auth_subject_is_unix_process (req->subject))
+		uid = nm_auth_subject_get_unix_process_uid (req->subject);
+
+	/* REQUEST_NEW only invalidates the cache and is not part of the key.
+	 * The path must stay the last field, see _secrets_cache_remove_path(). */
+	return g_strdup_printf ("%"G_GINT64_FORMAT":%x:%s:%s",
+	                        uid,
+	                        (guint) (req->con.get.flags & ~NM_SECRET_AGENT_GET_SECRETS_FLAG_REQUEST_NEW),
+	                        req->con.get.setting_name,
+	                        req->con.path);
+}
+
+static gboolean
+_secrets_cache_timeout_cb (gpointer user_data)
+{
+	SecretsCacheEntry *entry = user_data;
+	NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (entry->self);
+
+	entry->timeout_id = 0;
+	g_hash_table_remove (priv->secrets_cache, entry->key);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_secrets_cache_remove_path (NMAgentManager *self, const char *path)
+{
+	NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	const char *key;
+
+	if (!priv->secrets_cache)
+		return;
+
+	/* the key ends with the connection path. */
+	g_hash_table_iter_init (&iter, priv->secrets_cache);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &key, NULL)) {
+		const char *s = strrchr (key, ':');
+
+		if (s && nm_streq (&s[1], path))
+			g_hash_table_iter_remove (&iter);
+	}
+}
+
+static void
+_secrets_cache_remove_agent (NMAgentManager *self, const char *agent_dbus_owner)
+{
+	NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	SecretsCacheEntry *entry;
+
+	if (!priv->secrets_cache)
+		return;
+
+	g_hash_table_iter_init (&iter, priv->secrets_cache);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+		if (nm_streq (entry->agent_dbus_owner, agent_dbus_owner))
+			g_hash_table_iter_remove (&iter);
+	}
+}
+
+static void
+has_not_saved_secrets_check (NMSetting *setting,
+                             const char *key,
+                             const GValue *value,
+                             GParamFlags flags,
+                             gpointer user_data)
+{
+	NMSettingSecretFlags secret_flags = NM_SETTING_SECRET_FLAG_NONE;
+	gboolean *has_not_saved = user_data;
+
+	if (!(flags & NM_SETTING_PARAM_SECRET))
+		return;
+
+	if (NM_IS_SETTING_VPN (setting) && nm_streq (key, NM_SETTING_VPN_SECRETS)) {
+		/* VPN secrets might have any flags, we don't know. Just be
+		 * conservative and don't cache them. */
+		*has_not_saved = TRUE;
+		return;
+	}
+
+	if (   nm_setting_get_secret_flags (setting, key, &secret_flags, NULL)
+	    && NM_FLAGS_HAS (secret_flags, NM_SETTING_SECRET_FLAG_NOT_SAVED))
+		*has_not_saved = TRUE;
+}
+
+static void
+_secrets_cache_add (Request *req,
+                    GVariant *secrets,
+                    const char *agent_dbus_owner,
+                    const char *agent_username)
+{
+	NMAgentManager *self = req->self;
+	NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (self);
+	SecretsCacheEntry *entry;
+	NMSetting *setting;
+	gboolean has_not_saved = FALSE;
+	gs_unref_variant GVariant *secrets_normalized = NULL;
+	gs_unref_bytes GBytes *bytes = NULL;
+	gint64 timeout_sec;
+
+	nm_assert (req->request_type == REQUEST_TYPE_CON_GET);
+
+	timeout_sec = nm_config_data_get_value_int64 (NM_CONFIG_GET_DATA,
+	                                              NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                              NM_CONFIG_KEYFILE_KEY_MAIN_AGENT_SECRETS_CACHE_TIMEOUT,
+	                                              10, 0, G_MAXINT32 / 1000, 0);
+	if (timeout_sec <= 0)
+		return;
+
+	if (!_secrets_cache_usable (req))
+		return;
+
+	/* secrets that are marked as not-saved must be requested each time.
+	 * Don't cache them. */
+	setting = nm_connection_get_setting_by_name (req->con.connection, req->con.get.setting_name);
+	if (!setting)
+		return;
+	nm_setting_enumerate_values (setting, has_not_saved_secrets_check, &has_not_saved);
+	if (has_not_saved)
+		return;
+
+	/* keep the secrets in locked memory, so that they are not swapped out. */
+	secrets_normalized = g_variant_get_normal_form (secrets);
+	bytes = nm_secret_copy_to_gbytes_locked (g_variant_get_data (secrets_normalized),
+	                                         g_variant_get_size (secrets_normalized));
+
+	if (!priv->secrets_cache)
+		priv->secrets_cache = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, _secrets_cache_entry_free);
+
+	entry = g_slice_new0 (SecretsCacheEntry);
+	entry->self = self;
+	entry->key = _secrets_cache_key (req);
+	entry->agent_dbus_owner = g_strdup (agent_dbus_owner);
+	entry->agent_username = g_strdup (agent_username);
+	entry->agent_has_modify = req->con.current_has_modify;
+	entry->secrets = g_variant_ref_sink (g_variant_new_from_bytes (g_variant_get_type (secrets_normalized),
+	                                                               bytes,
+	                                                               TRUE));
+	entry->timeout_id = g_timeout_add_seconds (timeout_sec, _secrets_cache_timeout_cb, entry);
+	g_hash_table_replace (priv->secrets_cache, entry->key, entry);
+
+	_LOGT (NULL, "("LOG_REQ_FMT") cache secrets for %"G_GINT64_FORMAT" seconds",
+	       LOG_REQ_ARG (req), timeout_sec);
+}
+
+static gboolean
+_secrets_cache_try_complete (Request *req)
+{
+	NMAgentManager *self = req->self;
+	NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (self);
+	SecretsCacheEntry *entry;
+	gs_free char *key = NULL;
+	gs_unref_variant GVariant *secrets = NULL;
+	gs_free char *agent_username = NULL;
+	gs_free char *agent_dbus_owner = NULL;
+
+	nm_assert (req->request_type == REQUEST_TYPE_CON_GET);
+
+	if (!priv->secrets_cache)
+		return FALSE;
+
+	if (NM_FLAGS_HAS (req->con.get.flags, NM_SECRET_AGENT_GET_SECRETS_FLAG_REQUEST_NEW)) {
+		/* the previous secrets were wrong. Forget them, regardless of
+		 * the flags they were requested with. */
+		_secrets_cache_remove_path (self, req->con.path);
+		return FALSE;
+	}
+
+	if (!_secrets_cache_usable (req))
+		return FALSE;
+
+	key = _secrets_cache_key (req);
+
+	entry = g_hash_table_lookup (priv->secrets_cache, key);
+	if (!entry)
+		return FALSE;
+
+	_LOGD (NULL, "("LOG_REQ_FMT") use cached secrets from agent %s",
+	       LOG_REQ_ARG (req), entry->agent_dbus_owner);
+
+	/* the callback might modify the cache. Take a reference. */
+	secrets = g_variant_ref (entry->secrets);
+	agent_dbus_owner = g_strdup (entry->agent_dbus_owner);
+	agent_username = g_strdup (entry->agent_username);
+	req->con.current_has_modify = entry->agent_has_modify;
+
+	req_complete (req, secrets, agent_dbus_owner, agent_username, NULL);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
 static gboolean
 remove_agent (NMAgentManager *self, const char *owner)
 {
@@ -237,6 +487,8 @@ remove_agent (NMAgentManager *self, const char *owner)
 	c_list_for_each_safe (iter, safe, &priv->requests)
 		request_remove_agent (c_list_entry (iter, Request, lst_request), agent);
 
+	_secrets_cache_remove_agent (self, owner);
+
 	/* And dispose of the agent */
 	g_hash_table_remove (priv->agents, owner);
 	return TRUE;
@@ -525,6 +777,8 @@ request_new (NMAgentManager *self,
 	req->request_type = request_type;
 	req->detail = g_strdup (detail);
 	req->subject = g_object_ref (subject);
+	c_list_init (&req->followers_lst_head);
+	c_list_init (&req->follower_lst);
 	c_list_link_tail (&NM_AGENT_MANAGER_GET_PRIVATE (self)->requests, &req->lst_request);
 	return req;
 }
@@ -532,6 +786,16 @@ request_new (NMAgentManager *self,
 static void
 request_free (Request *req)
 {
+	Request *follower;
+
+	/* followers of a leader that goes away are handled by the caller. Here we
+	 * only detach them. */
+	while ((follower = c_list_first_entry (&req->followers_lst_head, Request, follower_lst))) {
+		c_list_unlink (&follower->follower_lst);
+		follower->leader = NULL;
+	}
+	c_list_unlink (&req->follower_lst);
+
 	switch (req->request_type) {
 	case REQUEST_TYPE_CON_GET:
 	case REQUEST_TYPE_CON_SAVE:
@@ -583,9 +847,27 @@ req_complete_release (Request *req,
                      GError *error)
 {
 	NMAgentManager *self = req->self;
+	CList followers_lst_head;
+	Request *follower;
+	gboolean has_modify = FALSE;
+	gs_unref_variant GVariant *secrets_keep_alive = NULL;
+	gs_free char *agent_dbus_owner_copy = NULL;
+	gs_free char *agent_username_copy = NULL;
+
+	c_list_init (&followers_lst_head);
 
 	switch (req->request_type) {
 	case REQUEST_TYPE_CON_GET:
+		/* take the followers, they get the same result below. */
+		if (!c_list_is_empty (&req->followers_lst_head)) {
+			c_list_splice (&followers_lst_head, &req->followers_lst_head);
+			has_modify = req->con.current_has_modify;
+			if (secrets)
+				secrets_keep_alive = g_variant_ref (secrets);
+			agent_dbus_owner = (agent_dbus_owner_copy = g_strdup (agent_dbus_owner));
+			agent_username = (agent_username_copy = g_strdup (agent_username));
+		}
+
 		req->con.get.callback (self,
 		                       req,
 		                       agent_dbus_owner,
@@ -606,6 +888,17 @@ req_complete_release (Request *req,
 	}
 
 	request_free (req);
+
+	/* The callbacks may cancel other followers, which then unlink themselves from
+	 * the list. */
+	while ((follower = c_list_first_entry (&followers_lst_head, Request, follower_lst))) {
+		c_list_unlink (&follower->follower_lst);
+		follower->leader = NULL;
+		nm_assert (c_list_contains (&NM_AGENT_MANAGER_GET_PRIVATE (self)->requests, &follower->lst_request));
+		c_list_unlink (&follower->lst_request);
+		follower->con.current_has_modify = has_modify;
+		req_complete_release (follower, secrets, agent_dbus_owner, agent_username, error);
+	}
 }
 
 static void
@@ -848,6 +1141,8 @@ request_start (gpointer user_data)
 	case REQUEST_TYPE_CON_GET:
 		if (_con_get_try_complete_early (req))
 			goto out;
+		if (_secrets_cache_try_complete (req))
+			goto out;
 		break;
 	default:
 		break;
@@ -934,6 +1229,7 @@ _con_get_request_done (NMSecretAgent *agent,
 	}
 
 	agent_dbus_owner = nm_secret_agent_get_dbus_owner (agent);
+	_secrets_cache_add (req, secrets, agent_dbus_owner, agent_uname);
 	req_complete (req, secrets, agent_dbus_owner, agent_uname, NULL);
 	g_free (agent_uname);
 }
@@ -1213,6 +1509,56 @@ _con_get_try_complete_early (Request *req)
 	return FALSE;
 }
 
+static gboolean
+_con_get_request_can_merge (Request *req, Request *other)
+{
+	nm_assert (req->request_type == REQUEST_TYPE_CON_GET);
+
+	if (   other == req
+	    || other->request_type != REQUEST_TYPE_CON_GET
+	    || other->leader)
+		return FALSE;
+
+	if (   !nm_streq (other->con.path, req->con.path)
+	    || !nm_streq0 (other->con.get.setting_name, req->con.get.setting_name)
+	    || other->con.get.flags != req->con.get.flags
+	    || !_nm_utils_strv_equal (other->con.get.hints, req->con.get.hints))
+		return FALSE;
+
+	/* the subject determines which agents are asked, and in which order. */
+	if (nm_auth_subject_is_internal (req->subject)) {
+		if (!nm_auth_subject_is_internal (other->subject))
+			return FALSE;
+	} else if (nm_auth_subject_is_unix_process (req->subject)) {
+		if (   !nm_auth_subject_is_unix_process (other->subject)
+		    || nm_auth_subject_get_unix_process_uid (req->subject) != nm_auth_subject_get_unix_process_uid (other->subject)
+		    || nm_auth_subject_get_unix_process_pid (req->subject) != nm_auth_subject_get_unix_process_pid (other->subject))
+			return FALSE;
+	} else
+		return FALSE;
+
+	if (!req->con.get.existing_secrets != !other->con.get.existing_secrets)
+		return FALSE;
+	if (   req->con.get.existing_secrets
+	    && !g_variant_equal (req->con.get.existing_secrets, other->con.get.existing_secrets))
+		return FALSE;
+
+	return TRUE;
+}
+
+static Request *
+_con_get_request_find_leader (NMAgentManager *self, Request *req)
+{
+	NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (self);
+	Request *other;
+
+	c_list_for_each_entry (other, &priv->requests, lst_request) {
+		if (_con_get_request_can_merge (req, other))
+			return other;
+	}
+	return NULL;
+}
+
 /**
  * nm_agent_manager_get_secrets:
  * @self:
@@ -1281,8 +1627,22 @@ nm_agent_manager_get_secrets (NMAgentManager *self,
 	req->con.get.callback_data = callback_data;
 
 	/* Kick off the request */
-	if (!(req->con.get.flags & NM_SECRET_AGENT_GET_SECRETS_FLAG_ONLY_SYSTEM))
+	if (!(req->con.get.flags & NM_SECRET_AGENT_GET_SECRETS_FLAG_ONLY_SYSTEM)) {
+		Request *leader;
+
 		request_add_agents (self, req);
+
+		/* if there is already a request for the same secrets in progress, don't
+		 * ask the agents again. Wait for the result of that request instead. */
+		leader = _con_get_request_find_leader (self, req);
+		if (leader) {
+			_LOGD (NULL, "("LOG_REQ_FMT") wait for the result of pending request %p",
+			       LOG_REQ_ARG (req), leader);
+			req->leader = leader;
+			c_list_link_tail (&leader->followers_lst_head, &req->follower_lst);
+			return req;
+		}
+	}
 	req->idle_id = g_idle_add (request_start, req);
 	return req;
 }
@@ -1297,6 +1657,19 @@ nm_agent_manager_cancel_secrets (NMAgentManager *self,
 
 	nm_assert (c_list_contains (&NM_AGENT_MANAGER_GET_PRIVATE (self)->requests, &request_id->lst_request));
 
+	if (!c_list_is_empty (&request_id->followers_lst_head)) {
+		Request *leader;
+
+		/* the followers are still interested in the secrets. The first one
+		 * takes over and starts asking the agents. */
+		leader = c_list_first_entry (&request_id->followers_lst_head, Request, follower_lst);
+		c_list_unlink (&leader->follower_lst);
+		leader->leader = NULL;
+		c_list_splice (&leader->followers_lst_head, &request_id->followers_lst_head);
+		nm_assert (!leader->idle_id);
+		leader->idle_id = g_idle_add (request_start, leader);
+	}
+
 	c_list_unlink (&request_id->lst_request);
 
 	req_complete_cancel (request_id, FALSE);
@@ -1376,6 +1749,9 @@ nm_agent_manager_save_secrets (NMAgentManager *self,
 	            path,
 	            nm_connection_get_id (connection));
 
+	/* the secrets changed, the cached ones are no longer valid. */
+	_secrets_cache_remove_path (self, path);
+
 	req = request_new (self,
 	                   REQUEST_TYPE_CON_SAVE,
 	                   nm_connection_get_id (connection),
@@ -1442,6 +1818,16 @@ _con_del_request_start (Request *req)
 	}
 }
 
+void
+nm_agent_manager_forget_cached_secrets (NMAgentManager *self,
+                                        const char *path)
+{
+	g_return_if_fail (NM_IS_AGENT_MANAGER (self));
+	g_return_if_fail (path && *path);
+
+	_secrets_cache_remove_path (self, path);
+}
+
 void
 nm_agent_manager_delete_secrets (NMAgentManager *self,
                                  const char *path,
@@ -1460,6 +1846,9 @@ nm_agent_manager_delete_secrets (NMAgentManager *self,
 	            nm_connection_get_id (connection));
 
 	subject = nm_auth_subject_new_internal ();
+	/* the secrets changed, the cached ones are no longer valid. */
+	_secrets_cache_remove_path (self, path);
+
 	req = request_new (self,
 	                   REQUEST_TYPE_CON_DEL,
 	                   nm_connection_get_id (connection),
@@ -1632,6 +2021,8 @@ cancel_more:
 		priv->agents = NULL;
 	}
 
+	g_clear_pointer (&priv->secrets_cache, g_hash_table_destroy);
+
 	if (priv->auth_mgr) {
 		g_signal_handlers_disconnect_by_func (priv->auth_mgr,
 		                                      G_CALLBACK (authority_changed_cb),
@@ -80,6 +80,9 @@ void nm_agent_manager_delete_secrets (NMAgentManager *manager,
                                       const char *path,
                                       NMConnection *connection);
 
+void nm_agent_manager_forget_cached_secrets (NMAgentManager *manager,
+                                             const char *path);
+
 NMSecretAgent *nm_agent_manager_get_agent_by_user (NMAgentManager *manager,
                                                    const char *username);
 
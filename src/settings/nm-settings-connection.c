@@ -81,6 +81,7 @@ enum {
 	REMOVED,
 	UPDATED_INTERNAL,
 	FLAGS_CHANGED,
+	SEEN_BSSID_ADDED,
 	LAST_SIGNAL
 };
 
@@ -108,6 +109,11 @@ typedef struct _NMSettingsConnectionPrivate {
 
 	NMConnection *connection;
 
+	/* An unmodifiable copy of @connection, shared by everybody who needs
+	 * to remember the profile as it is now (like checkpoints). It is
+	 * dropped whenever @connection changes. */
+	NMConnection *connection_snapshot;
+
 	/* Caches secrets from on-disk connections; were they not cached any
 	 * call to nm_connection_clear_secrets() wipes them out and we'd have
 	 * to re-read them from disk which defeats the purpose of having the
@@ -179,6 +185,33 @@ nm_settings_connection_get_connection (NMSettingsConnection *self)
 	return NM_SETTINGS_CONNECTION_GET_PRIVATE (self)->connection;
 }
 
+/**
+ * nm_settings_connection_get_connection_snapshot:
+ * @self: the #NMSettingsConnection
+ *
+ * Returns: (transfer none): a copy of the current connection. The copy
+ *   is cached and shared between all callers until the connection changes,
+ *   so it must never be modified. Take a reference to keep it.
+ */
+NMConnection *
+nm_settings_connection_get_connection_snapshot (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (self), NULL);
+
+	priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	if (!priv->connection_snapshot)
+		priv->connection_snapshot = nm_simple_connection_new_clone (priv->connection);
+	return priv->connection_snapshot;
+}
+
+static void
+connection_snapshot_invalidate_cb (NMConnection *connection, NMSettingsConnection *self)
+{
+	g_clear_object (&NM_SETTINGS_CONNECTION_GET_PRIVATE (self)->connection_snapshot);
+}
+
 /*****************************************************************************/
 
 gboolean
@@ -1801,6 +1834,13 @@ update_auth_cb (NMSettingsConnection *self,
 		                                                       TRUE);
 	}
 
+	if (info->new_settings) {
+		/* secrets cached from agents were requested for the old settings. Drop
+		 * them even if the update fails half-way and no secrets get saved. */
+		nm_agent_manager_forget_cached_secrets (info->agent_mgr,
+		                                        nm_dbus_object_get_path (NM_DBUS_OBJECT (self)));
+	}
+
 	nm_settings_connection_update (self,
 	                               info->new_settings,
 	                               persist_mode,
@@ -2656,6 +2696,8 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 	bssid_str = g_strdup (seen_bssid);
 	g_hash_table_insert (priv->seen_bssids, bssid_str, bssid_str);
 
+	g_signal_emit (self, signals[SEEN_BSSID_ADDED], 0, bssid_str);
+
 	/* Build up a list of all the BSSIDs in string form */
 	n = 0;
 	list = g_malloc0 (g_hash_table_size (priv->seen_bssids) * sizeof (char *));
@@ -3008,6 +3050,11 @@ nm_settings_connection_init (NMSettingsConnection *self)
 
 	g_signal_connect (priv->connection, NM_CONNECTION_SECRETS_CLEARED, G_CALLBACK (secrets_cleared_cb), self);
 	g_signal_connect (priv->connection, NM_CONNECTION_CHANGED, G_CALLBACK (connection_changed_cb), self);
+
+	/* these are never blocked, unlike connection_changed_cb(). */
+	g_signal_connect (priv->connection, NM_CONNECTION_CHANGED, G_CALLBACK (connection_snapshot_invalidate_cb), self);
+	g_signal_connect (priv->connection, NM_CONNECTION_SECRETS_CLEARED, G_CALLBACK (connection_snapshot_invalidate_cb), self);
+	g_signal_connect (priv->connection, NM_CONNECTION_SECRETS_UPDATED, G_CALLBACK (connection_snapshot_invalidate_cb), self);
 }
 
 static void
@@ -3047,11 +3094,13 @@ dispose (GObject *object)
 		 */
 		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (secrets_cleared_cb), self);
 		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (connection_changed_cb), self);
+		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (connection_snapshot_invalidate_cb), self);
 
 		/* FIXME(copy-on-write-connection): avoid modifying NMConnection instances and share them via copy-on-write. */
 		nm_connection_clear_secrets (priv->connection);
 	}
 
+	g_clear_object (&priv->connection_snapshot);
 	g_clear_object (&priv->system_secrets);
 	g_clear_object (&priv->agent_secrets);
 
@@ -3280,4 +3329,13 @@ nm_settings_connection_class_init (NMSettingsConnectionClass *klass)
 	                  0, NULL, NULL,
 	                  g_cclosure_marshal_VOID__VOID,
 	                  G_TYPE_NONE, 0);
+
+	/* internal signal, with an argument (const char *bssid). */
+	signals[SEEN_BSSID_ADDED] =
+	    g_signal_new (NM_SETTINGS_CONNECTION_SEEN_BSSID_ADDED,
+	                  G_TYPE_FROM_CLASS (klass),
+	                  G_SIGNAL_RUN_FIRST,
+	                  0, NULL, NULL,
+	                  g_cclosure_marshal_VOID__STRING,
+	                  G_TYPE_NONE, 1, G_TYPE_STRING);
 }
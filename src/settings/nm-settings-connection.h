@@ -39,6 +39,7 @@
 #define NM_SETTINGS_CONNECTION_CANCEL_SECRETS "cancel-secrets"
 #define NM_SETTINGS_CONNECTION_UPDATED_INTERNAL "updated-internal"
 #define NM_SETTINGS_CONNECTION_FLAGS_CHANGED    "flags-changed"
+#define NM_SETTINGS_CONNECTION_SEEN_BSSID_ADDED "seen-bssid-added"
 
 /* Properties */
 #define NM_SETTINGS_CONNECTION_UNSAVED  "unsaved"
@@ -140,6 +141,7 @@ struct _NMSettingsConnectionClass {
 GType nm_settings_connection_get_type (void);
 
 NMConnection *nm_settings_connection_get_connection (NMSettingsConnection *self);
+NMConnection *nm_settings_connection_get_connection_snapshot (NMSettingsConnection *self);
 
 guint64 nm_settings_connection_get_last_secret_agent_version_id (NMSettingsConnection *self);
 
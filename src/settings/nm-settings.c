@@ -124,6 +124,10 @@ typedef struct {
 	CList connections_lst_head;
 
 	NMSettingsConnection **connections_cached_list;
+
+	/* BSSID => GPtrArray of the NMSettingsConnection that have seen it */
+	GHashTable *seen_bssids_idx;
+
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
 
@@ -296,6 +300,89 @@ nm_settings_get_connection_by_uuid (NMSettings *self, const char *uuid)
 	return NULL;
 }
 
+/**
+ * nm_settings_get_connection_by_seen_bssid:
+ * @self: the #NMSettings
+ * @bssid: the BSSID to look up
+ *
+ * Returns: (transfer none): a Wi-Fi connection that has @bssid in its
+ *   seen BSSIDs list, or %NULL.
+ */
+NMSettingsConnection *
+nm_settings_get_connection_by_seen_bssid (NMSettings *self, const char *bssid)
+{
+	NMSettingsPrivate *priv;
+	GPtrArray *sett_conns;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+	g_return_val_if_fail (bssid != NULL, NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	sett_conns = g_hash_table_lookup (priv->seen_bssids_idx, bssid);
+	if (!sett_conns)
+		return NULL;
+
+	for (i = 0; i < sett_conns->len; i++) {
+		NMSettingsConnection *sett_conn = sett_conns->pdata[i];
+
+		if (nm_connection_get_setting_wireless (nm_settings_connection_get_connection (sett_conn)))
+			return sett_conn;
+	}
+	return NULL;
+}
+
+static void
+_seen_bssids_idx_add (NMSettings *self, NMSettingsConnection *sett_conn, const char *bssid)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	GPtrArray *sett_conns;
+	guint i;
+
+	sett_conns = g_hash_table_lookup (priv->seen_bssids_idx, bssid);
+	if (!sett_conns) {
+		sett_conns = g_ptr_array_new ();
+		g_hash_table_insert (priv->seen_bssids_idx, g_strdup (bssid), sett_conns);
+	} else {
+		for (i = 0; i < sett_conns->len; i++) {
+			if (sett_conns->pdata[i] == sett_conn)
+				return;
+		}
+	}
+	g_ptr_array_add (sett_conns, sett_conn);
+}
+
+static void
+_seen_bssids_idx_add_all (NMSettings *self, NMSettingsConnection *sett_conn)
+{
+	gs_free char **bssids = NULL;
+	guint i;
+
+	bssids = nm_settings_connection_get_seen_bssids (sett_conn);
+	for (i = 0; bssids[i]; i++)
+		_seen_bssids_idx_add (self, sett_conn, bssids[i]);
+}
+
+static void
+_seen_bssids_idx_remove_all (NMSettings *self, NMSettingsConnection *sett_conn)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	gs_free char **bssids = NULL;
+	GPtrArray *sett_conns;
+	guint i;
+
+	bssids = nm_settings_connection_get_seen_bssids (sett_conn);
+	for (i = 0; bssids[i]; i++) {
+		sett_conns = g_hash_table_lookup (priv->seen_bssids_idx, bssids[i]);
+		if (!sett_conns)
+			continue;
+		g_ptr_array_remove (sett_conns, sett_conn);
+		if (!sett_conns->len)
+			g_hash_table_remove (priv->seen_bssids_idx, bssids[i]);
+	}
+}
+
 static void
 impl_settings_get_connection_by_uuid (NMDBusObject *obj,
                                       const NMDBusInterfaceInfoExtended *interface_info,
@@ -789,6 +876,14 @@ connection_flags_changed (NMSettingsConnection *connection,
 	               connection);
 }
 
+static void
+connection_seen_bssid_added (NMSettingsConnection *connection,
+                             const char *bssid,
+                             gpointer user_data)
+{
+	_seen_bssids_idx_add (NM_SETTINGS (user_data), connection, bssid);
+}
+
 static void
 connection_removed (NMSettingsConnection *connection, gpointer user_data)
 {
@@ -817,9 +912,12 @@ connection_removed (NMSettingsConnection *connection, gpointer user_data)
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_removed), self);
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_updated), self);
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_flags_changed), self);
+	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_seen_bssid_added), self);
 	if (!priv->startup_complete)
 		g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_ready_changed), self);
 
+	_seen_bssids_idx_remove_all (self, connection);
+
 	/* Forget about the connection internally */
 	_clear_connections_cached_list (priv);
 	priv->connections_len--;
@@ -936,6 +1034,7 @@ claim_connection (NMSettings *self, NMSettingsConnection *sett_conn)
 
 	/* Read seen-bssids from look-aside file and put it into the connection's data */
 	nm_settings_connection_read_and_fill_seen_bssids (sett_conn);
+	_seen_bssids_idx_add_all (self, sett_conn);
 
 	/* Ensure its initial visibility is up-to-date */
 	nm_settings_connection_recheck_visibility (sett_conn);
@@ -953,6 +1052,9 @@ claim_connection (NMSettings *self, NMSettingsConnection *sett_conn)
 	g_signal_connect (sett_conn, NM_SETTINGS_CONNECTION_FLAGS_CHANGED,
 	                  G_CALLBACK (connection_flags_changed),
 	                  self);
+	g_signal_connect (sett_conn, NM_SETTINGS_CONNECTION_SEEN_BSSID_ADDED,
+	                  G_CALLBACK (connection_seen_bssid_added),
+	                  self);
 	if (!priv->startup_complete) {
 		g_signal_connect (sett_conn, "notify::" NM_SETTINGS_CONNECTION_READY,
 		                  G_CALLBACK (connection_ready_changed),
@@ -1861,6 +1963,7 @@ nm_settings_init (NMSettings *self)
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	c_list_init (&priv->connections_lst_head);
+	priv->seen_bssids_idx = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
 
 	priv->agent_mgr = g_object_ref (nm_agent_manager_get ());
 	priv->config = g_object_ref (nm_config_get ());
@@ -1902,6 +2005,8 @@ finalize (GObject *object)
 
 	nm_assert (c_list_is_empty (&priv->connections_lst_head));
 
+	g_hash_table_unref (priv->seen_bssids_idx);
+
 	g_slist_free_full (priv->unmanaged_specs, g_free);
 	g_slist_free_full (priv->unrecognized_specs, g_free);
 
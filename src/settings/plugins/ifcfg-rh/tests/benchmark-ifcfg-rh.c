@@ -0,0 +1,153 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2026 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-core-internal.h"
+
+#include "settings/plugins/ifcfg-rh/nms-ifcfg-rh-common.h"
+#include "settings/plugins/ifcfg-rh/nms-ifcfg-rh-reader.h"
+#include "settings/plugins/ifcfg-rh/nms-ifcfg-rh-writer.h"
+#include "settings/plugins/ifcfg-rh/nms-ifcfg-rh-utils.h"
+
+#include "nm-test-utils-core.h"
+
+#define TEST_IFCFG_DIR          NM_BUILD_SRCDIR"/src/settings/plugins/ifcfg-rh/tests/network-scripts"
+#define TEST_SCRATCH_DIR        NM_BUILD_BUILDDIR"/src/settings/plugins/ifcfg-rh/tests/network-scripts"
+#define TEST_SCRATCH_DIR_TMP    TEST_SCRATCH_DIR"/tmp-benchmark"
+
+/*****************************************************************************/
+
+typedef struct {
+	const char *name;
+	const char *filename;
+	const char *test_type;
+} BenchmarkFile;
+
+static const BenchmarkFile benchmark_files[] = {
+	{ "wired-static-routes", TEST_IFCFG_DIR"/ifcfg-test-wired-static-routes", TYPE_ETHERNET },
+	{ "wifi-wpa-psk",        TEST_IFCFG_DIR"/ifcfg-test-wifi-wpa-psk",        TYPE_WIRELESS },
+	{ "bond-main",           TEST_IFCFG_DIR"/ifcfg-test-bond-main",           TYPE_ETHERNET },
+};
+
+static NMConnection *
+_connection_from_file (const BenchmarkFile *file)
+{
+	NMConnection *connection;
+	GError *error = NULL;
+
+	connection = nmtst_connection_from_file (file->filename, NULL, file->test_type, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (connection);
+	return connection;
+}
+
+static void
+test_read (gconstpointer user_data)
+{
+	const BenchmarkFile *file = user_data;
+	const guint n_iter = nmtst_benchmark_scale (2000);
+	gs_free char *name = NULL;
+	NMTstBenchmark bench;
+	guint i;
+
+	name = g_strdup_printf ("ifcfg-rh/read/%s", file->name);
+
+	nmtst_benchmark_start (&bench, name);
+	for (i = 0; i < n_iter; i++) {
+		gs_unref_object NMConnection *connection = NULL;
+
+		connection = _connection_from_file (file);
+	}
+	nmtst_benchmark_end (&bench, n_iter);
+}
+
+static void
+test_write (gconstpointer user_data)
+{
+	const BenchmarkFile *file = user_data;
+	const guint n_iter = nmtst_benchmark_scale (1000);
+	gs_unref_object NMConnection *connection = NULL;
+	nmtst_auto_unlinkfile char *testfile = NULL;
+	nmtst_auto_unlinkfile char *keyfile = NULL;
+	nmtst_auto_unlinkfile char *routefile = NULL;
+	nmtst_auto_unlinkfile char *route6file = NULL;
+	gs_free char *name = NULL;
+	NMTstBenchmark bench;
+	GError *error = NULL;
+	gboolean success;
+	guint i;
+
+	connection = _connection_from_file (file);
+	nmtst_connection_normalize (connection);
+
+	/* the first write picks the file name. Measure the rewrites of the
+	 * existing file, like on a connection update. */
+	success = nms_ifcfg_rh_writer_write_connection (connection,
+	                                                TEST_SCRATCH_DIR_TMP,
+	                                                NULL,
+	                                                &testfile,
+	                                                NULL,
+	                                                NULL,
+	                                                &error);
+	nmtst_assert_success (success, error);
+	keyfile = utils_get_keys_path (testfile);
+	routefile = utils_get_route_path (testfile);
+	route6file = utils_get_route6_path (testfile);
+
+	name = g_strdup_printf ("ifcfg-rh/write/%s", file->name);
+
+	nmtst_benchmark_start (&bench, name);
+	for (i = 0; i < n_iter; i++) {
+		success = nms_ifcfg_rh_writer_write_connection (connection,
+		                                                TEST_SCRATCH_DIR_TMP,
+		                                                testfile,
+		                                                NULL,
+		                                                NULL,
+		                                                NULL,
+		                                                &error);
+		nmtst_assert_success (success, error);
+	}
+	nmtst_benchmark_end (&bench, n_iter);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	guint i;
+
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	if (g_mkdir_with_parents (TEST_SCRATCH_DIR_TMP, 0755) != 0)
+		g_error ("failure to create test directory \"%s\": %s", TEST_SCRATCH_DIR_TMP, g_strerror (errno));
+
+	for (i = 0; i < G_N_ELEMENTS (benchmark_files); i++) {
+		gs_free char *path_read = g_strdup_printf ("/benchmark/ifcfg-rh/read/%s", benchmark_files[i].name);
+		gs_free char *path_write = g_strdup_printf ("/benchmark/ifcfg-rh/write/%s", benchmark_files[i].name);
+
+		g_test_add_data_func (path_read, &benchmark_files[i], test_read);
+		g_test_add_data_func (path_write, &benchmark_files[i], test_write);
+	}
+
+	return g_test_run ();
+}
@@ -0,0 +1,249 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2026 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "nm-core-internal.h"
+#include "nm-keyfile-internal.h"
+#include "nm-core-utils.h"
+#include "nm-ip4-config.h"
+#include "platform/nm-platform.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+static NMIP4Config *
+_ip4_config_new_with_routes (NMDedupMultiIndex *multi_idx, guint n_routes)
+{
+	NMIP4Config *config;
+	NMPlatformIP4Route route;
+	guint i;
+
+	config = nm_ip4_config_new (multi_idx, 1);
+
+	for (i = 0; i < n_routes; i++) {
+		route = *nmtst_platform_ip4_route ("0.0.0.0", 24, "192.168.1.1");
+		route.network = htonl (0x0a000000u + (i << 8));
+		route.metric = 100;
+		route.rt_source = NM_IP_CONFIG_SOURCE_USER;
+		nm_ip4_config_add_route (config, &route, NULL);
+	}
+
+	nm_ip4_config_add_nameserver (config, nmtst_inet4_from_string ("4.2.2.1"));
+	nm_ip4_config_add_domain (config, "example.com");
+	nm_ip4_config_add_search (config, "example.org");
+	return config;
+}
+
+static void
+test_ip4_config (void)
+{
+	nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = nm_dedup_multi_index_new ();
+	gs_unref_object NMIP4Config *a = NULL;
+	gs_unref_object NMIP4Config *b = NULL;
+	const guint n_routes = nmtst_benchmark_scale (5000);
+	const guint n_iter = nmtst_benchmark_scale (2000);
+	NMTstBenchmark bench;
+	NMHashState h;
+	guint i;
+
+	/* adding routes to an NMIP4Config is dominated by NMDedupMultiIndex. */
+	nmtst_benchmark_start (&bench, "dedup-multi-index/ip4-config-add-route");
+	a = _ip4_config_new_with_routes (multi_idx, n_routes);
+	nmtst_benchmark_end (&bench, n_routes);
+
+	b = _ip4_config_new_with_routes (multi_idx, n_routes);
+	g_assert_cmpint (nm_ip4_config_get_num_routes (a), ==, n_routes);
+
+	nmtst_benchmark_start (&bench, "ip4-config/equal");
+	for (i = 0; i < n_iter; i++)
+		g_assert (nm_ip4_config_equal (a, b));
+	nmtst_benchmark_end (&bench, n_iter);
+
+	nmtst_benchmark_start (&bench, "ip4-config/hash");
+	for (i = 0; i < n_iter; i++) {
+		nm_hash_init (&h, 1);
+		nm_ip4_config_hash (a, &h, FALSE);
+		(void) nm_hash_complete (&h);
+	}
+	nmtst_benchmark_end (&bench, n_iter);
+}
+
+/*****************************************************************************/
+
+static void
+test_match_spec_device (void)
+{
+	gs_free char *specs_str = NULL;
+	GString *str;
+	GSList *specs;
+	const guint n_specs = 200;
+	const guint n_iter = nmtst_benchmark_scale (20000);
+	NMTstBenchmark bench;
+	guint i;
+
+	str = g_string_new ("type:wifi,driver:veth");
+	for (i = 0; i < n_specs; i++) {
+		g_string_append_printf (str, ",interface-name:eth%u", i);
+		g_string_append_printf (str, ",mac:00:11:22:33:%02x:%02x", i / 256, i % 256);
+	}
+	specs_str = g_string_free (str, FALSE);
+	specs = nm_match_spec_split (specs_str);
+
+	nmtst_benchmark_start (&bench, "match-spec/device");
+	for (i = 0; i < n_iter; i++) {
+		g_assert_cmpint (nm_match_spec_device (specs,
+		                                       "enp0s25",
+		                                       "ethernet",
+		                                       "e1000e",
+		                                       "3.2.6-k",
+		                                       "00:11:22:33:ff:ff",
+		                                       NULL),
+		                 ==,
+		                 NM_MATCH_SPEC_NO_MATCH);
+	}
+	nmtst_benchmark_end (&bench, n_iter);
+
+	g_slist_free_full (specs, g_free);
+}
+
+/*****************************************************************************/
+
+static NMConnection *
+_connection_new (void)
+{
+	NMConnection *connection;
+	NMSetting *s_ip4;
+	NMSetting *s_ip6;
+	NMIPAddress *addr;
+	guint i;
+
+	connection = nmtst_create_minimal_connection ("benchmark", NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+
+	s_ip4 = nm_setting_ip4_config_new ();
+	g_object_set (s_ip4,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_MANUAL,
+	              NULL);
+	for (i = 0; i < 10; i++) {
+		gs_free char *s = g_strdup_printf ("192.168.%u.5", i);
+
+		addr = nm_ip_address_new (AF_INET, s, 24, NULL);
+		nm_setting_ip_config_add_address (NM_SETTING_IP_CONFIG (s_ip4), addr);
+		nm_ip_address_unref (addr);
+	}
+	nm_setting_ip_config_add_dns (NM_SETTING_IP_CONFIG (s_ip4), "8.8.8.8");
+	nm_setting_ip_config_add_dns_search (NM_SETTING_IP_CONFIG (s_ip4), "example.com");
+	nm_connection_add_setting (connection, s_ip4);
+
+	s_ip6 = nm_setting_ip6_config_new ();
+	g_object_set (s_ip6,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP6_CONFIG_METHOD_AUTO,
+	              NULL);
+	nm_connection_add_setting (connection, s_ip6);
+
+	nmtst_connection_normalize (connection);
+	return connection;
+}
+
+static void
+test_connection_dbus (void)
+{
+	gs_unref_object NMConnection *connection = _connection_new ();
+	gs_unref_variant GVariant *dict = NULL;
+	const guint n_iter = nmtst_benchmark_scale (5000);
+	NMTstBenchmark bench;
+	guint i;
+
+	nmtst_benchmark_start (&bench, "connection/to-dbus");
+	for (i = 0; i < n_iter; i++) {
+		GVariant *v;
+
+		v = nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL);
+		g_variant_unref (g_variant_ref_sink (v));
+	}
+	nmtst_benchmark_end (&bench, n_iter);
+
+	dict = g_variant_ref_sink (nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL));
+
+	nmtst_benchmark_start (&bench, "connection/new-from-dbus");
+	for (i = 0; i < n_iter; i++) {
+		gs_unref_object NMConnection *c = NULL;
+		GError *error = NULL;
+
+		c = nm_simple_connection_new_from_dbus (dict, &error);
+		g_assert_no_error (error);
+		g_assert (c);
+	}
+	nmtst_benchmark_end (&bench, n_iter);
+}
+
+static void
+test_keyfile (void)
+{
+	gs_unref_object NMConnection *connection = _connection_new ();
+	gs_unref_keyfile GKeyFile *keyfile = NULL;
+	const guint n_iter = nmtst_benchmark_scale (5000);
+	NMTstBenchmark bench;
+	GError *error = NULL;
+	guint i;
+
+	nmtst_benchmark_start (&bench, "keyfile/write");
+	for (i = 0; i < n_iter; i++) {
+		GKeyFile *kf;
+
+		kf = nm_keyfile_write (connection, NULL, NULL, &error);
+		g_assert_no_error (error);
+		g_key_file_unref (kf);
+	}
+	nmtst_benchmark_end (&bench, n_iter);
+
+	keyfile = nm_keyfile_write (connection, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	nmtst_benchmark_start (&bench, "keyfile/read");
+	for (i = 0; i < n_iter; i++) {
+		gs_unref_object NMConnection *c = NULL;
+
+		c = nm_keyfile_read (keyfile, "/etc/NetworkManager/system-connections/benchmark", NULL, NULL, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (c);
+	}
+	nmtst_benchmark_end (&bench, n_iter);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	g_test_add_func ("/benchmark/ip4-config", test_ip4_config);
+	g_test_add_func ("/benchmark/match-spec-device", test_match_spec_device);
+	g_test_add_func ("/benchmark/connection-dbus", test_connection_dbus);
+	g_test_add_func ("/benchmark/keyfile", test_keyfile);
+
+	return g_test_run ();
+}
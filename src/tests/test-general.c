@@ -28,6 +28,7 @@
 
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
+#include "nm-dispatcher-coalesce.h"
 
 #include "nm-test-utils-core.h"
 
@@ -1845,6 +1846,124 @@ test_nm_utils_exp10 (void)
 
 /*****************************************************************************/
 
+typedef struct {
+	NMDispatcherAction action;
+	gpointer device;
+	NMConnectivityState connectivity_state;
+} CoalesceSent;
+
+typedef struct {
+	GArray *sent;
+	GPtrArray *in_flight;
+} CoalesceTestData;
+
+static gboolean
+_coalesce_test_send (NMDispatcherCoalesce *coalesce,
+                     NMDispatcherAction action,
+                     gpointer device,
+                     NMConnectivityState connectivity_state,
+                     gpointer user_data)
+{
+	CoalesceTestData *data = user_data;
+	CoalesceSent sent = {
+		.action = action,
+		.device = device,
+		.connectivity_state = connectivity_state,
+	};
+
+	g_array_append_val (data->sent, sent);
+	nm_dispatcher_coalesce_set_in_flight (coalesce);
+	g_ptr_array_add (data->in_flight, coalesce);
+	return TRUE;
+}
+
+static void
+_coalesce_test_complete (CoalesceTestData *data, guint idx)
+{
+	NMDispatcherCoalesce *coalesce;
+
+	g_assert_cmpint (idx, <, data->in_flight->len);
+	coalesce = data->in_flight->pdata[idx];
+	g_ptr_array_remove_index (data->in_flight, idx);
+	nm_dispatcher_coalesce_complete (coalesce);
+}
+
+#define _coalesce_assert_sent(data, idx, _action, _device, _connectivity_state) \
+	G_STMT_START { \
+		const CoalesceSent *_sent; \
+		\
+		g_assert_cmpint ((idx), <, (data)->sent->len); \
+		_sent = &g_array_index ((data)->sent, CoalesceSent, (idx)); \
+		g_assert_cmpint (_sent->action, ==, (_action)); \
+		g_assert (_sent->device == (_device)); \
+		g_assert_cmpint (_sent->connectivity_state, ==, (_connectivity_state)); \
+	} G_STMT_END
+
+static void
+test_dispatcher_coalesce (void)
+{
+	gs_unref_object GObject *dev1 = g_object_new (G_TYPE_OBJECT, NULL);
+	gs_unref_object GObject *dev2 = g_object_new (G_TYPE_OBJECT, NULL);
+	NMDispatcherCoalesceQueue *queue;
+	CoalesceTestData data;
+	gboolean coalesced;
+
+	data.sent = g_array_new (FALSE, FALSE, sizeof (CoalesceSent));
+	data.in_flight = g_ptr_array_new ();
+	queue = nm_dispatcher_coalesce_queue_new (_coalesce_test_send, &data);
+
+	/* the first action is sent right away, further ones are coalesced. */
+	g_assert (nm_dispatcher_coalesce_queue_add (queue, NM_DISPATCHER_ACTION_DHCP4_CHANGE, dev1, NM_CONNECTIVITY_UNKNOWN, &coalesced));
+	g_assert (!coalesced);
+	g_assert (nm_dispatcher_coalesce_queue_add (queue, NM_DISPATCHER_ACTION_DHCP4_CHANGE, dev1, NM_CONNECTIVITY_UNKNOWN, &coalesced));
+	g_assert (coalesced);
+	g_assert (nm_dispatcher_coalesce_queue_add (queue, NM_DISPATCHER_ACTION_DHCP4_CHANGE, dev1, NM_CONNECTIVITY_UNKNOWN, &coalesced));
+	g_assert (coalesced);
+	g_assert (nm_dispatcher_coalesce_queue_add (queue, NM_DISPATCHER_ACTION_DHCP4_CHANGE, dev2, NM_CONNECTIVITY_UNKNOWN, &coalesced));
+	g_assert (!coalesced);
+	g_assert (nm_dispatcher_coalesce_queue_add (queue, NM_DISPATCHER_ACTION_DHCP4_CHANGE, dev2, NM_CONNECTIVITY_UNKNOWN, &coalesced));
+	g_assert (coalesced);
+	g_assert_cmpint (data.sent->len, ==, 2);
+	_coalesce_assert_sent (&data, 0, NM_DISPATCHER_ACTION_DHCP4_CHANGE, dev1, NM_CONNECTIVITY_UNKNOWN);
+	_coalesce_assert_sent (&data, 1, NM_DISPATCHER_ACTION_DHCP4_CHANGE, dev2, NM_CONNECTIVITY_UNKNOWN);
+
+	/* a later "down" of dev1 drops its coalesced action, but not the one of dev2. */
+	g_assert_cmpint (nm_dispatcher_coalesce_queue_drop (queue, dev1), ==, 1);
+	g_assert_cmpint (nm_dispatcher_coalesce_queue_drop (queue, dev1), ==, 0);
+
+	_coalesce_test_complete (&data, 0);
+	g_assert_cmpint (data.sent->len, ==, 2);
+	g_assert_cmpint (data.in_flight->len, ==, 1);
+
+	/* the coalesced action of dev2 is sent once, after the pending one. */
+	_coalesce_test_complete (&data, 0);
+	g_assert_cmpint (data.sent->len, ==, 3);
+	_coalesce_assert_sent (&data, 2, NM_DISPATCHER_ACTION_DHCP4_CHANGE, dev2, NM_CONNECTIVITY_UNKNOWN);
+	_coalesce_test_complete (&data, 0);
+	g_assert_cmpint (data.sent->len, ==, 3);
+	g_assert_cmpint (data.in_flight->len, ==, 0);
+
+	/* a coalesced "connectivity-change" is sent with the latest state. */
+	g_assert (nm_dispatcher_coalesce_queue_add (queue, NM_DISPATCHER_ACTION_CONNECTIVITY_CHANGE, NULL, NM_CONNECTIVITY_NONE, &coalesced));
+	g_assert (!coalesced);
+	g_assert (nm_dispatcher_coalesce_queue_add (queue, NM_DISPATCHER_ACTION_CONNECTIVITY_CHANGE, NULL, NM_CONNECTIVITY_PORTAL, &coalesced));
+	g_assert (coalesced);
+	g_assert (nm_dispatcher_coalesce_queue_add (queue, NM_DISPATCHER_ACTION_CONNECTIVITY_CHANGE, NULL, NM_CONNECTIVITY_FULL, &coalesced));
+	g_assert (coalesced);
+	_coalesce_test_complete (&data, 0);
+	g_assert_cmpint (data.sent->len, ==, 5);
+	_coalesce_assert_sent (&data, 3, NM_DISPATCHER_ACTION_CONNECTIVITY_CHANGE, NULL, NM_CONNECTIVITY_NONE);
+	_coalesce_assert_sent (&data, 4, NM_DISPATCHER_ACTION_CONNECTIVITY_CHANGE, NULL, NM_CONNECTIVITY_FULL);
+	_coalesce_test_complete (&data, 0);
+	g_assert_cmpint (data.in_flight->len, ==, 0);
+
+	nm_dispatcher_coalesce_queue_free (queue);
+	g_ptr_array_unref (data.in_flight);
+	g_array_unref (data.sent);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1891,6 +2010,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/stable-id/parse", test_stable_id_parse);
 	g_test_add_func ("/general/stable-id/generated-complete", test_stable_id_generated_complete);
 
+	g_test_add_func ("/general/dispatcher/coalesce", test_dispatcher_coalesce);
+
 	return g_test_run ();
 }
 
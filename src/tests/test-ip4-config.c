@@ -25,6 +25,7 @@
 
 #include "nm-ip4-config.h"
 #include "platform/nm-platform.h"
+#include "platform/nm-fake-platform.h"
 
 #include "nm-test-utils-core.h"
 
@@ -334,6 +335,97 @@ test_strip_search_trailing_dot (void)
 
 /*****************************************************************************/
 
+static NMIP4Config *
+_commit_config_new (int ifindex, guint32 lifetime)
+{
+	NMIP4Config *config;
+	NMPlatformIP4Address addr;
+	NMPlatformIP4Route route;
+
+	config = nm_ip4_config_new (nm_platform_get_multi_idx (NM_PLATFORM_GET), ifindex);
+
+	addr = *nmtst_platform_ip4_address ("192.168.1.10", NULL, 24);
+	addr.timestamp = nm_utils_get_monotonic_timestamp_s ();
+	addr.lifetime = lifetime;
+	addr.preferred = lifetime;
+	nm_ip4_config_add_address (config, &addr);
+
+	route = *nmtst_platform_ip4_route ("192.168.1.0", 24, NULL);
+	route.ifindex = ifindex;
+	route.metric = 100;
+	route.rt_source = NM_IP_CONFIG_SOURCE_USER;
+	nm_ip4_config_add_route (config, &route, NULL);
+
+	route = *nmtst_platform_ip4_route ("10.0.0.0", 8, NULL);
+	route.ifindex = ifindex;
+	route.metric = 100;
+	route.rt_source = NM_IP_CONFIG_SOURCE_USER;
+	nm_ip4_config_add_route (config, &route, NULL);
+
+	return config;
+}
+
+static void
+test_commit_unchanged (void)
+{
+	NMPlatform *platform = NM_PLATFORM_GET;
+	gs_unref_object NMIP4Config *committed = NULL;
+	gs_unref_object NMIP4Config *config = NULL;
+	NMPlatformIP4Route route;
+	gboolean lifetimes_differ;
+	int ifindex;
+
+	g_assert_cmpint (nm_platform_link_dummy_add (platform, "nm-test-commit", NULL), ==, NM_PLATFORM_ERROR_SUCCESS);
+	ifindex = nm_platform_link_get_ifindex (platform, "nm-test-commit");
+	g_assert_cmpint (ifindex, >, 0);
+
+	committed = _commit_config_new (ifindex, 3600);
+	g_assert (nm_ip4_config_commit (committed, platform, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN));
+	g_assert (nm_ip4_config_platform_is_synced (committed, platform, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN));
+
+	/* the same configuration again can skip the commit. */
+	config = nm_ip4_config_clone (committed);
+	g_assert (nm_ip4_config_equal_for_commit (committed, config, &lifetimes_differ));
+	g_assert (!lifetimes_differ);
+	g_clear_object (&config);
+
+	/* a renewed lease only needs the addresses refreshed. */
+	config = _commit_config_new (ifindex, 7200);
+	g_assert (nm_ip4_config_equal_for_commit (committed, config, &lifetimes_differ));
+	g_assert (lifetimes_differ);
+	g_clear_object (&config);
+
+	/* a new route requires a full commit. */
+	config = nm_ip4_config_clone (committed);
+	route = *nmtst_platform_ip4_route ("172.16.0.0", 16, NULL);
+	route.ifindex = ifindex;
+	route.metric = 100;
+	route.rt_source = NM_IP_CONFIG_SOURCE_USER;
+	nm_ip4_config_add_route (config, &route, NULL);
+	g_assert (!nm_ip4_config_equal_for_commit (committed, config, NULL));
+	g_clear_object (&config);
+
+	/* a route removed behind our back invalidates the committed state. */
+	g_assert (nm_platform_object_delete (platform, NMP_OBJECT_UP_CAST (_nmtst_ip4_config_get_route (committed, 1))));
+	g_assert (!nm_ip4_config_platform_is_synced (committed, platform, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN));
+
+	g_assert (nm_ip4_config_commit (committed, platform, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN));
+	g_assert (nm_ip4_config_platform_is_synced (committed, platform, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN));
+
+	/* so does an address added behind our back. */
+	g_assert (nm_platform_ip4_address_add (platform, ifindex,
+	                                       nmtst_inet4_from_string ("192.168.2.10"), 24,
+	                                       nmtst_inet4_from_string ("192.168.2.10"),
+	                                       NM_PLATFORM_LIFETIME_PERMANENT,
+	                                       NM_PLATFORM_LIFETIME_PERMANENT,
+	                                       0, NULL));
+	g_assert (!nm_ip4_config_platform_is_synced (committed, platform, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN));
+
+	g_assert (nm_platform_link_delete (platform, ifindex));
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -341,12 +433,15 @@ main (int argc, char **argv)
 {
 	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
 
+	nm_fake_platform_setup ();
+
 	g_test_add_func ("/ip4-config/subtract", test_subtract);
 	g_test_add_func ("/ip4-config/compare-with-source", test_compare_with_source);
 	g_test_add_func ("/ip4-config/add-address-with-source", test_add_address_with_source);
 	g_test_add_func ("/ip4-config/add-route-with-source", test_add_route_with_source);
 	g_test_add_func ("/ip4-config/merge-subtract-mtu", test_merge_subtract_mtu);
 	g_test_add_func ("/ip4-config/strip-search-trailing-dot", test_strip_search_trailing_dot);
+	g_test_add_func ("/ip4-config/commit-unchanged", test_commit_unchanged);
 
 	return g_test_run ();
 }